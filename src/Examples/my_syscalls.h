@@ -3,5 +3,6 @@
 
 void my_exit();
 void my_putchar(char c);
+int my_getchar();
 
 #endif
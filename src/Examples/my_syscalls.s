@@ -1,7 +1,11 @@
 .global my_exit
 .global my_putchar
+.global my_getchar
 my_exit:
     swi 0x123456
 my_putchar:
 	swi 0x000001
 	mov pc, lr
+my_getchar:
+	swi 0x000002
+	mov pc, lr
@@ -0,0 +1,349 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "access_patterns.h"
+#include "util.h"
+
+/* Strides tracked per instruction, the least counted one being replaced by
+ * a new stride (space saving algorithm, counts may be slightly overestimated)
+ */
+#define STRIDES 4
+
+struct access_pc {
+    uint32_t pc;
+    uint64_t accesses, reads, writes;
+    uint32_t last_address;
+    uint8_t size;
+    int32_t strides[STRIDES];
+    uint64_t stride_counts[STRIDES];
+};
+
+int access_patterns_enabled = 0;
+static uint64_t accesses = 0;
+static struct access_pc *pcs = NULL;
+static uint32_t pcs_size, pcs_used;
+
+/* Reuse distances : each line holds the time of its last access, and a
+ * Fenwick tree over the times marks the last access of each line. The lines
+ * accessed since the previous access to a line are the marks after its time.
+ * When the times run out, the marks are renumbered from 1 in the same order.
+ */
+static uint8_t line_shift, region_shift;
+static uint32_t lines_number, regions_number;
+static uint32_t *last_time = NULL;
+static uint32_t *tree = NULL;
+static uint32_t capacity, now;
+static uint64_t (*histograms)[ACCESS_PATTERNS_BUCKETS + 1] = NULL;
+
+struct line_time {
+    uint32_t time, line;
+};
+
+static char *class_names[] = { "same", "sequential", "strided", "irregular" };
+
+static int log2_of(uint32_t value) {
+    int result = 0;
+
+    if ((value == 0) || (value & (value - 1)))
+        return -1;
+    while (value >>= 1)
+        result++;
+    return result;
+}
+
+int access_patterns_enable(uint32_t memory_size, uint32_t region_size, uint32_t line_size) {
+    int shift;
+
+    if ((shift = log2_of(region_size)) == -1)
+        return -1;
+    region_shift = shift;
+    if ((shift = log2_of(line_size)) == -1)
+        return -1;
+    line_shift = shift;
+    lines_number = (memory_size + line_size - 1) >> line_shift;
+    regions_number = (memory_size + region_size - 1) >> region_shift;
+    /* Renumbering leaves at most lines_number marks */
+    capacity = 4 * lines_number < 1024 ? 1024 : 4 * lines_number;
+    now = 0;
+    last_time = calloc(lines_number, sizeof(uint32_t));
+    tree = calloc(capacity + 1, sizeof(uint32_t));
+    histograms = calloc(regions_number, sizeof(*histograms));
+    pcs_size = 64;
+    pcs_used = 0;
+    pcs = calloc(pcs_size, sizeof(struct access_pc));
+    error_if_null(last_time);
+    error_if_null(tree);
+    error_if_null(histograms);
+    error_if_null(pcs);
+    accesses = 0;
+    access_patterns_enabled = 1;
+    return 0;
+}
+
+void access_patterns_disable() {
+    free(last_time);
+    free(tree);
+    free(histograms);
+    free(pcs);
+    last_time = tree = NULL;
+    histograms = NULL;
+    pcs = NULL;
+    access_patterns_enabled = 0;
+}
+
+static struct access_pc *access_pc_slot(struct access_pc *table, uint32_t size, uint32_t pc) {
+    uint32_t i = ((pc >> 2) * 2654435761u) & (size - 1);
+
+    while (table[i].accesses && (table[i].pc != pc))
+        i = (i + 1) & (size - 1);
+    return &table[i];
+}
+
+static struct access_pc *access_pc_find(uint32_t pc) {
+    struct access_pc *slot, *old;
+    uint32_t i, old_size;
+
+    slot = access_pc_slot(pcs, pcs_size, pc);
+    if (slot->accesses == 0) {
+        if (2 * (pcs_used + 1) > pcs_size) {
+            old = pcs;
+            old_size = pcs_size;
+            pcs_size *= 2;
+            pcs = calloc(pcs_size, sizeof(struct access_pc));
+            error_if_null(pcs);
+            for (i = 0; i < old_size; i++)
+                if (old[i].accesses)
+                    *access_pc_slot(pcs, pcs_size, old[i].pc) = old[i];
+            free(old);
+            slot = access_pc_slot(pcs, pcs_size, pc);
+        }
+        slot->pc = pc;
+        pcs_used++;
+    }
+    return slot;
+}
+
+static void access_pc_stride(struct access_pc *entry, int32_t stride) {
+    int i, least = 0;
+
+    for (i = 0; i < STRIDES; i++) {
+        if (entry->stride_counts[i] && (entry->strides[i] == stride)) {
+            entry->stride_counts[i]++;
+            return;
+        }
+        if (entry->stride_counts[i] < entry->stride_counts[least])
+            least = i;
+    }
+    entry->strides[least] = stride;
+    entry->stride_counts[least]++;
+}
+
+static void tree_add(uint32_t time, int32_t delta) {
+    for (; time <= capacity; time += time & -time)
+        tree[time] += delta;
+}
+
+static uint32_t tree_sum(uint32_t time) {
+    uint32_t sum = 0;
+
+    for (; time > 0; time -= time & -time)
+        sum += tree[time];
+    return sum;
+}
+
+static int by_time(const void *a, const void *b) {
+    const struct line_time *first = a, *second = b;
+
+    return first->time < second->time ? -1 : first->time > second->time;
+}
+
+static void renumber() {
+    struct line_time *marks;
+    uint32_t line, count = 0;
+
+    marks = malloc(lines_number * sizeof(struct line_time));
+    error_if_null(marks);
+    for (line = 0; line < lines_number; line++)
+        if (last_time[line]) {
+            marks[count].time = last_time[line];
+            marks[count].line = line;
+            count++;
+        }
+    qsort(marks, count, sizeof(struct line_time), by_time);
+    memset(tree, 0, (capacity + 1) * sizeof(uint32_t));
+    for (now = 0; now < count; now++) {
+        last_time[marks[now].line] = now + 1;
+        tree_add(now + 1, 1);
+    }
+    free(marks);
+}
+
+static int bucket_of(uint32_t distance) {
+    int bucket = 0;
+
+    while (distance && (bucket < ACCESS_PATTERNS_BUCKETS - 1)) {
+        distance >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+void access_patterns_record(uint32_t pc, uint32_t address, uint8_t size, int write) {
+    struct access_pc *entry;
+    uint32_t line, previous;
+
+    accesses++;
+    entry = access_pc_find(pc);
+    if (entry->accesses)
+        access_pc_stride(entry, (int32_t) (address - entry->last_address));
+    entry->accesses++;
+    if (write)
+        entry->writes++;
+    else
+        entry->reads++;
+    entry->last_address = address;
+    entry->size = size;
+
+    line = address >> line_shift;
+    if (line >= lines_number)
+        return;
+    if (now == capacity)
+        renumber();
+    now++;
+    previous = last_time[line];
+    if (previous) {
+        histograms[address >> region_shift][bucket_of(tree_sum(now - 1) - tree_sum(previous))]++;
+        tree_add(previous, -1);
+    } else {
+        histograms[address >> region_shift][ACCESS_PATTERNS_BUCKETS]++;
+    }
+    tree_add(now, 1);
+    last_time[line] = now;
+}
+
+/* dominant is the index of the most counted stride */
+static int access_pc_class(struct access_pc *entry, int *dominant) {
+    int32_t stride;
+    int i;
+
+    if (entry->accesses < 2)
+        return -1;
+    *dominant = 0;
+    for (i = 1; i < STRIDES; i++)
+        if (entry->stride_counts[i] > entry->stride_counts[*dominant])
+            *dominant = i;
+    stride = entry->strides[*dominant];
+    if (4 * entry->stride_counts[*dominant] < 3 * (entry->accesses - 1))
+        return ACCESS_PATTERNS_IRREGULAR;
+    if (stride == 0)
+        return ACCESS_PATTERNS_SAME;
+    if ((stride == entry->size) || (stride == -entry->size))
+        return ACCESS_PATTERNS_SEQUENTIAL;
+    return ACCESS_PATTERNS_STRIDED;
+}
+
+int access_patterns_stride(uint32_t pc, int32_t *stride) {
+    struct access_pc *entry;
+    int class, dominant;
+
+    if (!access_patterns_enabled)
+        return -1;
+    entry = access_pc_slot(pcs, pcs_size, pc);
+    if ((entry->accesses == 0) || ((class = access_pc_class(entry, &dominant)) == -1))
+        return -1;
+    *stride = entry->strides[dominant];
+    return class;
+}
+
+int access_patterns_reuse(uint32_t address, uint64_t *buckets, uint64_t *cold) {
+    uint32_t region = address >> region_shift;
+
+    if (!access_patterns_enabled || (region >= regions_number))
+        return -1;
+    memcpy(buckets, histograms[region], ACCESS_PATTERNS_BUCKETS * sizeof(uint64_t));
+    *cold = histograms[region][ACCESS_PATTERNS_BUCKETS];
+    return 0;
+}
+
+static int by_accesses(const void *a, const void *b) {
+    const struct access_pc *first = a, *second = b;
+
+    if (first->accesses != second->accesses)
+        return first->accesses < second->accesses ? 1 : -1;
+    return first->pc < second->pc ? -1 : first->pc > second->pc;
+}
+
+void access_patterns_report(FILE *f, int count) {
+    struct access_pc *sorted;
+    uint64_t total;
+    uint32_t i, j, region;
+    int class, dominant, bucket;
+
+    if (!access_patterns_enabled)
+        return;
+    fprintf(f, "Access patterns : %" PRIu64 " data accesses, %u bytes regions, "
+            "%u bytes lines\n", accesses, 1 << region_shift, 1 << line_shift);
+    sorted = malloc((pcs_used + 1) * sizeof(struct access_pc));
+    error_if_null(sorted);
+    for (i = 0, j = 0; i < pcs_size; i++)
+        if (pcs[i].accesses)
+            sorted[j++] = pcs[i];
+    qsort(sorted, pcs_used, sizeof(struct access_pc), by_accesses);
+    if (pcs_used)
+        fprintf(f, "  strides by pc :\n");
+    for (i = 0; (i < pcs_used) && (i < count); i++) {
+        fprintf(f, "    %08X %10" PRIu64 " accesses (%" PRIu64 " reads, %" PRIu64 " writes)",
+                sorted[i].pc, sorted[i].accesses, sorted[i].reads, sorted[i].writes);
+        class = access_pc_class(&sorted[i], &dominant);
+        if (class != -1)
+            fprintf(f, " %s, stride %d in %.0f%%", class_names[class],
+                    sorted[i].strides[dominant],
+                    100.0 * sorted[i].stride_counts[dominant] / (sorted[i].accesses - 1));
+        fprintf(f, "\n");
+    }
+    free(sorted);
+    fprintf(f, "  reuse distances in distinct lines by region :\n");
+    for (region = 0; region < regions_number; region++) {
+        total = histograms[region][ACCESS_PATTERNS_BUCKETS];
+        for (bucket = 0; bucket < ACCESS_PATTERNS_BUCKETS; bucket++)
+            total += histograms[region][bucket];
+        if (total == 0)
+            continue;
+        fprintf(f, "    %08X %10" PRIu64 " accesses, cold %" PRIu64, region << region_shift,
+                total, histograms[region][ACCESS_PATTERNS_BUCKETS]);
+        for (bucket = 0; bucket < ACCESS_PATTERNS_BUCKETS; bucket++) {
+            if (histograms[region][bucket] == 0)
+                continue;
+            if (bucket < 2)
+                fprintf(f, ", %d", bucket);
+            else if (bucket == ACCESS_PATTERNS_BUCKETS - 1)
+                fprintf(f, ", %u+", 1u << (bucket - 1));
+            else
+                fprintf(f, ", %u-%u", 1u << (bucket - 1), (1u << bucket) - 1);
+            fprintf(f, ": %" PRIu64, histograms[region][bucket]);
+        }
+        fprintf(f, "\n");
+    }
+}
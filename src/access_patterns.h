@@ -0,0 +1,75 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __ACCESS_PATTERNS_H__
+#define __ACCESS_PATTERNS_H__
+#include <stdio.h>
+#include <stdint.h>
+
+/* Access pattern analysis of the data accesses (reads and writes, not the
+ * fetches) :
+ * - per load/store PC, the strides between the successive accesses of the
+ *   instruction, which is classified by its dominant stride as same address,
+ *   sequential (stride of the access size, upwards or downwards), strided or,
+ *   when no stride covers three quarters of its accesses, irregular
+ * - per region of memory, the histogram of reuse distances : the number of
+ *   distinct lines accessed between two accesses to the same line, in power
+ *   of two buckets, first accesses to a line being counted as cold
+ * Region and line sizes must be powers of two.
+ */
+#define ACCESS_PATTERNS_SAME 0
+#define ACCESS_PATTERNS_SEQUENTIAL 1
+#define ACCESS_PATTERNS_STRIDED 2
+#define ACCESS_PATTERNS_IRREGULAR 3
+
+/* Bucket 0 holds distance 0, bucket i > 0 distances 2^(i-1) to 2^i - 1, the
+ * last bucket also holds all the longer distances
+ */
+#define ACCESS_PATTERNS_BUCKETS 16
+
+int access_patterns_enable(uint32_t memory_size, uint32_t region_size, uint32_t line_size);
+void access_patterns_disable();
+
+/* To be called on each data access, pc being the accessing instruction. The
+ * analysis is only called when enabled, the test is inline.
+ */
+extern int access_patterns_enabled;
+void access_patterns_record(uint32_t pc, uint32_t address, uint8_t size, int write);
+#define access_patterns_access(pc, address, size, write) \
+    do { if (access_patterns_enabled) \
+             access_patterns_record(pc, address, size, write); } while (0)
+
+/* Class of the instruction at pc and its dominant stride, -1 when it did
+ * not access memory at least twice
+ */
+int access_patterns_stride(uint32_t pc, int32_t *stride);
+/* Reuse distance histogram of the region holding address, cold accesses in
+ * cold, -1 when the address is outside of memory
+ */
+int access_patterns_reuse(uint32_t address, uint64_t *buckets, uint64_t *cold);
+
+/* The count instructions accessing memory the most and the histograms of the
+ * regions accessed
+ */
+void access_patterns_report(FILE * f, int count);
+
+#endif
@@ -35,8 +35,9 @@ int arm_branch(arm_core p, uint32_t ins) {
     // Verification L ( with Link )
     // On met dans LR Le retour à l'instruction suivant PC si L
     if (get_bit(ins,24)){
-        // LR registre 14, adress (PC depart)
-        arm_write_register(p, 14, address );
+        // LR registre 14, adresse de l'instruction suivant le BL : PC lu
+        // (adresse du BL + 8) - 4
+        arm_write_register(p, 14, address - 4);
     }
 
     // recuperation des 24 premiers bits
@@ -27,6 +27,9 @@ Contact: Guillaume.Huard@imag.fr
 #include "arm_exception.h"
 #include "util.h"
 #include "trace.h"
+#include "memory_stats.h"
+#include "access_patterns.h"
+#include "plugin.h"
 #include <stdlib.h>
 
 /* In ARM prior to ARMv6 the endianess is not controlled by the processor but depends on
@@ -49,16 +52,36 @@ arm_core arm_create(registers reg, memory mem) {
         p->mem = mem;
         p->reg = reg;
         p->cycle_count = 0;
+        p->instruction_count = 0;
+        p->current_address = 0;
+        p->current_instruction = 0;
+        p->icache = NULL;
+        p->dcache = NULL;
+        p->watch_handler = NULL;
+        p->watch_data = NULL;
         // We reset the CPU upon creation
-        arm_exception(p, RESET);
-        // Because we don't have any OS, we initialize sp here
-        // This is especially useful for code relying on the stack
-        // such as examples written in C
-        arm_write_register(p, 13, memory_get_size(mem));
+        arm_reset(p);
     }
     return p;
 }
 
+void arm_reset(arm_core p) {
+    uint8_t mode;
+    int i;
+
+    arm_exception(p, RESET);
+    // Registers left by a previous run are cleared, those of a new core
+    // are already null and are not written (nor traced) again
+    mode = registers_get_mode(p->reg);
+    for (i = 0; i < 13; i++)
+        if (registers_read(p->reg, i, mode))
+            arm_write_register(p, i, 0);
+    // Because we don't have any OS, we initialize sp here
+    // This is especially useful for code relying on the stack
+    // such as examples written in C
+    arm_write_register(p, 13, memory_get_size(p->mem));
+}
+
 void arm_destroy(arm_core p) {
     free(p);
 }
@@ -71,10 +94,14 @@ int arm_in_a_privileged_mode(arm_core p) {
     return registers_in_a_privileged_mode(p->reg);
 }
 
-uint32_t arm_get_cycle_count(arm_core p) {
+uint64_t arm_get_cycle_count(arm_core p) {
     return p->cycle_count;
 }
 
+uint64_t arm_get_instruction_count(arm_core p) {
+    return p->instruction_count;
+}
+
 static uint32_t arm_read_register_internal(arm_core p, uint8_t reg, uint8_t mode) {
     uint32_t value = registers_read(p->reg, reg, mode);
     /* In this implementation, the program counter is incremented during the fetch.
@@ -114,6 +141,7 @@ uint32_t arm_read_spsr(arm_core p) {
 static void arm_write_register_internal(arm_core p, uint8_t reg, uint8_t mode, uint32_t value) {
     registers_write(p->reg, reg, mode, value);
     trace_register(p->cycle_count, WRITE, reg, mode, value);
+    plugin_register(p, reg, mode, value);
 }
 
 void arm_write_register(arm_core p, uint8_t reg, uint32_t value) {
@@ -127,18 +155,38 @@ void arm_write_usr_register(arm_core p, uint8_t reg, uint32_t value) {
 void arm_write_cpsr(arm_core p, uint32_t value) {
     registers_write_cpsr(p->reg, value);
     trace_register(p->cycle_count, WRITE, CPSR, 0, value);
+    plugin_register(p, CPSR, 0, value);
 }
 
 void arm_write_spsr(arm_core p, uint32_t value) {
     registers_write_spsr(p->reg, registers_get_mode(p->reg), value);
     trace_register(p->cycle_count, WRITE, SPSR, registers_get_mode(p->reg), value);
+    plugin_register(p, SPSR, registers_get_mode(p->reg), value);
+}
+
+/* Statistics, cache model and watches of every memory access of the core,
+ * the PC of the current instruction owning data accesses
+ */
+static void arm_account_access(arm_core p, uint8_t kind, uint32_t address, uint8_t size) {
+    memory_stats_access(kind, address);
+    if (kind != MEMORY_STATS_FETCH)
+        access_patterns_access(p->current_address, address, size, kind == MEMORY_STATS_WRITE);
+    if ((kind == MEMORY_STATS_FETCH) && p->icache)
+        p->cycle_count += cache_access(p->icache, address, address, CACHE_READ);
+    else if ((kind != MEMORY_STATS_FETCH) && p->dcache)
+        p->cycle_count += cache_access(p->dcache, p->current_address, address,
+                                       kind == MEMORY_STATS_WRITE ? CACHE_WRITE : CACHE_READ);
+    if (p->watch_handler && (kind != MEMORY_STATS_FETCH) && memory_watched(p->mem, address))
+        p->watch_handler(p->watch_data, address, size, kind == MEMORY_STATS_WRITE);
 }
 
 int arm_read_byte(arm_core p, uint32_t address, uint8_t *value) {
     int result;
 
     result = memory_read_byte(p->mem, address, value);
+    arm_account_access(p, MEMORY_STATS_READ, address, 1);
     trace_memory(p->cycle_count, READ, 1, OTHER_ACCESS, address, *value);
+    plugin_memory(p, address, 1, PLUGIN_READ, *value);
     return result;
 }
 
@@ -146,7 +194,9 @@ int arm_read_half(arm_core p, uint32_t address, uint16_t *value) {
     int result;
 
     result = memory_read_half(p->mem, address, value, ENDIANESS);
+    arm_account_access(p, MEMORY_STATS_READ, address, 2);
     trace_memory(p->cycle_count, READ, 2, OTHER_ACCESS, address, *value);
+    plugin_memory(p, address, 2, PLUGIN_READ, *value);
     return result;
 }
 
@@ -154,10 +204,26 @@ int arm_read_word(arm_core p, uint32_t address, uint32_t *value) {
     int result;
 
     result = memory_read_word(p->mem, address, value, ENDIANESS);
+    arm_account_access(p, MEMORY_STATS_READ, address, 4);
     trace_memory(p->cycle_count, READ, 4, OTHER_ACCESS, address, *value);
+    plugin_memory(p, address, 4, PLUGIN_READ, *value);
     return result;
 }
 
+int arm_peek_word(arm_core p, uint32_t address, uint32_t *value) {
+    /* Reports look around arbitrary addresses (the word before a sampled pc),
+     * out of memory they get -1 before any byte is read
+     */
+    if ((address > memory_get_size(p->mem)) || (memory_get_size(p->mem) - address < 4))
+        return -1;
+    return memory_read_word(p->mem, address, value, ENDIANESS);
+}
+
+void arm_set_watch_handler(arm_core p, arm_watch_handler_t handler, void *data) {
+    p->watch_handler = handler;
+    p->watch_data = data;
+}
+
 int arm_fetch(arm_core p, uint32_t *value) {
     //fetches the instruction
     int result = -1;
@@ -172,6 +238,10 @@ int arm_fetch(arm_core p, uint32_t *value) {
     registers_write(p->reg, 15, mode, address + 4);
     result = memory_read_word(p->mem, address, value, ENDIANESS);
     p->cycle_count++;
+    p->instruction_count++;
+    p->current_address = address;
+    p->current_instruction = *value;
+    arm_account_access(p, MEMORY_STATS_FETCH, address, 4);
     trace_memory(p->cycle_count, READ, 4, OPCODE_FETCH, address, *value);
     return result;
 }
@@ -180,7 +250,9 @@ int arm_write_byte(arm_core p, uint32_t address, uint8_t value) {
     int result;
 
     result = memory_write_byte(p->mem, address, value);
+    arm_account_access(p, MEMORY_STATS_WRITE, address, 1);
     trace_memory(p->cycle_count, WRITE, 1, OTHER_ACCESS, address, value);
+    plugin_memory(p, address, 1, PLUGIN_WRITE, value);
     return result;
 }
 
@@ -188,7 +260,9 @@ int arm_write_half(arm_core p, uint32_t address, uint16_t value) {
     int result;
 
     result = memory_write_half(p->mem, address, value, ENDIANESS);
+    arm_account_access(p, MEMORY_STATS_WRITE, address, 2);
     trace_memory(p->cycle_count, WRITE, 2, OTHER_ACCESS, address, value);
+    plugin_memory(p, address, 2, PLUGIN_WRITE, value);
     return result;
 }
 
@@ -196,6 +270,8 @@ int arm_write_word(arm_core p, uint32_t address, uint32_t value) {
     int result;
 
     result = memory_write_word(p->mem, address, value, ENDIANESS);
+    arm_account_access(p, MEMORY_STATS_WRITE, address, 4);
     trace_memory(p->cycle_count, WRITE, 4, OTHER_ACCESS, address, value);
+    plugin_memory(p, address, 4, PLUGIN_WRITE, value);
     return result;
 }
@@ -27,9 +27,24 @@ Contact: Guillaume.Huard@imag.fr
 #include <stdio.h>
 #include "registers.h"
 #include "memory.h"
+#include "cache.h"
+
+/* Called on the data accesses to the pages of memory holding watches (see
+ * memory_add_watch), after the access is made
+ */
+typedef void (*arm_watch_handler_t)(void *data, uint32_t address, uint8_t size, int write);
 
 struct arm_core_data {
-    uint32_t cycle_count;
+    uint64_t cycle_count;
+    uint64_t instruction_count;
+    /* Address and value of the last fetched instruction */
+    uint32_t current_address;
+    uint32_t current_instruction;
+    /* Optional cache models of instruction fetches and data accesses */
+    cache icache;
+    cache dcache;
+    arm_watch_handler_t watch_handler;
+    void *watch_data;
     registers reg;
     memory mem;
 };
@@ -37,11 +52,14 @@ typedef struct arm_core_data *arm_core;
 
 void arm_init();
 arm_core arm_create(registers reg, memory mem);
+/* Takes the reset exception, clears r0-r12 and sets sp to the top of memory */
+void arm_reset(arm_core p);
 void arm_destroy(arm_core p);
 
 int arm_current_mode_has_spsr(arm_core p);
 int arm_in_a_privileged_mode(arm_core p);
-uint32_t arm_get_cycle_count(arm_core p);
+uint64_t arm_get_cycle_count(arm_core p);
+uint64_t arm_get_instruction_count(arm_core p);
 
 uint32_t arm_read_register(arm_core p, uint8_t reg);
 uint32_t arm_read_usr_register(arm_core p, uint8_t reg);
@@ -59,6 +77,12 @@ int arm_read_word(arm_core p, uint32_t address, uint32_t * value);
 int arm_write_byte(arm_core p, uint32_t address, uint8_t value);
 int arm_write_half(arm_core p, uint32_t address, uint16_t value);
 int arm_write_word(arm_core p, uint32_t address, uint32_t value);
+/* Reads memory without accounting nor tracing the access, for reports.
+ * Returns -1 when the word is not entirely in memory.
+ */
+int arm_peek_word(arm_core p, uint32_t address, uint32_t * value);
+
+void arm_set_watch_handler(arm_core p, arm_watch_handler_t handler, void *data);
 
 #include "trace_location.h"
 #endif
@@ -338,35 +338,35 @@ int arm_data_processing_immediate(arm_core p, uint32_t ins)
   {
   case AND:
     result = rn & shifter_operand;
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case EOR:
     result = rn ^ shifter_operand;
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case SUB:
     result = rn - shifter_operand;
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case RSB:
     result = shifter_operand - rn;
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case ADD:
     result = rn + shifter_operand;
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case ADC:
     result = rn + shifter_operand + registers_read_C(p->reg);
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case SBC:
     result = rn - shifter_operand - !registers_read_C(p->reg);
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case RSC:
     result = shifter_operand - rn - !registers_read_C(p->reg);
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case TST:
     result = rn & shifter_operand;
@@ -382,19 +382,19 @@ int arm_data_processing_immediate(arm_core p, uint32_t ins)
     break;
   case ORR:
     result = rn | shifter_operand;
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case MOV:
     result = shifter_operand;
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case BIC:
     result = rn & ~shifter_operand;
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   case MVN:
     result = ~shifter_operand;
-    registers_write(p->reg, rd_code, mode, result);
+    arm_write_register(p, rd_code, result);
     break;
   default:
     return UNDEFINED_INSTRUCTION;
@@ -402,6 +402,7 @@ int arm_data_processing_immediate(arm_core p, uint32_t ins)
   // ---------- END COMPUTE RESULT ----------
 
   // ---------- START WRITE RESULT AND SET FLAGS ----------
+  uint32_t cpsr = registers_read_cpsr(p->reg);
   switch (opcode)
   {
   case TST:
@@ -480,6 +481,13 @@ int arm_data_processing_immediate(arm_core p, uint32_t ins)
       break;
     case MVN:
       registers_write_C(p->reg, shifter_carry_out);
+      break;
+    case TST:
+    case TEQ:
+    case CMP:
+    case CMN:
+      // Flags deja positionnes plus haut
+      break;
     default:
       return UNDEFINED_INSTRUCTION;
     }
@@ -487,12 +495,14 @@ int arm_data_processing_immediate(arm_core p, uint32_t ins)
   // ---------- END WRITE RESULT AND SET FLAGS ----------
 
   // Set CPSR if needed
-  if (s_code == 1 && rd_code == 15)
+  // Le CPSR modifie passe par arm_write_cpsr, pour la trace et les plugins
+  if (s_code == 1 && rd_code == 15 && registers_current_mode_has_spsr(p->reg))
   {
-    if (registers_current_mode_has_spsr(p->reg))
-    {
-      registers_write_cpsr(p->reg, registers_read_spsr(p->reg, mode));
-    }
+    arm_write_cpsr(p, registers_read_spsr(p->reg, mode));
+  }
+  else if (registers_read_cpsr(p->reg) != cpsr)
+  {
+    arm_write_cpsr(p, registers_read_cpsr(p->reg));
   }
 
   return 0;
@@ -23,33 +23,69 @@ Contact: Guillaume.Huard@imag.fr
 #include "arm_exception.h"
 #include "arm_constants.h"
 #include "arm_core.h"
+#include "replay.h"
+#include "host_stats.h"
+#include "plugin.h"
 #include "util.h"
+#include "counters.h"
 
 // Not supported below ARMv6, should read as 0
 #define CP15_reg1_EEbit 0
 #define Exception_bit_9 (CP15_reg1_EEbit << 9)
 
+static uint64_t exceptions[SOFTWARE_INTERRUPT + 1];
+
+void arm_exception_add_counters() {
+    char labels[64], *name, *c;
+    int i;
+
+    for (i = RESET; i <= SOFTWARE_INTERRUPT; i++) {
+        /* Names stop before software interrupts, that send_irq cannot raise */
+        name = arm_get_exception_name(i);
+        snprintf(labels, sizeof(labels), "type=\"%s\"", name ? name : "software interrupt");
+        for (c = labels; *c; c++)
+            if (*c == ' ')
+                *c = '_';
+        counters_add("exceptions", labels, "Exceptions raised by type", COUNTER,
+                     &exceptions[i]);
+    }
+}
+
 int arm_exception(arm_core p, uint8_t exception) {
     uint32_t cpsr = 0x1d3 | Exception_bit_9;
+
+    if (exception <= SOFTWARE_INTERRUPT)
+        exceptions[exception]++;
+    plugin_exception(p, exception);
     /* As there is no operating system in our simulator, we handle
      * software interrupts here :
      * - 0x123456 is the end of the simulation
      * - other opcodes can be used for any custom behavior,
-     *   such as my_putchar given as an example
+     *   such as my_putchar and my_getchar given as examples
      */
     if (exception == SOFTWARE_INTERRUPT) {
         uint32_t value;
+        int activity;
         uint32_t address = arm_read_register(p, 15);
         address -= 8;
         uint32_t instruction;
         arm_read_word(p, address, &instruction);
         instruction &= 0xFFFFFF;
+        plugin_swi(p, instruction);
         switch (instruction) {
         case 0x123456:
             return END_SIMULATION;
         case 0x000001:
             value = arm_read_register(p, 0);
+            activity = host_stats_switch(HOST_STATS_IO);
             putchar(value);
+            host_stats_switch(activity);
+            return 0;
+        case 0x000002:
+            activity = host_stats_switch(HOST_STATS_IO);
+            value = replay_getchar(p);
+            host_stats_switch(activity);
+            arm_write_register(p, 0, value);
             return 0;
         }
     }
@@ -26,5 +26,7 @@ Contact: Guillaume.Huard@imag.fr
 #include "arm_core.h"
 
 int arm_exception(arm_core p, unsigned char exception);
+/* Registers the counters of the exceptions raised, by type */
+void arm_exception_add_counters();
 
 #endif
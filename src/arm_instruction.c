@@ -27,6 +27,15 @@ Contact: Guillaume.Huard@imag.fr
 #include "arm_load_store.h"
 #include "arm_branch_other.h"
 #include "arm_constants.h"
+#include "profiler.h"
+#include "sampler.h"
+#include "instruction_stats.h"
+#include "timing.h"
+#include "pipeline.h"
+#include "branch_predictor.h"
+#include "plugin.h"
+#include "coverage.h"
+#include "self_profile.h"
 #include "util.h"
 
 // verif_cond prend en parametre l'instruction en cours
@@ -141,8 +150,6 @@ static int arm_execute_instruction(arm_core p)
   uint32_t instruction;
   int resultat = arm_fetch(p, &instruction);
 
-  log_printf(">>> READ INSTRUCTION :\n%s\n", to_binary(instruction, 32));
-
   if (resultat)
   {
     // gestion interruption fetch
@@ -154,10 +161,13 @@ static int arm_execute_instruction(arm_core p)
 
   if (cond == 0)
   {
-    fprintf(stderr, "Condition non satisfaite \n");
-    // Gestion interruption conditon non satisfaite
-    //  TODO
-    return UNDEFINED_INSTRUCTION;
+    // Condition non satisfaite : l'instruction ne fait rien
+    instruction_stats_condition_failed(instruction);
+    timing_instruction(p, 0);
+    pipeline_instruction(p, 0);
+    branch_predictor_instruction(p, 0);
+    coverage_instruction(p, 0);
+    return 0;
   }
   if (cond == -1)
   {
@@ -172,18 +182,23 @@ static int arm_execute_instruction(arm_core p)
   switch (code)
   {
   case 0b000: // Data processing immediate shift or register shift
-    printf(" case  data processing \n");
     if (get_bits(instruction, 24, 20) == 0b10000 || get_bits(instruction, 24, 20) == 0b10010 || get_bits(instruction, 24, 20) == 0b10110 || get_bits(instruction, 24, 20) == 0b10100)
     {
+      instruction_stats_count(INSTRUCTION_STATS_MISCELLANEOUS, instruction);
+      self_profile_enter(SELF_PROFILE_MISCELLANEOUS);
       resultat = arm_miscellaneous(p, instruction);
     }
     else if (get_bit(instruction, 4) & get_bit(instruction, 7))
     {
       // case offset
+      instruction_stats_count(INSTRUCTION_STATS_LOAD_STORE, instruction);
+      self_profile_enter(SELF_PROFILE_LOAD_STORE);
       resultat = arm_load_store(p, instruction);
     }
     else
     {
+      instruction_stats_count(INSTRUCTION_STATS_DATA_PROCESSING, instruction);
+      self_profile_enter(SELF_PROFILE_DATA_PROCESSING);
       resultat = arm_data_processing_immediate(p, instruction);
     }
 
@@ -194,10 +209,16 @@ static int arm_execute_instruction(arm_core p)
     {
       if (get_bits(instruction, 21, 20) == 0b10)
       {
+        instruction_stats_count(INSTRUCTION_STATS_MISCELLANEOUS, instruction);
+        self_profile_enter(SELF_PROFILE_MISCELLANEOUS);
         resultat = arm_data_processing_immediate_msr(p, instruction);
       }
       else
+      {
+        instruction_stats_count(INSTRUCTION_STATS_DATA_PROCESSING, instruction);
+        self_profile_enter(SELF_PROFILE_DATA_PROCESSING);
         resultat = arm_data_processing_immediate(p, instruction);
+      }
 
       if (get_bits(instruction, 21, 20) == 0b00)
       {
@@ -210,12 +231,16 @@ static int arm_execute_instruction(arm_core p)
     }
     else
     {
+      instruction_stats_count(INSTRUCTION_STATS_DATA_PROCESSING, instruction);
+      self_profile_enter(SELF_PROFILE_DATA_PROCESSING);
       resultat = arm_data_processing_immediate(p, instruction);
     }
 
     break;
   case 0b010: // Load/store immediate offset
 
+    instruction_stats_count(INSTRUCTION_STATS_LOAD_STORE, instruction);
+    self_profile_enter(SELF_PROFILE_LOAD_STORE);
     resultat = arm_load_store(p, instruction);
     break;
 
@@ -232,20 +257,28 @@ static int arm_execute_instruction(arm_core p)
       resultat = UNDEFINED_INSTRUCTION;
     }
     // Load/store register offset
+    instruction_stats_count(INSTRUCTION_STATS_LOAD_STORE, instruction);
+    self_profile_enter(SELF_PROFILE_LOAD_STORE);
     resultat = arm_load_store(p, instruction);
 
     break;
   case 0b100: // Load/store multiple
 
+    instruction_stats_count(INSTRUCTION_STATS_LOAD_STORE_MULTIPLE, instruction);
+    self_profile_enter(SELF_PROFILE_LOAD_STORE_MULTIPLE);
     resultat = arm_load_store_multiple(p, instruction);
     break;
   case 0b101: // Branch and branch with link
 
+    instruction_stats_count(INSTRUCTION_STATS_BRANCH, instruction);
+    self_profile_enter(SELF_PROFILE_BRANCH);
     resultat = arm_branch(p, instruction);
 
     break;
   case 0b110: // Coprocessor load/store and double register transfers
 
+    instruction_stats_count(INSTRUCTION_STATS_COPROCESSOR, instruction);
+    self_profile_enter(SELF_PROFILE_COPROCESSOR);
     resultat = arm_coprocessor_load_store(p, instruction);
 
     break;
@@ -253,44 +286,54 @@ static int arm_execute_instruction(arm_core p)
 
     if (get_bit(instruction, 24))
     {
+      instruction_stats_count(INSTRUCTION_STATS_SWI, instruction);
       resultat = SOFTWARE_INTERRUPT;
     }
-    if (get_bit(instruction, 4))
+    else if (get_bit(instruction, 4))
     {
       // coprocessor register transfers
+      instruction_stats_count(INSTRUCTION_STATS_COPROCESSOR, instruction);
+      self_profile_enter(SELF_PROFILE_COPROCESSOR);
       resultat = arm_coprocessor_others_swi(p, instruction);
     }
-    // coprocessor Data processing
-    resultat = 0;
+    else
+    {
+      // coprocessor Data processing
+      instruction_stats_count(INSTRUCTION_STATS_COPROCESSOR, instruction);
+      resultat = 0;
+    }
 
     break;
   default: // ne dois jamais arriver
     fprintf(stderr, "<arm_execute_instruction> Erreur default dans switch\n");
     return UNDEFINED_INSTRUCTION;
   }
+  self_profile_leave(SELF_PROFILE_DISPATCH);
 
+  timing_instruction(p, 1);
+  pipeline_instruction(p, 1);
+  branch_predictor_instruction(p, 1);
+  coverage_instruction(p, 1);
   return resultat;
 }
 
 int arm_step(arm_core p)
 {
   int result;
-  printf("step\n");
-  result = arm_execute_instruction(p);
-  //  on affiche la valeur des registres R1 et R2
-
-  printf("R0 = %d\n", arm_read_register(p, 0));
-  printf("R1 = %d\n", arm_read_register(p, 1));
-  printf("R2 = %d\n", arm_read_register(p, 2));
-  printf("R3 = %d\n", arm_read_register(p, 3));
-  printf("pc = %d\n", arm_read_register(p, 15));
-  printf("cpsr = %d\n", arm_read_cpsr(p));
-  printf("spsr = %d\n", arm_read_spsr(p));
-  printf("lr = %d\n", arm_read_register(p, 14));
+  uint64_t cycles = p->cycle_count;
+  int profiled = self_profile_enter(SELF_PROFILE_DISPATCH);
 
+  plugin_basic_block(p);
+  result = arm_execute_instruction(p);
+  plugin_instruction(p);
   if (result)
   {
-    return arm_exception(p, result);
+    self_profile_enter(SELF_PROFILE_EXCEPTION);
+    result = arm_exception(p, result);
+    self_profile_leave(SELF_PROFILE_DISPATCH);
   }
+  profiler_instruction(p, p->cycle_count - cycles);
+  sampler_instruction(p);
+  self_profile_leave(profiled);
   return result;
 }
\ No newline at end of file
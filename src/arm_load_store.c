@@ -27,169 +27,161 @@ Contact: Guillaume.Huard@imag.fr
 #include "util.h"
 #include "debug.h"
 
+// Bit T d'un chargement du PC : le CPSR passe par arm_write_cpsr (trace et
+// plugins), seulement s'il change
+static void arm_write_T(arm_core p, uint8_t value)
+{
+  uint32_t cpsr = registers_read_cpsr(p->reg);
+
+  if (get_bit(cpsr, T) != value)
+    arm_write_cpsr(p, value ? set_bit(cpsr, T) : clr_bit(cpsr, T));
+}
+
+// Offset des modes d'adressage 2 (word/byte, man A5-18) et 3 (halfword et
+// signes, man A5-33)
+static uint32_t load_store_offset(arm_core p, uint32_t ins)
+{
+  if (get_bits(ins, 27, 26) == 0b00)
+  {
+    // Mode 3 : immediat sur 8 bits (bit 22) ou registre
+    if (get_bit(ins, 22))
+      return (get_bits(ins, 11, 8) << 4) | get_bits(ins, 3, 0);
+    return arm_read_register(p, get_bits(ins, 3, 0));
+  }
+  // Mode 2 : immediat sur 12 bits ou registre decale
+  if (!get_bit(ins, 25))
+    return get_bits(ins, 11, 0);
+
+  uint32_t rm = arm_read_register(p, get_bits(ins, 3, 0));
+  uint8_t shift_imm = get_bits(ins, 11, 7);
+
+  switch (get_bits(ins, 6, 5))
+  {
+  case LSL:
+    return rm << shift_imm;
+  case LSR:
+    return shift_imm ? rm >> shift_imm : 0;
+  case ASR:
+    if (shift_imm)
+      return asr(rm, shift_imm);
+    return get_bit(rm, 31) ? 0xFFFFFFFF : 0;
+  default:
+    // ROR, ou RRX quand shift_imm == 0
+    if (shift_imm)
+      return ror(rm, shift_imm);
+    return ((uint32_t)registers_read_C(p->reg) << 31) | (rm >> 1);
+  }
+}
+
 int arm_load_store(arm_core p, uint32_t ins)
 {
 
   // Les positions
-  uint8_t bitI = get_bit(ins, 25);
   uint8_t bitP = get_bit(ins, 24);
   uint8_t bitU = get_bit(ins, 23);
   uint8_t bitB = get_bit(ins, 22);
-  // uint8_t bitW = get_bit(ins, 21);
+  uint8_t bitW = get_bit(ins, 21);
   uint8_t bitL = get_bit(ins, 20);
   uint8_t rn = get_bits(ins, 19, 16);
   uint8_t rd = get_bits(ins, 15, 12);
-  uint8_t endianess = is_big_endian();
-  uint8_t mode = registers_get_mode(p->reg);
-
-  uint32_t address;
 
-  switch (bitL)
+  uint32_t offset = load_store_offset(p, ins);
+  uint32_t base = arm_read_register(p, rn);
+  uint32_t address = bitU ? base + offset : base - offset;
+  // Post indexe : l'acces se fait a l'adresse de base
+  uint32_t target = bitP ? address : base;
+  uint32_t data = 0;
+  uint16_t half;
+  uint8_t byte;
+  int result;
+
+  if (get_bits(ins, 27, 26) == 0b00)
   {
-  // Load instructions
-  case 1:
-    // LDRH
-    if (bitI == 0 && get_bits(ins, 27, 26) == 0b00)
-    {
-      // man P.474
-      int offset = get_bits(ins, 11, 0);
-      uint8_t immedH = get_bits(ins, 11, 8);
-      uint8_t rm = get_bits(ins, 3, 0);
-      offset = (immedH << 4) | rm;
-
-      if (bitP)
-      { // val imm
-        if (bitU)
-        {
-          address = arm_read_register(p, rn) + offset;
-        }
-        else
-        {
-          address = arm_read_register(p, rn) - offset;
-        }
-      }
-      else
-      { // val reg
-        if (bitU)
-        {
-          address = arm_read_register(p, rn) + arm_read_register(p, rm);
-        }
-        else
-        {
-          address = arm_read_register(p, rn) - arm_read_register(p, rm);
-        }
-      }
-      uint16_t data;
-      data = (uint16_t)registers_read(p->reg, rn, mode);
-      arm_write_register(p, rd, data);
-    }
-
-    // LDRB
-    else if (bitB == 1 && get_bits(ins, 27, 26) == 0b01)
+    // LDRH, STRH, LDRSB, LDRSH selon les bits S et H
+    switch (get_bits(ins, 6, 5))
     {
-      address = registers_read(p->reg, rn, mode);
-      uint8_t data;
-      arm_read_byte(p, address, (uint8_t *)&data);
-      if (rd == 15)
+    case 0b01:
+      if (bitL)
       {
-        // PC = data AND 0xFFFFFFFE
-        // T Bit = data[0]
-        registers_write(p->reg, 15, mode, data & 0xFFFFFFFE);
-        registers_write_T(p->reg, get_bit(data, 0));
+        result = arm_read_half(p, target, &half);
+        data = half;
       }
       else
       {
-        // Rd = data
-        // if (rn == 15)
-        // {
-        //   data += 8;
-        //   //  dans le cas ou rn = 15, l'addresse de ma varible  je la connais pas  je sais pas ou est ce
-        //   // le compilateur va la mettre
-        // }
-
-        registers_write(p->reg, rd, mode, data);
-        // on affiche la valeur a l'addrss de rd
-        // int memory_read_word(memory mem, uint32_t address, uint32_t *value, uint8_t be)
-
-        uint32_t val = 0;
-        memory_read_word(p->mem, data, &val, endianess);
-        // printf ("val = %x\n", val);
+        result = arm_write_half(p, target, arm_read_register(p, rd) & 0xFFFF);
       }
+      break;
+    case 0b10:
+      if (!bitL)
+        return UNDEFINED_INSTRUCTION; // LDRD, ARMv5TE
+      result = arm_read_byte(p, target, &byte);
+      data = (int8_t)byte;
+      break;
+    case 0b11:
+      if (!bitL)
+        return UNDEFINED_INSTRUCTION; // STRD, ARMv5TE
+      result = arm_read_half(p, target, &half);
+      data = (int16_t)half;
+      break;
+    default:
+      // SWP et multiplications, non geres ici
+      return UNDEFINED_INSTRUCTION;
     }
-
-    // LDR
-    else if (bitB == 0 && get_bits(ins, 27, 26) == 0b01)
+  }
+  else if (bitB)
+  {
+    // LDRB, STRB
+    if (bitL)
     {
-      // data = Memory[address,4]
-
-      uint32_t data = registers_read(p->reg, rn, mode);
-
-      if (rd == 15)
-      {
-        // PC = data AND 0xFFFFFFFE
-        // T Bit = data[0]
-        registers_write(p->reg, 15, mode, data & 0xFFFFFFFE);
-        registers_write_T(p->reg, get_bit(data, 0));
-      }
-      else
-      {
-        // Rd = data
-        // if (rn == 15)
-        // {
-        //   data += 8;
-        //   //  dans le cas ou rn = 15, l'addresse de ma varible  je la connais pas  je sais pas ou est ce
-        //   // le compilateur va la mettre
-        // }
-
-        // registers_write(p->reg, 15, mode, data & 0xFFFFFFFC);
-        registers_write(p->reg, rd, mode, data);
-        // on affiche la valeur a l'addrss de rd
-        // int memory_read_word(memory mem, uint32_t address, uint32_t *value, uint8_t be)
-
-        uint32_t val = 0;
-        memory_read_word(p->mem, data, &val, endianess);
-        // printf ("val = %x\n", val);
-      }
+      result = arm_read_byte(p, target, &byte);
+      data = byte;
     }
-    break;
-  case 0:
-    // STRH
-    if (bitI == 0 && get_bits(ins, 27, 26) == 0b00)
+    else
     {
-      // Memory[address,2] = Rd[15:0]
-      address = arm_read_register(p, rn);
-      uint16_t data = arm_read_register(p, rd) & 0xFFFF;
-      arm_write_half(p, address, data & 0xFFFF);
+      result = arm_write_byte(p, target, arm_read_register(p, rd) & 0xFF);
     }
-
-    // STRB
-    else if (bitB == 1 && get_bits(ins, 27, 26) == 0b01)
+  }
+  else
+  {
+    // LDR, STR (man A4-43 : un LDR non aligne fait une rotation du mot)
+    if (bitL)
     {
-      // Memory[address,1] = Rd[7:0]
-      address = arm_read_register(p, rn);
-      uint8_t data = arm_read_register(p, rd) & 0xFF;
-      arm_write_byte(p, address, data & 0xFF);
+      result = arm_read_word(p, target & 0xFFFFFFFC, &data);
+      if (target & 3)
+        data = ror(data, 8 * (target & 3));
     }
-
-    // STR
-    else if (bitB == 0 && get_bits(ins, 27, 26) == 0b01)
+    else
     {
-      // Memory[address,4] = Rd
-      address = arm_read_register(p, rn);
-      uint32_t data = arm_read_register(p, rd);
-      arm_write_word(p, address, data);
+      result = arm_write_word(p, target, arm_read_register(p, rd));
     }
-    break;
-  default:
-    fprintf(stderr, "Erreur ! Le bit L n'est pas à 0 ou 1.\n");
-    return UNDEFINED_INSTRUCTION;
   }
-  return UNDEFINED_INSTRUCTION;
+  if (result)
+    return DATA_ABORT;
+
+  // Ecriture de l'adresse dans Rn (post indexe ou bit W), avant Rd qui
+  // l'emporte si Rd == Rn
+  if (!bitP || bitW)
+    arm_write_register(p, rn, address);
+  if (bitL)
+  {
+    if (rd == 15)
+    {
+      // PC = data AND 0xFFFFFFFE
+      // T Bit = data[0]
+      arm_write_register(p, 15, data & 0xFFFFFFFE);
+      arm_write_T(p, get_bit(data, 0));
+    }
+    else
+    {
+      arm_write_register(p, rd, data);
+    }
+  }
+  return 0;
 }
 
 int number_registers(uint16_t register_list)
 {
-  int compteur;
+  int compteur = 0;
   for (int i = 0; i < 16; i++)
   {
     if ((register_list & (1 << i)) != 0)
@@ -198,9 +190,10 @@ int number_registers(uint16_t register_list)
   return compteur;
 }
 
-// LDM et STM info plus générale page 134.
-// LDM(1) (apparement c'est lui qu'il faut faire) page 186 du manuel.
-// STM(1) page 339 du Manuel.
+// LDM et STM info plus gnrale page 134.
+// LDM(1) page 186 du manuel, STM(1) page 339.
+// Mode d'adressage 4 (man A5-48) : les registres sont transferes dans l'ordre
+// croissant, le plus petit a l'adresse la plus basse, quel que soit le sens.
 int arm_load_store_multiple(arm_core p, uint32_t ins)
 {
 
@@ -213,10 +206,8 @@ int arm_load_store_multiple(arm_core p, uint32_t ins)
   uint8_t rn = get_bits(ins, 19, 16);
   uint16_t register_list = get_bits(ins, 15, 0);
 
-  // uint8_t endianess = is_big_endian();
-  // uint8_t mode = registers_get_mode(p->reg);
-
-  uint32_t address = registers_read(p->reg, rn, registers_get_mode(p->reg));
+  uint32_t base = arm_read_register(p, rn);
+  uint32_t address, new_base, data[16];
 
   int nbr_register_list = number_registers(register_list);
 
@@ -228,44 +219,60 @@ int arm_load_store_multiple(arm_core p, uint32_t ins)
 
   if (S != 0)
   {
-    fprintf(stderr, "<arm_load_store.c> Erreur le bit S n'est pas à 0.\n");
+    fprintf(stderr, "<arm_load_store.c> Erreur le bit S n'est pas  0.\n");
     return UNDEFINED_INSTRUCTION;
   }
+
+  // start_address : IA = Rn, IB = Rn + 4, DA = Rn - 4 * n + 4, DB = Rn - 4 * n
+  if (U)
+  {
+    new_base = base + 4 * nbr_register_list;
+    address = P ? base + 4 : base;
+  }
+  else
+  {
+    new_base = base - 4 * nbr_register_list;
+    address = P ? new_base : new_base + 4;
+  }
+
+  // En cas de data abort, ni Rn ni les registres ne sont modifies, pour que
+  // le gestionnaire puisse relancer l'instruction : les mots sont tous lus
+  // (ou ranges) avant la mise a jour des registres
   for (int i = 0; i < 16; i++)
   {
     if ((register_list & (1 << i)) != 0)
     {
-      if (P == 1)
-      {
-        if (U == 0) // decremente BEFORE
-          address -= 4;
-        else // incremente BEFORE
-          address += 4;
-      }
       if (!L)
       { // STM(1)
-        uint32_t data;
-        arm_read_word(p, i, &data);
-        arm_write_word(p, address, data);
+        if (arm_write_word(p, address, arm_read_register(p, i)))
+          return DATA_ABORT;
       }
       else
       { // LDM(1)
-        uint32_t data;
-        arm_read_word(p, address, &data);
-        arm_write_word(p, i, data);
-      }
-      if (P == 0)
-      {
-        if (U == 0) // decremente AFTER
-          address -= 4;
-        else // incremente AFTER
-          address += 4;
+        if (arm_read_word(p, address, &data[i]))
+          return DATA_ABORT;
       }
+      address += 4;
     }
   }
-  if (W == 1)
+  // Pour STM, Rn dans la liste est range avec sa valeur d'origine
+  // Pour LDM, la valeur chargee l'emporte si Rn est dans la liste
+  if (W)
+    arm_write_register(p, rn, new_base);
+  if (L)
   {
-    arm_write_register(p, rn, address); // address sera déjà à la bonne valeur normalement (address +/- 4 * nbr_register_list)
+    for (int i = 0; i < 15; i++)
+    {
+      if ((register_list & (1 << i)) != 0)
+        arm_write_register(p, i, data[i]);
+    }
+    if ((register_list & (1 << 15)) != 0)
+    {
+      // PC = data AND 0xFFFFFFFE
+      // T Bit = data[0]
+      arm_write_register(p, 15, data[15] & 0xFFFFFFFE);
+      arm_write_T(p, get_bit(data[15], 0));
+    }
   }
   return 0;
 }
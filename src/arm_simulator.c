@@ -22,6 +22,7 @@ Contact: Guillaume.Huard@imag.fr
 */
 #include <sys/socket.h>
 #include <pthread.h>
+#include <signal.h>
 #include <getopt.h>
 #include "csapp.h"
 #include "scanner.h"
@@ -29,6 +30,21 @@ Contact: Guillaume.Huard@imag.fr
 #include "memory.h"
 #include "gdb_protocol.h"
 #include "trace.h"
+#include "replay.h"
+#include "memory_stats.h"
+#include "profiler.h"
+#include "sampler.h"
+#include "counters.h"
+#include "instruction_stats.h"
+#include "timing.h"
+#include "pipeline.h"
+#include "branch_predictor.h"
+#include "host_stats.h"
+#include "plugin.h"
+#include "coverage.h"
+#include "access_patterns.h"
+#include "self_profile.h"
+#include "metrics.h"
 #include "debug.h"
 
 struct shared_data {
@@ -37,8 +53,14 @@ struct shared_data {
     arm_core arm;
     pthread_mutex_t lock;
     in_port_t gdb_port, irq_port;
+    char *memory_stats_file;
+    char *counters_file;
+    int host_stats;
+    sigset_t signals;
 };
 
+static uint64_t irqs_received = 0;
+
 struct server_data {
     int socket;
     unsigned short port;
@@ -98,6 +120,8 @@ static void *irq_listener(void *arg) {
         connection = Accept(server.socket, (struct sockaddr *) &peer, &peer_length);
         while (Read(connection, &irq, 1) > 0) {
             pthread_mutex_lock(&shared->lock);
+            irqs_received++;
+            replay_record_irq(shared->arm, irq);
             arm_exception(shared->arm, irq);
             pthread_mutex_unlock(&shared->lock);
         }
@@ -108,11 +132,176 @@ static void *irq_listener(void *arg) {
     pthread_exit(NULL);
 }
 
+static void dump_memory_stats(char *filename) {
+    char *extension;
+    FILE *f;
+
+    f = fopen(filename, "w");
+    if (f == NULL) {
+        perror("Memory statistics file");
+        return;
+    }
+    extension = rindex(filename, '.');
+    if (extension && (strcmp(extension, ".json") == 0))
+        memory_stats_dump(f, MEMORY_STATS_JSON);
+    else
+        memory_stats_dump(f, MEMORY_STATS_CSV);
+    fclose(f);
+}
+
+static void dump_profile(char *output_filename, char *folded_filename) {
+    FILE *f;
+
+    f = output_filename ? fopen(output_filename, "w") : stderr;
+    if (f == NULL) {
+        perror("Profile file");
+    } else {
+        profiler_report(f);
+        if (f != stderr)
+            fclose(f);
+    }
+    if (folded_filename) {
+        f = fopen(folded_filename, "w");
+        if (f == NULL) {
+            perror("Folded stacks file");
+            return;
+        }
+        profiler_folded(f);
+        fclose(f);
+    }
+}
+
+static void dump_samples(arm_core arm, char *output_filename, char *elf_filename) {
+    elf_reader elf = NULL;
+    FILE *f;
+
+    f = output_filename ? fopen(output_filename, "w") : stderr;
+    if (f == NULL) {
+        perror("Samples file");
+        return;
+    }
+    if (elf_filename && ((elf = elf_reader_open(elf_filename)) == NULL))
+        fprintf(stderr, "Cannot read the symbols of %s\n", elf_filename);
+    sampler_report(f, arm, elf, 20);
+    if (elf)
+        elf_reader_close(elf);
+    if (f != stderr)
+        fclose(f);
+}
+
+static void dump_coverage(char *filename, char *lcov, char *elf_file) {
+    elf_reader elf;
+    FILE *f;
+
+    if (filename && (coverage_write(filename) == -1))
+        perror("Coverage file");
+    if (lcov == NULL)
+        return;
+    elf = elf_reader_open(elf_file);
+    if (elf == NULL)
+        return;
+    f = fopen(lcov, "w");
+    if (f == NULL) {
+        perror("Coverage lcov file");
+    } else {
+        coverage_write_lcov(f, elf, elf_file);
+        fclose(f);
+    }
+    elf_reader_close(elf);
+}
+
+static void dump_access_patterns(char *filename) {
+    FILE *f;
+
+    f = fopen(filename, "w");
+    if (f == NULL) {
+        perror("Access patterns file");
+        return;
+    }
+    access_patterns_report(f, 20);
+    fclose(f);
+}
+
+static void dump_counters(char *filename) {
+    FILE *f;
+
+    f = fopen(filename, "w");
+    if (f == NULL) {
+        perror("Counters file");
+        return;
+    }
+    counters_dump(f);
+    fclose(f);
+}
+
+/* On demand reports : SIGUSR1 dumps the memory statistics and the counters,
+ * and writes the host statistics to stderr
+ */
+static void *signal_listener(void *arg) {
+    struct shared_data *shared = (struct shared_data *) arg;
+    int signal;
+
+    while (sigwait(&shared->signals, &signal) == 0) {
+        if (shared->memory_stats_file)
+            dump_memory_stats(shared->memory_stats_file);
+        if (shared->counters_file)
+            dump_counters(shared->counters_file);
+        if (shared->host_stats)
+            host_stats_report(stderr, arm_get_instruction_count(shared->arm));
+    }
+    pthread_exit(NULL);
+}
+
+struct host_stats_data {
+    struct shared_data *shared;
+    unsigned int interval;
+};
+
+/* Periodic host statistics, ends with the process */
+static void *host_stats_reporter(void *arg) {
+    struct host_stats_data *data = (struct host_stats_data *) arg;
+
+    while (1) {
+        sleep(data->interval);
+        host_stats_report(stderr, arm_get_instruction_count(data->shared->arm));
+    }
+    pthread_exit(NULL);
+}
+
+/* Replays a recorded run without gdb nor irq connections, the run ends where
+ * the recording ended or when the program ends the simulation
+ */
+static void replay_run(struct shared_data *shared) {
+    int exception = 0;
+
+    host_stats_switch(HOST_STATS_EXECUTION);
+    while (!replay_inject(shared->arm) && (exception != END_SIMULATION)) {
+        exception = arm_step(shared->arm);
+        trace_arm_state(shared->reg);
+        trace_keyframe(arm_get_cycle_count(shared->arm), shared->reg);
+    }
+    host_stats_switch(HOST_STATS_IDLE);
+    fprintf(stderr, "Replay ended after %lu instructions\n",
+            (unsigned long) arm_get_instruction_count(shared->arm));
+}
+
 void usage(char *name) {
     fprintf(stderr, "Usage:\n"
             "%s [ --help ] [ --gdb-port port ] [ --irq-port port ] "
             "[ --trace-file file ] [ --trace-registers ] [ --trace-memory ] "
-            "[ --trace-state ] [ --trace-position ] [ --debug filename ]\n\n"
+            "[ --trace-state mode ] [ --trace-state-delta records ] "
+            "[ --trace-position ] [ --trace-keyframes cycles ] "
+            "[ --record file | --replay file ] [ --memory-stats file ] "
+            "[ --memory-stats-page size ] [ --memory-stats-line size ] "
+            "[ --profile elf_file ] [ --profile-output file ] "
+            "[ --profile-folded file ] [ --sample interval ] [ --sample-elf elf_file ] "
+            "[ --sample-output file ] [ --counters file ] [ --timing table ] "
+            "[ --pipeline ] [ --icache configuration ] [ --dcache configuration ] "
+            "[ --branch-predictor model ] [ --host-stats seconds ] "
+            "[ --plugin file[:arguments] ] [ --coverage file ] "
+            "[ --coverage-lcov file --coverage-elf elf_file ] [ --access-patterns file ] "
+            "[ --access-patterns-region size ] [ --metrics endpoint ] "
+            "[ --metrics-interval seconds ] [ --debug filename ]\n\n"
             "Start an ARMv5 instruction set simulator that acts as a gdb server "
             "and can receive interrupts. It is possible to specify on which ports "
             "the simulator listen to gdb client or irq sending program "
@@ -123,8 +312,88 @@ void usage(char *name) {
             " registers\n"
             "- trace memory: outputs informations about each access to memory\n"
             "- trace state: outputs the processor state after each instruction\n"
+            "- trace state delta: only one state record out of the given number"
+            " is a full snapshot, the others only contain the registers that"
+            " changed, on lines starting with the mode name followed by '~'\n"
             "- trace position: for each traced access, outputs the file and line"
             " at which the access has been performed\n"
+            "- trace keyframes: every given number of cycles, outputs the full"
+            " register state and, when the trace is a regular file, ends it with"
+            " an index of these keyframes (see trace_seek)\n"
+            "The record switch logs every irq, gdb register or memory write and"
+            " console input along with the number of instructions executed when"
+            " it took effect. The replay switch reruns such a log without gdb nor"
+            " irq connections.\n"
+            "The memory stats switch counts fetches, reads and writes per page (4096"
+            " bytes by default) and per line when a line size is given. They are"
+            " written at exit or when receiving SIGUSR1, in JSON when the file"
+            " name ends with .json and in CSV otherwise.\n"
+            "The profile switch takes the ELF file of the simulated program and"
+            " counts instructions and cycles per function of its symbol table,"
+            " following calls and returns. At exit, the flat profile and the call"
+            " graph are written to the profile output (default is stderr) and the"
+            " folded stacks, for flamegraph tools, to the profile folded file.\n"
+            "The sample switch records the address of one instruction out of the"
+            " given number. At exit, the hottest addresses and basic blocks are"
+            " written, disassembled, to the sample output (default is stderr),"
+            " with the symbols of the sample ELF file when given.\n"
+            "The counters switch enables the instruction mix counters (per data"
+            " processing opcode, load/store variant, load/store multiple register"
+            " count, branch outcome, condition failed and software interrupt"
+            " number). All the counters are written at exit or when receiving"
+            " SIGUSR1, one \"name{labels} value\" per line.\n"
+            "The timing switch selects the cycle costs of the instructions: flat"
+            " (one cycle each), arm9e (the default, with multi-cycle transfers,"
+            " load latency, refills on PC writes and an early terminating"
+            " multiplier) or a file of \"name cycles\" lines overriding arm9e"
+            " costs (see timing.c for the names).\n"
+            "The pipeline switch adds the stalls of an ARM9 like pipeline: load"
+            " latencies are only charged when the next instruction uses the"
+            " loaded register, flags set by multiplies are late. Stalls are"
+            " counted by cause (load_use, flags, pc_write) and written to stderr"
+            " at exit.\n"
+            "The icache and dcache switches add cache models on instruction"
+            " fetches and data accesses, misses adding a penalty to the cycle"
+            " count. The configuration is a comma separated list among size=bytes,"
+            " ways=number, line=bytes, write=back|through, replace=lru|fifo|random"
+            " and penalty=cycles (default is size=16k,ways=4,line=32,write=back,"
+            "replace=lru,penalty=10, use \"\" for it). Hits, misses and the"
+            " instructions missing the most are written to stderr at exit.\n"
+            "The branch predictor switch models branch prediction: refills are"
+            " then only charged on mispredictions. The model is static, bimodal or"
+            " btb, optionally followed by ,entries=number and ,penalty=cycles. The"
+            " accuracy, overall and for the sites mispredicted the most, is written"
+            " to stderr at exit.\n"
+            "The host stats switch measures the host time spent executing"
+            " instructions, tracing, serving gdb and doing console IO, and"
+            " derives the simulation speed (MIPS and ns per instruction). They"
+            " are written to stderr every given number of seconds (never when 0),"
+            " when receiving SIGUSR1 and at exit.\n"
+            "The plugin switch, which can be repeated, loads a shared object"
+            " whose plugin_init function receives the arguments and registers"
+            " callbacks on the simulation events (see plugin.h).\n"
+            "The coverage switch records which instructions have been executed"
+            " and, for conditional ones, which outcomes of their condition"
+            " occurred. At exit, the coverage is written to the given file, in a"
+            " raw format that coverage_merge merges, and to the coverage lcov file"
+            " as an lcov tracefile, using the symbols and line table of the"
+            " coverage ELF file.\n"
+            "The access patterns switch classifies each load/store instruction by"
+            " the dominant stride between its successive accesses (same address,"
+            " sequential, strided or irregular) and computes, per region of memory"
+            " (4096 bytes by default), the histogram of reuse distances, in"
+            " distinct 32 bytes lines accessed between two accesses to the same"
+            " line. They are written to the given file at exit.\n"
+            "The metrics switch exports the counters, along with the instructions"
+            " and cycles executed, the instructions per second and the memory"
+            " allocated, in the Prometheus text format. The endpoint is"
+            " http:port (on the loopback interface), unix:path (HTTP on a unix"
+            " socket) or file:path, rewritten every metrics interval seconds"
+            " (default is 10).\n"
+            "From gdb, monitor commands (monitor help lists them) switch tracing"
+            " flags, dump or reset the counters, select the timing table and"
+            " reload the program from its ELF file without restarting the"
+            " simulator.\n"
             "The debug switch enable selective reporting of debug messages on a "
             "per source file basis\n", name);
 }
@@ -142,6 +411,21 @@ int main(int argc, char *argv[]) {
     void *result;
     int opt;
     FILE *trace_file;
+    pthread_t signal_thread;
+    uint32_t memory_stats_page = 4096, memory_stats_line = 0;
+    char *profile_file = NULL, *profile_output = NULL, *profile_folded = NULL;
+    char *sample_elf = NULL, *sample_output = NULL;
+    uint32_t sample_interval = 0;
+    char *icache = NULL, *dcache = NULL, *branch_predictor = NULL;
+    struct host_stats_data host_stats_data;
+    char *plugin_files[16], *plugin_arguments;
+    char *coverage_file = NULL, *coverage_lcov = NULL, *coverage_elf = NULL;
+    char *access_patterns_file = NULL;
+    uint32_t access_patterns_region = 4096;
+    char *metrics_endpoint = NULL;
+    uint32_t metrics_interval = 10;
+    int plugins_number = 0, i;
+    pthread_t host_stats_thread;
 
     struct option longopts[] = {
         { "gdb-port", required_argument, NULL, 'g' },
@@ -150,7 +434,35 @@ int main(int argc, char *argv[]) {
         { "trace-registers", no_argument, NULL, 'r' },
         { "trace-memory", no_argument, NULL, 'm' },
         { "trace-state", required_argument, NULL, 's' },
+        { "trace-state-delta", required_argument, NULL, 'D' },
         { "trace-position", no_argument, NULL, 'p' },
+        { "trace-keyframes", required_argument, NULL, 'k' },
+        { "record", required_argument, NULL, 'R' },
+        { "replay", required_argument, NULL, 'P' },
+        { "memory-stats", required_argument, NULL, 'M' },
+        { "memory-stats-page", required_argument, NULL, 'G' },
+        { "memory-stats-line", required_argument, NULL, 'L' },
+        { "profile", required_argument, NULL, 'F' },
+        { "profile-output", required_argument, NULL, 'O' },
+        { "profile-folded", required_argument, NULL, 'Q' },
+        { "sample", required_argument, NULL, 'S' },
+        { "sample-elf", required_argument, NULL, 'E' },
+        { "sample-output", required_argument, NULL, 'W' },
+        { "counters", required_argument, NULL, 'C' },
+        { "timing", required_argument, NULL, 'T' },
+        { "pipeline", no_argument, NULL, 'I' },
+        { "icache", required_argument, NULL, 'J' },
+        { "dcache", required_argument, NULL, 'K' },
+        { "branch-predictor", required_argument, NULL, 'B' },
+        { "host-stats", required_argument, NULL, 'H' },
+        { "plugin", required_argument, NULL, 'U' },
+        { "coverage", required_argument, NULL, 'V' },
+        { "coverage-lcov", required_argument, NULL, 'Y' },
+        { "coverage-elf", required_argument, NULL, 'Z' },
+        { "access-patterns", required_argument, NULL, 'A' },
+        { "access-patterns-region", required_argument, NULL, 'N' },
+        { "metrics", required_argument, NULL, 'X' },
+        { "metrics-interval", required_argument, NULL, 'x' },
         { "help", no_argument, NULL, 'h' },
         { "debug", required_argument, NULL, 'd' },
         { NULL, 0, NULL, 0 }
@@ -158,8 +470,13 @@ int main(int argc, char *argv[]) {
 
     shared.gdb_port = 0;
     shared.irq_port = 0;
+    shared.memory_stats_file = NULL;
+    shared.counters_file = NULL;
+    shared.host_stats = 0;
+    host_stats_data.shared = &shared;
+    host_stats_data.interval = 0;
     trace_file = stdout;
-    while ((opt = getopt_long(argc, argv, "g:i:ht:rmspd:", longopts, NULL))
+    while ((opt = getopt_long(argc, argv, "g:i:ht:rms:D:pk:R:P:M:G:L:F:O:Q:S:E:W:C:T:IJ:K:B:H:U:V:Y:Z:A:N:X:x:d:", longopts, NULL))
            != -1) {
         switch (opt) {
         case 'g':
@@ -187,9 +504,108 @@ int main(int argc, char *argv[]) {
         case 's':
             trace_add(arm_get_mode_number(optarg));
             break;
+        case 'D':
+            trace_set_state_delta_interval(strtoul(optarg, NULL, 0));
+            break;
         case 'p':
             trace_add(POSITION);
             break;
+        case 'k':
+            trace_set_keyframe_interval(strtoul(optarg, NULL, 0));
+            break;
+        case 'R':
+            if (replay_start_recording(optarg) == -1) {
+                perror("Record file");
+                exit(1);
+            }
+            break;
+        case 'P':
+            if (replay_start_replaying(optarg) == -1) {
+                perror("Replay file");
+                exit(1);
+            }
+            break;
+        case 'M':
+            shared.memory_stats_file = optarg;
+            break;
+        case 'G':
+            memory_stats_page = strtoul(optarg, NULL, 0);
+            break;
+        case 'L':
+            memory_stats_line = strtoul(optarg, NULL, 0);
+            break;
+        case 'F':
+            profile_file = optarg;
+            break;
+        case 'O':
+            profile_output = optarg;
+            break;
+        case 'Q':
+            profile_folded = optarg;
+            break;
+        case 'S':
+            sample_interval = strtoul(optarg, NULL, 0);
+            break;
+        case 'E':
+            sample_elf = optarg;
+            break;
+        case 'W':
+            sample_output = optarg;
+            break;
+        case 'C':
+            shared.counters_file = optarg;
+            instruction_stats_enable();
+            break;
+        case 'T':
+            if (timing_select(optarg) == -1) {
+                perror("Timing table");
+                exit(1);
+            }
+            break;
+        case 'I':
+            pipeline_enable();
+            break;
+        case 'J':
+            icache = optarg;
+            break;
+        case 'K':
+            dcache = optarg;
+            break;
+        case 'B':
+            branch_predictor = optarg;
+            break;
+        case 'H':
+            shared.host_stats = 1;
+            host_stats_data.interval = strtoul(optarg, NULL, 0);
+            break;
+        case 'U':
+            if (plugins_number == sizeof(plugin_files) / sizeof(char *)) {
+                fprintf(stderr, "Too many plugins\n");
+                exit(1);
+            }
+            plugin_files[plugins_number++] = optarg;
+            break;
+        case 'V':
+            coverage_file = optarg;
+            break;
+        case 'Y':
+            coverage_lcov = optarg;
+            break;
+        case 'Z':
+            coverage_elf = optarg;
+            break;
+        case 'A':
+            access_patterns_file = optarg;
+            break;
+        case 'N':
+            access_patterns_region = strtoul(optarg, NULL, 0);
+            break;
+        case 'X':
+            metrics_endpoint = optarg;
+            break;
+        case 'x':
+            metrics_interval = strtoul(optarg, NULL, 0);
+            break;
         case 'd':
             add_debug_to(optarg);
             break;
@@ -208,11 +624,124 @@ int main(int argc, char *argv[]) {
     shared.mem = memory_create(0x8000);
     shared.reg = registers_create();
     shared.arm = arm_create(shared.reg, shared.mem);
+    if (shared.memory_stats_file &&
+        (memory_stats_enable(memory_get_size(shared.mem), memory_stats_page,
+                             memory_stats_line) == -1)) {
+        fprintf(stderr, "Memory statistics page and line sizes must be powers of two\n");
+        exit(1);
+    }
+    if (profile_file && (profiler_start(profile_file) == -1)) {
+        fprintf(stderr, "Cannot read the symbols of %s\n", profile_file);
+        exit(1);
+    }
+    if (sample_interval)
+        sampler_start(sample_interval);
+    if (icache && ((shared.arm->icache = cache_create("icache", icache)) == NULL)) {
+        fprintf(stderr, "Invalid instruction cache configuration : %s\n", icache);
+        exit(1);
+    }
+    // After the timing table, which gives the default penalty
+    if (branch_predictor && (branch_predictor_enable(branch_predictor) == -1)) {
+        fprintf(stderr, "Invalid branch predictor : %s\n", branch_predictor);
+        exit(1);
+    }
+    if (dcache && ((shared.arm->dcache = cache_create("dcache", dcache)) == NULL)) {
+        fprintf(stderr, "Invalid data cache configuration : %s\n", dcache);
+        exit(1);
+    }
+    if ((coverage_lcov != NULL) != (coverage_elf != NULL)) {
+        fprintf(stderr, "The coverage lcov file requires the coverage ELF file\n");
+        exit(1);
+    }
+    if ((coverage_file || coverage_lcov) &&
+        (coverage_enable(memory_get_size(shared.mem)) == -1)) {
+        fprintf(stderr, "Cannot allocate the coverage bitmaps\n");
+        exit(1);
+    }
+    if (access_patterns_file &&
+        (access_patterns_enable(memory_get_size(shared.mem), access_patterns_region, 32) == -1)) {
+        fprintf(stderr, "Access patterns region size must be a power of two\n");
+        exit(1);
+    }
+    gdb_add_counters();
+    trace_add_counters();
+    arm_exception_add_counters();
+    counters_add("irqs_received", NULL, "Interrupts received from the irq connections", COUNTER,
+                 &irqs_received);
+    if (metrics_endpoint &&
+        (metrics_start(metrics_endpoint, shared.arm, metrics_interval) == -1)) {
+        fprintf(stderr, "Invalid metrics endpoint : %s\n", metrics_endpoint);
+        exit(1);
+    }
+    for (i = 0; i < plugins_number; i++) {
+        plugin_arguments = strchr(plugin_files[i], ':');
+        if (plugin_arguments)
+            *plugin_arguments++ = '\0';
+        if (plugin_load(plugin_files[i], plugin_arguments ? plugin_arguments : "") == -1)
+            exit(1);
+    }
+
+    // Signals are handled by a dedicated thread, blocked in all the others
+    sigemptyset(&shared.signals);
+    sigaddset(&shared.signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &shared.signals, NULL);
+    pthread_create(&signal_thread, NULL, signal_listener, &shared);
+    if (shared.host_stats) {
+        host_stats_enable();
+        if (host_stats_data.interval)
+            pthread_create(&host_stats_thread, NULL, host_stats_reporter, &host_stats_data);
+    }
 
-    pthread_mutex_init(&shared.lock, NULL);
-    pthread_create(&gdb_thread, NULL, gdb_listener, &shared);
-    pthread_create(&irq_thread, NULL, irq_listener, &shared);
-    pthread_join(gdb_thread, &result);
+    if (replay_is_replaying()) {
+        replay_run(&shared);
+    } else {
+        pthread_mutex_init(&shared.lock, NULL);
+        pthread_create(&gdb_thread, NULL, gdb_listener, &shared);
+        pthread_create(&irq_thread, NULL, irq_listener, &shared);
+        pthread_join(gdb_thread, &result);
+        // Keeps the irq thread away from the core until the end
+        pthread_mutex_lock(&shared.lock);
+    }
+    replay_finish(shared.arm);
+    trace_finish();
+    if (shared.memory_stats_file)
+        dump_memory_stats(shared.memory_stats_file);
+    if (profile_file) {
+        dump_profile(profile_output, profile_folded);
+        profiler_stop();
+    }
+    if (sample_interval) {
+        dump_samples(shared.arm, sample_output, sample_elf);
+        sampler_stop();
+    }
+    pipeline_report(stderr);
+    if (shared.arm->icache)
+        cache_report(shared.arm->icache, stderr, 10);
+    if (shared.arm->dcache)
+        cache_report(shared.arm->dcache, stderr, 10);
+    branch_predictor_report(stderr, 10);
+    if (coverage_file || coverage_lcov) {
+        dump_coverage(coverage_file, coverage_lcov, coverage_elf);
+        coverage_disable();
+    }
+    if (access_patterns_file) {
+        dump_access_patterns(access_patterns_file);
+        access_patterns_disable();
+    }
+    if (shared.host_stats)
+        host_stats_report(stderr, arm_get_instruction_count(shared.arm));
+    self_profile_report(stderr, arm_get_instruction_count(shared.arm));
+    if (shared.counters_file)
+        dump_counters(shared.counters_file);
+    if (metrics_endpoint)
+        metrics_stop();
+    plugin_unload_all();
+    counters_clear();
+    branch_predictor_disable();
+    if (shared.arm->icache)
+        cache_destroy(shared.arm->icache);
+    if (shared.arm->dcache)
+        cache_destroy(shared.arm->dcache);
     arm_destroy(shared.arm);
     registers_destroy(shared.reg);
     memory_destroy(shared.mem);
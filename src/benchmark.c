@@ -0,0 +1,376 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <getopt.h>
+#include "arm.h"
+#include "memory.h"
+#include "registers.h"
+#include "self_profile.h"
+#include "sampler.h"
+
+/* Host benchmark of the simulator : runs fixed guest workloads headless (no
+ * gdb, no irq) and reports the simulation speed of each, in JSON. The
+ * workloads are hand assembled so that they do not need a cross compiler,
+ * each checks its own result so that a fast but wrong simulator is caught.
+ * Numbers are only comparable between builds with the same flags.
+ */
+#define MEMORY_SIZE 0x8000
+/* Any run going further is looping on an unsupported instruction */
+#define INSTRUCTIONS_LIMIT 100000000
+
+struct workload {
+    char *name;
+    uint32_t *code;
+    int size;
+    void (*prepare)(arm_core p);
+    int (*check)(arm_core p);
+};
+
+struct result {
+    uint64_t instructions;
+    double seconds;
+    double startup;
+};
+
+static uint32_t loop_code[] = {
+    0xE3A00000,                 /* mov r0, #0 */
+    0xE3A01601,                 /* mov r1, #0x100000 */
+    0xE2800001,                 /* loop: add r0, r0, #1 */
+    0xE2511001,                 /* subs r1, r1, #1 */
+    0x1AFFFFFC,                 /* bne loop */
+    0xEF123456                  /* swi 0x123456 */
+};
+
+/* 256 copies of 4K words from 0x1000 to 0x2000 */
+static uint32_t memcpy_code[] = {
+    0xE3A04C01,                 /* mov r4, #256 */
+    0xE3A00A01,                 /* pass: mov r0, #0x1000 */
+    0xE3A01A02,                 /* mov r1, #0x2000 */
+    0xE3A02A01,                 /* mov r2, #0x1000 */
+    0xE4903004,                 /* copy: ldr r3, [r0], #4 */
+    0xE4813004,                 /* str r3, [r1], #4 */
+    0xE2522004,                 /* subs r2, r2, #4 */
+    0x1AFFFFFB,                 /* bne copy */
+    0xE2544001,                 /* subs r4, r4, #1 */
+    0x1AFFFFF6,                 /* bne pass */
+    0xEF123456                  /* swi 0x123456 */
+};
+
+/* The loop of Examples/insertion_sort.c, 8 times on 256 words at 0x1000 in
+ * decreasing order (the worst case). As in compiled code, the sort is a
+ * function saving its registers with stmfd and returning with ldmfd.
+ */
+static uint32_t insertion_sort_code[] = {
+    0xE3A0DA04,                 /* mov sp, #0x4000 */
+    0xE3A05008,                 /* mov r5, #8 */
+    0xE3A00A01,                 /* pass: mov r0, #0x1000 */
+    0xE3A01C01,                 /* mov r1, #256 */
+    0xE4801004,                 /* fill: str r1, [r0], #4 */
+    0xE2511001,                 /* subs r1, r1, #1 */
+    0x1AFFFFFC,                 /* bne fill */
+    0xEB000002,                 /* bl sort */
+    0xE2555001,                 /* subs r5, r5, #1 */
+    0x1AFFFFF7,                 /* bne pass */
+    0xEF123456,                 /* swi 0x123456 */
+    0xE92D40F0,                 /* sort: stmfd sp!, {r4-r7, lr} */
+    0xE3A06A01,                 /* mov r6, #0x1000 */
+    0xE3A01004,                 /* mov r1, #4 */
+    0xE7962001,                 /* outer: ldr r2, [r6, r1] */
+    0xE2413004,                 /* sub r3, r1, #4 */
+    0xE7964003,                 /* inner: ldr r4, [r6, r3] */
+    0xE1540002,                 /* cmp r4, r2 */
+    0xDA000003,                 /* ble insert */
+    0xE2837004,                 /* add r7, r3, #4 */
+    0xE7864007,                 /* str r4, [r6, r7] */
+    0xE2533004,                 /* subs r3, r3, #4 */
+    0x5AFFFFF8,                 /* bpl inner */
+    0xE2837004,                 /* insert: add r7, r3, #4 */
+    0xE7862007,                 /* str r2, [r6, r7] */
+    0xE2811004,                 /* add r1, r1, #4 */
+    0xE3510B01,                 /* cmp r1, #1024 */
+    0xBAFFFFF1,                 /* blt outer */
+    0xE8BD80F0                  /* ldmfd sp!, {r4-r7, pc} */
+};
+
+/* Branches on the bits of a xorshift generator, hard to predict */
+static uint32_t branches_code[] = {
+    0xE3A00001,                 /* mov r0, #1 */
+    0xE3A01701,                 /* mov r1, #0x40000 */
+    0xE3A02000,                 /* mov r2, #0 */
+    0xE3A03000,                 /* mov r3, #0 */
+    0xE0200680,                 /* loop: eor r0, r0, r0, lsl #13 */
+    0xE02008A0,                 /* eor r0, r0, r0, lsr #17 */
+    0xE0200280,                 /* eor r0, r0, r0, lsl #5 */
+    0xE3100001,                 /* tst r0, #1 */
+    0x0A000001,                 /* beq even */
+    0xE2822001,                 /* add r2, r2, #1 */
+    0xEA000002,                 /* b next */
+    0xE3100002,                 /* even: tst r0, #2 */
+    0x0A000000,                 /* beq next */
+    0xE2833001,                 /* add r3, r3, #1 */
+    0xE2511001,                 /* next: subs r1, r1, #1 */
+    0x1AFFFFF3,                 /* bne loop */
+    0xEF123456                  /* swi 0x123456 */
+};
+
+static int loop_check(arm_core p) {
+    return arm_read_register(p, 0) == 0x100000;
+}
+
+static void memcpy_prepare(arm_core p) {
+    uint32_t i;
+
+    for (i = 0; i < 0x1000; i += 4)
+        arm_write_word(p, 0x1000 + i, i * 0x01010101);
+}
+
+static int memcpy_check(arm_core p) {
+    uint32_t i, value;
+
+    for (i = 0; i < 0x1000; i += 4) {
+        arm_peek_word(p, 0x2000 + i, &value);
+        if (value != i * 0x01010101)
+            return 0;
+    }
+    return 1;
+}
+
+static int insertion_sort_check(arm_core p) {
+    uint32_t i, value;
+
+    for (i = 0; i < 256; i++) {
+        arm_peek_word(p, 0x1000 + 4 * i, &value);
+        if (value != i + 1)
+            return 0;
+    }
+    /* The stack is back to its initial position after the 8 calls */
+    return arm_read_register(p, 13) == 0x4000;
+}
+
+/* Every draw of the generator goes to one of the three paths */
+static int branches_check(arm_core p) {
+    return arm_read_register(p, 1) == 0 && arm_read_register(p, 2) > 0 &&
+        arm_read_register(p, 3) > 0 && arm_read_register(p, 2) + arm_read_register(p, 3) < 0x40000;
+}
+
+#define WORKLOAD(name, prepare, check) \
+    { #name, name##_code, sizeof(name##_code) / sizeof(uint32_t), prepare, check }
+
+static struct workload workloads[] = {
+    WORKLOAD(loop, NULL, loop_check),
+    WORKLOAD(memcpy, memcpy_prepare, memcpy_check),
+    WORKLOAD(insertion_sort, NULL, insertion_sort_check),
+    WORKLOAD(branches, NULL, branches_check)
+};
+
+#define WORKLOADS_NUMBER (sizeof(workloads) / sizeof(struct workload))
+
+static double now() {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec / 1e9;
+}
+
+/* Startup is the creation of the simulated machine and the loading of the
+ * program, the run goes from the reset to the end of simulation software
+ * interrupt
+ */
+static int run(struct workload *w, struct result *r) {
+    double start;
+    registers reg;
+    memory mem;
+    arm_core p;
+    int i, result, valid;
+
+    start = now();
+    arm_init();
+    mem = memory_create(MEMORY_SIZE);
+    reg = registers_create();
+    p = arm_create(reg, mem);
+    for (i = 0; i < w->size; i++)
+        arm_write_word(p, 4 * i, w->code[i]);
+    if (w->prepare)
+        w->prepare(p);
+    arm_exception(p, RESET);
+    r->startup = now() - start;
+
+    start = now();
+    do {
+        result = arm_step(p);
+    } while ((result == 0) && (arm_get_instruction_count(p) < INSTRUCTIONS_LIMIT));
+    r->seconds = now() - start;
+    r->instructions = arm_get_instruction_count(p);
+
+    valid = (result == END_SIMULATION) && w->check(p);
+    if (!valid)
+        fprintf(stderr, "Workload %s failed : exception %d after %lu instructions at %08X\n",
+                w->name, result, (unsigned long) r->instructions, p->current_address);
+    arm_destroy(p);
+    registers_destroy(reg);
+    memory_destroy(mem);
+    return valid ? 0 : -1;
+}
+
+static double speed(struct result *r) {
+    return r->seconds > 0 ? r->instructions / r->seconds : 0;
+}
+
+/* Reads the instructions per second of a workload in a file written by this
+ * program, one workload per line
+ */
+static double baseline_speed(char *filename, char *name) {
+    char line[1024], pattern[128], *position;
+    FILE *f;
+    double result = -1;
+
+    f = fopen(filename, "r");
+    if (f == NULL)
+        return -1;
+    snprintf(pattern, sizeof(pattern), "\"name\": \"%s\"", name);
+    while ((result < 0) && fgets(line, sizeof(line), f)) {
+        if (strstr(line, pattern) &&
+            (position = strstr(line, "\"instructions_per_second\": ")) != NULL)
+            result = strtod(position + strlen("\"instructions_per_second\": "), NULL);
+    }
+    fclose(f);
+    return result;
+}
+
+void usage(char *name) {
+    fprintf(stderr, "Usage:\n"
+            "%s [ --help ] [ --repeat runs ] [ --output file ] [ --compare baseline ]"
+            " [ --threshold percent ] [ --sample interval ] [ workload ... ]\n\n"
+            "Runs the given workloads (all by default, among loop, memcpy,"
+            " insertion_sort and branches) headless and writes their"
+            " instructions per second and startup time, in JSON, to the output"
+            " (default is stdout). Each workload is run the given number of times"
+            " (3 by default) and the fastest run is kept. The compare switch reads"
+            " a baseline written by a previous run and flags the workloads slower"
+            " than the baseline by more than the threshold (5%% by default) ; the"
+            " exit status is then 1. It is 2 when a workload fails. The sample"
+            " switch runs the workloads with the sampler of arm_simulator, taking"
+            " one instruction out of interval, to measure its cost.\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    struct option longopts[] = {
+        { "repeat", required_argument, NULL, 'r' },
+        { "output", required_argument, NULL, 'o' },
+        { "compare", required_argument, NULL, 'c' },
+        { "threshold", required_argument, NULL, 't' },
+        { "sample", required_argument, NULL, 's' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    char *baseline = NULL;
+    double threshold = 5, reference, change;
+    int repeat = 3, opt, i, j, k, first = 1, regressions = 0, selected;
+    struct result best, current;
+    uint64_t executed = 0;
+    FILE *output = stdout;
+
+    while ((opt = getopt_long(argc, argv, "r:o:c:t:s:h", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'r':
+            repeat = atoi(optarg);
+            break;
+        case 'o':
+            output = fopen(optarg, "w");
+            if (output == NULL) {
+                perror("Output file");
+                exit(2);
+            }
+            break;
+        case 'c':
+            baseline = optarg;
+            break;
+        case 't':
+            threshold = strtod(optarg, NULL);
+            break;
+        case 's':
+            sampler_start(strtoul(optarg, NULL, 0));
+            break;
+        case 'h':
+            usage(argv[0]);
+            exit(0);
+        default:
+            usage(argv[0]);
+            exit(2);
+        }
+    }
+    if (repeat < 1)
+        repeat = 1;
+    for (i = optind; i < argc; i++) {
+        for (j = 0; (j < WORKLOADS_NUMBER) && strcmp(argv[i], workloads[j].name); j++);
+        if (j == WORKLOADS_NUMBER) {
+            fprintf(stderr, "Unknown workload %s\n", argv[i]);
+            exit(2);
+        }
+    }
+
+    fprintf(output, "{\n  \"benchmarks\": [\n");
+    for (j = 0; j < WORKLOADS_NUMBER; j++) {
+        selected = (optind == argc);
+        for (i = optind; i < argc; i++)
+            selected |= !strcmp(argv[i], workloads[j].name);
+        if (!selected)
+            continue;
+        for (k = 0; k < repeat; k++) {
+            if (run(&workloads[j], &current) == -1)
+                exit(2);
+            executed += current.instructions;
+            if ((k == 0) || (speed(&current) > speed(&best)))
+                best = current;
+        }
+        fprintf(output, "%s    { \"name\": \"%s\", \"instructions\": %lu, \"seconds\": %.6f,"
+                " \"instructions_per_second\": %.0f, \"startup_seconds\": %.6f",
+                first ? "" : ",\n", workloads[j].name, (unsigned long) best.instructions,
+                best.seconds, speed(&best), best.startup);
+        first = 0;
+        fprintf(stderr, "%-16s %8.3f MIPS", workloads[j].name, speed(&best) / 1e6);
+        if (baseline && ((reference = baseline_speed(baseline, workloads[j].name)) > 0)) {
+            change = 100 * (speed(&best) - reference) / reference;
+            fprintf(output, ", \"baseline_instructions_per_second\": %.0f,"
+                    " \"change_percent\": %.2f, \"regression\": %s", reference, change,
+                    change < -threshold ? "true" : "false");
+            fprintf(stderr, " %+7.2f%% %s", change, change < -threshold ? "REGRESSION" : "");
+            if (change < -threshold)
+                regressions++;
+        } else if (baseline) {
+            fprintf(stderr, " (not in the baseline)");
+        }
+        fprintf(output, " }");
+        fprintf(stderr, "\n");
+    }
+    fprintf(output, "\n  ]\n}\n");
+    if (output != stdout)
+        fclose(output);
+    self_profile_report(stderr, executed);
+    sampler_stop();
+    return regressions ? 1 : 0;
+}
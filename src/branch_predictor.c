@@ -0,0 +1,285 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "branch_predictor.h"
+#include "disassembler.h"
+#include "timing.h"
+#include "counters.h"
+#include "util.h"
+
+#define STATIC 0
+#define BIMODAL 1
+#define BTB 2
+/* Return addresses kept, older ones are overwritten by deeper calls */
+#define RETURN_STACK_SIZE 8
+
+struct btb_entry {
+    uint32_t tag;
+    uint32_t target;
+    uint8_t valid;
+    uint8_t counter;
+};
+
+struct branch_site {
+    uint32_t pc;
+    uint32_t executed;
+    uint32_t mispredicted;
+};
+
+static int enabled = 0;
+static int model;
+static uint32_t entries = 512;
+static uint32_t penalty;
+static uint8_t *counters_table = NULL;
+static struct btb_entry *btb = NULL;
+static uint32_t return_stack[RETURN_STACK_SIZE];
+static uint32_t return_top, return_depth;
+static uint64_t predictions, mispredictions;
+/* Per site accuracy, open addressing hash table on the PC */
+static struct branch_site *sites = NULL;
+static uint32_t sites_size, sites_used;
+
+int branch_predictor_enable(char *configuration) {
+    char *copy, *item, *save, *end;
+    unsigned long value;
+    int result = 0;
+
+    penalty = timing_get(TIMING_PC_WRITE);
+    entries = 512;
+    copy = strdup(configuration);
+    error_if_null(copy);
+    item = strtok_r(copy, ",", &save);
+    if (item == NULL)
+        result = -1;
+    else if (strcmp(item, "static") == 0)
+        model = STATIC;
+    else if (strcmp(item, "bimodal") == 0)
+        model = BIMODAL;
+    else if (strcmp(item, "btb") == 0)
+        model = BTB;
+    else
+        result = -1;
+    while (!result && (item = strtok_r(NULL, ",", &save))) {
+        if (strncmp(item, "entries=", 8) == 0) {
+            value = strtoul(item + 8, &end, 0);
+            if ((*end != '\0') || (value == 0) || (value & (value - 1)))
+                result = -1;
+            entries = value;
+        } else if (strncmp(item, "penalty=", 8) == 0) {
+            value = strtoul(item + 8, &end, 0);
+            if (*end != '\0')
+                result = -1;
+            penalty = value;
+        } else {
+            result = -1;
+        }
+    }
+    free(copy);
+    if (result == -1)
+        return -1;
+    /* Weakly not taken to start with */
+    counters_table = malloc(entries);
+    error_if_null(counters_table);
+    memset(counters_table, 1, entries);
+    btb = calloc(entries, sizeof(struct btb_entry));
+    error_if_null(btb);
+    sites_size = 1024;
+    sites_used = 0;
+    sites = calloc(sites_size, sizeof(struct branch_site));
+    error_if_null(sites);
+    return_top = return_depth = 0;
+    enabled = 1;
+    timing_charge_refills(0);
+    if (!counters_find("branch_predictions", NULL)) {
+        counters_add("branch_predictions", NULL, "Predicted branches", COUNTER, &predictions);
+        counters_add("branch_mispredictions", NULL, "Mispredicted branches", COUNTER,
+                     &mispredictions);
+    }
+    return 0;
+}
+
+void branch_predictor_disable() {
+    if (enabled) {
+        enabled = 0;
+        timing_charge_refills(1);
+        free(counters_table);
+        free(btb);
+        free(sites);
+        sites = NULL;
+    }
+}
+
+static struct branch_site *branch_site_slot(struct branch_site *table, uint32_t size,
+                                            uint32_t pc) {
+    uint32_t i = ((pc >> 2) * 2654435761u) & (size - 1);
+
+    while (table[i].executed && (table[i].pc != pc))
+        i = (i + 1) & (size - 1);
+    return &table[i];
+}
+
+static void branch_site_count(uint32_t pc, int mispredicted) {
+    struct branch_site *slot, *old;
+    uint32_t i, old_size;
+
+    slot = branch_site_slot(sites, sites_size, pc);
+    if (slot->executed == 0) {
+        if (2 * (sites_used + 1) > sites_size) {
+            old = sites;
+            old_size = sites_size;
+            sites_size *= 2;
+            sites = calloc(sites_size, sizeof(struct branch_site));
+            error_if_null(sites);
+            for (i = 0; i < old_size; i++)
+                if (old[i].executed)
+                    *branch_site_slot(sites, sites_size, old[i].pc) = old[i];
+            free(old);
+            slot = branch_site_slot(sites, sites_size, pc);
+        }
+        slot->pc = pc;
+        sites_used++;
+    }
+    slot->executed++;
+    slot->mispredicted += mispredicted;
+}
+
+/* Target of direct branches, known at decode */
+static int branch_direct_target(uint32_t address, uint32_t ins, uint32_t *target) {
+    if (get_bits(ins, 27, 25) != 0b101)
+        return 0;
+    *target = address + 8 + (asr(get_bits(ins, 23, 0) << 8, 8) << 2);
+    if (get_bits(ins, 31, 28) == 0xF)
+        *target += get_bit(ins, 24) << 1;
+    return 1;
+}
+
+/* bl, blx immediate and blx register, which save their return address */
+static int branch_is_call(uint32_t ins) {
+    if (get_bits(ins, 31, 28) == 0xF)
+        return get_bits(ins, 27, 25) == 0b101;
+    return (get_bits(ins, 27, 24) == 0b1011) || ((ins & 0x0FFFFFF0) == 0x012FFF30);
+}
+
+static void branch_update_counter(uint8_t *counter, int taken) {
+    if (taken && (*counter < 3))
+        (*counter)++;
+    else if (!taken && (*counter > 0))
+        (*counter)--;
+}
+
+void branch_predictor_instruction(arm_core p, int executed) {
+    uint32_t address = p->current_address, ins = p->current_instruction;
+    uint32_t pc, target = 0, predicted_target = 0;
+    int taken, predicted_taken = 0, direct, mispredicted;
+    struct btb_entry *entry;
+    uint8_t *counter;
+
+    if (!enabled || !arm_is_control_transfer(ins) || (get_bits(ins, 27, 24) == 0xF))
+        return;
+    pc = registers_read(p->reg, 15, registers_get_mode(p->reg));
+    taken = executed && (pc != address + 4);
+    direct = branch_direct_target(address, ins, &target);
+    switch (model) {
+    case STATIC:
+        if (direct) {
+            predicted_taken = (get_bits(ins, 31, 28) >= 0b1110) || (target <= address);
+            predicted_target = target;
+        }
+        break;
+    case BIMODAL:
+        counter = &counters_table[(address >> 2) & (entries - 1)];
+        predicted_taken = direct && (*counter >= 2);
+        predicted_target = target;
+        branch_update_counter(counter, taken);
+        break;
+    case BTB:
+        entry = &btb[(address >> 2) & (entries - 1)];
+        if (entry->valid && (entry->tag == address)) {
+            predicted_taken = entry->counter >= 2;
+            predicted_target = entry->target;
+            branch_update_counter(&entry->counter, taken);
+        } else if (taken) {
+            entry->valid = 1;
+            entry->tag = address;
+            entry->counter = 2;
+        }
+        if (taken)
+            entry->target = pc;
+        break;
+    }
+    /* Returns go to the address saved by the matching call */
+    if ((model != STATIC) && return_depth && arm_is_return(ins)) {
+        predicted_taken = 1;
+        predicted_target = return_stack[return_top];
+        if (taken) {
+            return_top = (return_top - 1) & (RETURN_STACK_SIZE - 1);
+            return_depth--;
+        }
+    }
+    if ((model != STATIC) && taken && branch_is_call(ins)) {
+        return_top = (return_top + 1) & (RETURN_STACK_SIZE - 1);
+        return_stack[return_top] = address + 4;
+        if (return_depth < RETURN_STACK_SIZE)
+            return_depth++;
+    }
+    mispredicted = (taken != predicted_taken) || (taken && (predicted_target != pc));
+    predictions++;
+    mispredictions += mispredicted;
+    branch_site_count(address, mispredicted);
+    if (mispredicted)
+        p->cycle_count += penalty;
+}
+
+static int branch_by_mispredictions(const void *a, const void *b) {
+    const struct branch_site *first = a, *second = b;
+
+    if (first->mispredicted != second->mispredicted)
+        return first->mispredicted < second->mispredicted ? 1 : -1;
+    return first->pc < second->pc ? -1 : first->pc > second->pc;
+}
+
+void branch_predictor_report(FILE *f, int count) {
+    struct branch_site *sorted;
+    uint32_t i, j;
+
+    if (!enabled)
+        return;
+    fprintf(f, "Branch predictor : %" PRIu64 " predictions, %" PRIu64
+            " mispredictions, accuracy %.2f%%\n", predictions, mispredictions,
+            predictions ? 100.0 * (predictions - mispredictions) / predictions : 100.0);
+    sorted = malloc((sites_used + 1) * sizeof(struct branch_site));
+    error_if_null(sorted);
+    for (i = 0, j = 0; i < sites_size; i++)
+        if (sites[i].executed)
+            sorted[j++] = sites[i];
+    qsort(sorted, sites_used, sizeof(struct branch_site), branch_by_mispredictions);
+    if (sites_used)
+        fprintf(f, "%10s %10s %10s %9s\n", "site", "executed", "mispredict", "accuracy");
+    for (i = 0; (i < sites_used) && (i < count); i++)
+        fprintf(f, "  %08X %10u %10u %8.2f%%\n", sorted[i].pc, sorted[i].executed,
+                sorted[i].mispredicted,
+                100.0 * (sorted[i].executed - sorted[i].mispredicted) / sorted[i].executed);
+    free(sorted);
+}
@@ -0,0 +1,56 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __BRANCH_PREDICTOR_H__
+#define __BRANCH_PREDICTOR_H__
+#include <stdio.h>
+#include <stdint.h>
+#include "arm_core.h"
+
+/* Branch prediction model, evaluated on every instruction that may write the
+ * PC (branches, data processing, loads and load multiple into the PC), taken
+ * or not. Once enabled, refills are no longer charged by the timing table,
+ * only mispredictions are, with the given penalty. Models are :
+ * - static : backward conditional branches taken, forward ones not taken,
+ *   indirect branches (other PC writes) always mispredicted when taken
+ * - bimodal : table of 2 bits saturating counters indexed by PC, branch
+ *   targets known at decode, indirect branches mispredicted when taken,
+ *   except returns (see arm_is_return) once a call has been seen
+ * - btb : branch target buffer holding the target and a 2 bits counter, a
+ *   branch missing from it is predicted not taken
+ * Both bimodal and btb predict returns with an 8 entries stack of the return
+ * addresses of the calls (bl and blx), a return predicted taken to the top
+ * address. A return with an empty stack falls back to the model.
+ * The configuration is the model name followed by optional ,entries=number
+ * (a power of two, 512 by default) and ,penalty=cycles (the pc_write cost of
+ * the timing table by default).
+ */
+int branch_predictor_enable(char *configuration);
+void branch_predictor_disable();
+
+/* To be called after each fetched instruction, executed or not */
+void branch_predictor_instruction(arm_core p, int executed);
+
+/* Overall accuracy and the count sites mispredicted the most */
+void branch_predictor_report(FILE * f, int count);
+
+#endif
@@ -0,0 +1,136 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "breakpoints.h"
+#include "util.h"
+
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1 << PAGE_SHIFT)
+/* Each table of the directory covers 4 MiB of addresses, with 1024 pages */
+#define TABLE_SHIFT 22
+#define TABLE_SIZE (1 << (TABLE_SHIFT - PAGE_SHIFT))
+#define DIRECTORY_SIZE (1 << (32 - TABLE_SHIFT))
+
+struct breakpoints_page {
+    /* Breakpoints in the page, it is freed when none is left */
+    uint32_t count;
+    uint8_t bits[PAGE_SIZE / 8];
+};
+
+struct breakpoints_table {
+    /* Pages allocated in the table, it is freed when none is left */
+    uint32_t count;
+    struct breakpoints_page *pages[TABLE_SIZE];
+};
+
+struct breakpoints_data {
+    /* Tables are allocated for the 4 MiB ranges holding breakpoints only */
+    struct breakpoints_table *tables[DIRECTORY_SIZE];
+    uint32_t number;
+};
+
+breakpoints breakpoints_create() {
+    breakpoints b;
+
+    b = calloc(1, sizeof(struct breakpoints_data));
+    error_if_null(b);
+    return b;
+}
+
+void breakpoints_destroy(breakpoints b) {
+    uint32_t i, j;
+
+    for (i = 0; i < DIRECTORY_SIZE; i++) {
+        if (b->tables[i]) {
+            for (j = 0; j < TABLE_SIZE; j++)
+                free(b->tables[i]->pages[j]);
+            free(b->tables[i]);
+        }
+    }
+    free(b);
+}
+
+static struct breakpoints_page **breakpoints_page_slot(struct breakpoints_table *table,
+                                                       uint32_t address) {
+    return &table->pages[(address >> PAGE_SHIFT) & (TABLE_SIZE - 1)];
+}
+
+int breakpoints_find(breakpoints b, uint32_t address) {
+    struct breakpoints_table *table = b->tables[address >> TABLE_SHIFT];
+    struct breakpoints_page *page;
+    uint32_t offset = address & (PAGE_SIZE - 1);
+
+    if (table == NULL)
+        return 0;
+    page = *breakpoints_page_slot(table, address);
+    return page && ((page->bits[offset >> 3] >> (offset & 7)) & 1);
+}
+
+int breakpoints_add(breakpoints b, uint32_t address) {
+    struct breakpoints_table **table = &b->tables[address >> TABLE_SHIFT];
+    struct breakpoints_page **page;
+    uint32_t offset = address & (PAGE_SIZE - 1);
+
+    if (breakpoints_find(b, address))
+        return 0;
+    if (*table == NULL) {
+        *table = calloc(1, sizeof(struct breakpoints_table));
+        error_if_null(*table);
+    }
+    page = breakpoints_page_slot(*table, address);
+    if (*page == NULL) {
+        *page = calloc(1, sizeof(struct breakpoints_page));
+        error_if_null(*page);
+        (*table)->count++;
+    }
+    (*page)->bits[offset >> 3] |= 1 << (offset & 7);
+    (*page)->count++;
+    b->number++;
+    return 1;
+}
+
+int breakpoints_remove(breakpoints b, uint32_t address) {
+    struct breakpoints_table **table = &b->tables[address >> TABLE_SHIFT];
+    struct breakpoints_page **page;
+    uint32_t offset = address & (PAGE_SIZE - 1);
+
+    if (!breakpoints_find(b, address))
+        return 0;
+    page = breakpoints_page_slot(*table, address);
+    (*page)->bits[offset >> 3] &= ~(1 << (offset & 7));
+    b->number--;
+    if (--(*page)->count == 0) {
+        free(*page);
+        *page = NULL;
+        if (--(*table)->count == 0) {
+            free(*table);
+            *table = NULL;
+        }
+    }
+    return 1;
+}
+
+uint32_t breakpoints_number(breakpoints b) {
+    return b->number;
+}
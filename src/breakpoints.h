@@ -0,0 +1,47 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __BREAKPOINTS_H__
+#define __BREAKPOINTS_H__
+#include <stdint.h>
+
+/* Set of breakpoint addresses, without limit on their number : one bit per
+ * byte address in bitmaps of 4 KiB pages, reached through a two level
+ * directory (1024 tables of 1024 pages). Tables and pages are allocated for
+ * the addresses holding breakpoints only : a breakpoint anywhere costs at most
+ * a new table and page (under 9 KiB), and looking an address up is three
+ * loads whatever the number of breakpoints.
+ */
+typedef struct breakpoints_data *breakpoints;
+
+breakpoints breakpoints_create();
+void breakpoints_destroy(breakpoints b);
+
+/* Return 1 when the set changed, 0 when address was already in the set
+ * (add) or not in the set (remove)
+ */
+int breakpoints_add(breakpoints b, uint32_t address);
+int breakpoints_remove(breakpoints b, uint32_t address);
+int breakpoints_find(breakpoints b, uint32_t address);
+uint32_t breakpoints_number(breakpoints b);
+
+#endif
@@ -0,0 +1,294 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "cache.h"
+#include "counters.h"
+#include "util.h"
+
+#define LRU 0
+#define FIFO 1
+#define RANDOM 2
+
+struct cache_line {
+    uint32_t tag;
+    uint8_t valid;
+    uint8_t dirty;
+    /* Last use for LRU, fill time for FIFO */
+    uint64_t stamp;
+};
+
+struct cache_miss {
+    uint32_t pc;
+    uint32_t count;
+};
+
+struct cache_data {
+    char *name;
+    uint32_t size, ways, line_size, sets;
+    int line_shift, write_back, replacement;
+    uint32_t penalty;
+    struct cache_line *lines;
+    uint64_t time;
+    uint32_t random;
+    uint64_t hits[2], misses[2], writebacks;
+    /* Misses per PC, open addressing hash table */
+    struct cache_miss *miss_pcs;
+    uint32_t miss_pcs_size, miss_pcs_used;
+};
+
+static int log2_of(uint32_t value) {
+    int result = 0;
+
+    if ((value == 0) || (value & (value - 1)))
+        return -1;
+    while (value >>= 1)
+        result++;
+    return result;
+}
+
+static int cache_configure(cache c, char *configuration) {
+    char *copy, *item, *value, *end, *save;
+    unsigned long number;
+    int result = 0;
+
+    copy = strdup(configuration);
+    error_if_null(copy);
+    for (item = strtok_r(copy, ",", &save); item && !result; item = strtok_r(NULL, ",", &save)) {
+        value = strchr(item, '=');
+        if (value == NULL) {
+            result = -1;
+            break;
+        }
+        *value++ = '\0';
+        number = strtoul(value, &end, 0);
+        if ((*end == 'k') || (*end == 'K')) {
+            number *= 1024;
+            end++;
+        }
+        if (strcmp(item, "write") == 0) {
+            c->write_back = strcmp(value, "back") == 0;
+            result = c->write_back || (strcmp(value, "through") == 0) ? 0 : -1;
+        } else if (strcmp(item, "replace") == 0) {
+            if (strcmp(value, "lru") == 0)
+                c->replacement = LRU;
+            else if (strcmp(value, "fifo") == 0)
+                c->replacement = FIFO;
+            else if (strcmp(value, "random") == 0)
+                c->replacement = RANDOM;
+            else
+                result = -1;
+        } else if ((*end != '\0') || (end == value)) {
+            result = -1;
+        } else if (strcmp(item, "size") == 0) {
+            c->size = number;
+        } else if (strcmp(item, "ways") == 0) {
+            c->ways = number;
+        } else if (strcmp(item, "line") == 0) {
+            c->line_size = number;
+        } else if (strcmp(item, "penalty") == 0) {
+            c->penalty = number;
+        } else {
+            result = -1;
+        }
+    }
+    free(copy);
+    return result;
+}
+
+static void cache_add_counters(cache c) {
+    char labels[64];
+
+    snprintf(labels, sizeof(labels), "cache=\"%s\",access=\"read\"", c->name);
+    counters_add("cache_hits", labels, "Cache hits", COUNTER, &c->hits[CACHE_READ]);
+    counters_add("cache_misses", labels, "Cache misses", COUNTER, &c->misses[CACHE_READ]);
+    snprintf(labels, sizeof(labels), "cache=\"%s\",access=\"write\"", c->name);
+    counters_add("cache_hits", labels, "Cache hits", COUNTER, &c->hits[CACHE_WRITE]);
+    counters_add("cache_misses", labels, "Cache misses", COUNTER, &c->misses[CACHE_WRITE]);
+    snprintf(labels, sizeof(labels), "cache=\"%s\"", c->name);
+    counters_add("cache_writebacks", labels, "Dirty lines written back", COUNTER,
+                 &c->writebacks);
+}
+
+cache cache_create(char *name, char *configuration) {
+    cache c;
+
+    c = calloc(1, sizeof(struct cache_data));
+    error_if_null(c);
+    c->name = name;
+    c->size = 16 * 1024;
+    c->ways = 4;
+    c->line_size = 32;
+    c->write_back = 1;
+    c->replacement = LRU;
+    c->penalty = 10;
+    c->random = 0x12345678;
+    if ((cache_configure(c, configuration) == -1) || (c->ways == 0) ||
+        ((c->line_shift = log2_of(c->line_size)) == -1) ||
+        (c->size % (c->ways * c->line_size)) ||
+        (log2_of(c->size / (c->ways * c->line_size)) == -1)) {
+        free(c);
+        return NULL;
+    }
+    c->sets = c->size / (c->ways * c->line_size);
+    c->lines = calloc(c->sets * c->ways, sizeof(struct cache_line));
+    c->miss_pcs_size = 1024;
+    c->miss_pcs = calloc(c->miss_pcs_size, sizeof(struct cache_miss));
+    error_if_null(c->lines);
+    error_if_null(c->miss_pcs);
+    cache_add_counters(c);
+    return c;
+}
+
+void cache_destroy(cache c) {
+    free(c->lines);
+    free(c->miss_pcs);
+    free(c);
+}
+
+static struct cache_miss *cache_miss_slot(struct cache_miss *table, uint32_t size, uint32_t pc) {
+    uint32_t i = ((pc >> 2) * 2654435761u) & (size - 1);
+
+    while (table[i].count && (table[i].pc != pc))
+        i = (i + 1) & (size - 1);
+    return &table[i];
+}
+
+static void cache_count_miss(cache c, uint32_t pc) {
+    struct cache_miss *slot, *old;
+    uint32_t i, old_size;
+
+    slot = cache_miss_slot(c->miss_pcs, c->miss_pcs_size, pc);
+    if (slot->count == 0) {
+        if (2 * (c->miss_pcs_used + 1) > c->miss_pcs_size) {
+            old = c->miss_pcs;
+            old_size = c->miss_pcs_size;
+            c->miss_pcs_size *= 2;
+            c->miss_pcs = calloc(c->miss_pcs_size, sizeof(struct cache_miss));
+            error_if_null(c->miss_pcs);
+            for (i = 0; i < old_size; i++)
+                if (old[i].count)
+                    *cache_miss_slot(c->miss_pcs, c->miss_pcs_size, old[i].pc) = old[i];
+            free(old);
+            slot = cache_miss_slot(c->miss_pcs, c->miss_pcs_size, pc);
+        }
+        slot->pc = pc;
+        c->miss_pcs_used++;
+    }
+    slot->count++;
+}
+
+static struct cache_line *cache_victim(cache c, struct cache_line *set) {
+    struct cache_line *victim;
+    uint32_t way;
+
+    for (way = 0; way < c->ways; way++)
+        if (!set[way].valid)
+            return &set[way];
+    if (c->replacement == RANDOM) {
+        /* xorshift, deterministic from one run to another */
+        c->random ^= c->random << 13;
+        c->random ^= c->random >> 17;
+        c->random ^= c->random << 5;
+        return &set[c->random % c->ways];
+    }
+    victim = &set[0];
+    for (way = 1; way < c->ways; way++)
+        if (set[way].stamp < victim->stamp)
+            victim = &set[way];
+    return victim;
+}
+
+uint32_t cache_access(cache c, uint32_t pc, uint32_t address, int type) {
+    struct cache_line *set, *line;
+    uint32_t tag, way, cycles;
+
+    tag = address >> c->line_shift;
+    set = &c->lines[(tag & (c->sets - 1)) * c->ways];
+    c->time++;
+    for (way = 0; way < c->ways; way++) {
+        if (set[way].valid && (set[way].tag == tag)) {
+            c->hits[type]++;
+            if (c->replacement == LRU)
+                set[way].stamp = c->time;
+            if ((type == CACHE_WRITE) && c->write_back)
+                set[way].dirty = 1;
+            return 0;
+        }
+    }
+    c->misses[type]++;
+    cache_count_miss(c, pc);
+    /* Write through caches send write misses to memory without allocating */
+    if ((type == CACHE_WRITE) && !c->write_back)
+        return 0;
+    cycles = c->penalty;
+    line = cache_victim(c, set);
+    if (line->valid && line->dirty) {
+        c->writebacks++;
+        cycles += c->penalty;
+    }
+    line->valid = 1;
+    line->tag = tag;
+    line->dirty = (type == CACHE_WRITE);
+    line->stamp = c->time;
+    return cycles;
+}
+
+static int cache_by_count(const void *a, const void *b) {
+    const struct cache_miss *first = a, *second = b;
+
+    if (first->count != second->count)
+        return first->count < second->count ? 1 : -1;
+    return first->pc < second->pc ? -1 : first->pc > second->pc;
+}
+
+void cache_report(cache c, FILE *f, int count) {
+    struct cache_miss *sorted;
+    uint64_t accesses, misses;
+    uint32_t i, j;
+
+    accesses = c->hits[CACHE_READ] + c->hits[CACHE_WRITE] + c->misses[CACHE_READ] +
+        c->misses[CACHE_WRITE];
+    misses = c->misses[CACHE_READ] + c->misses[CACHE_WRITE];
+    fprintf(f, "%s : %u bytes, %u ways, %u bytes lines, write %s, %s replacement\n", c->name,
+            c->size, c->ways, c->line_size, c->write_back ? "back" : "through",
+            c->replacement == LRU ? "lru" : c->replacement == FIFO ? "fifo" : "random");
+    fprintf(f, "  reads  : %" PRIu64 " hits, %" PRIu64 " misses\n", c->hits[CACHE_READ],
+            c->misses[CACHE_READ]);
+    fprintf(f, "  writes : %" PRIu64 " hits, %" PRIu64 " misses\n", c->hits[CACHE_WRITE],
+            c->misses[CACHE_WRITE]);
+    fprintf(f, "  miss rate %.2f%%, %" PRIu64 " writebacks\n",
+            accesses ? 100.0 * misses / accesses : 0.0, c->writebacks);
+    sorted = malloc((c->miss_pcs_used + 1) * sizeof(struct cache_miss));
+    error_if_null(sorted);
+    for (i = 0, j = 0; i < c->miss_pcs_size; i++)
+        if (c->miss_pcs[i].count)
+            sorted[j++] = c->miss_pcs[i];
+    qsort(sorted, c->miss_pcs_used, sizeof(struct cache_miss), cache_by_count);
+    if (c->miss_pcs_used)
+        fprintf(f, "  misses by pc :\n");
+    for (i = 0; (i < c->miss_pcs_used) && (i < count); i++)
+        fprintf(f, "    %08X %10u\n", sorted[i].pc, sorted[i].count);
+    free(sorted);
+}
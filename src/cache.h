@@ -0,0 +1,52 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __CACHE_H__
+#define __CACHE_H__
+#include <stdio.h>
+#include <stdint.h>
+
+/* Set associative cache model, only the tags are simulated : each access is
+ * a hit or a miss, misses cost extra cycles and are counted per PC of the
+ * accessing instruction. The configuration is a comma separated list of
+ * key=value among :
+ * size=bytes (k suffix allowed), ways=number, line=bytes,
+ * write=back|through, replace=lru|fifo|random, penalty=cycles
+ * by default size=16k,ways=4,line=32,write=back,replace=lru,penalty=10
+ * Write back caches allocate on write misses and pay the penalty again to
+ * evict dirty lines, write through caches do not allocate on write misses.
+ */
+#define CACHE_READ 0
+#define CACHE_WRITE 1
+
+typedef struct cache_data *cache;
+
+cache cache_create(char *name, char *configuration);
+void cache_destroy(cache c);
+
+/* Extra cycles taken by the access */
+uint32_t cache_access(cache c, uint32_t pc, uint32_t address, int type);
+
+/* Counters and the count instructions missing the most */
+void cache_report(cache c, FILE * f, int count);
+
+#endif
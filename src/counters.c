@@ -0,0 +1,119 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "counters.h"
+#include "util.h"
+
+/* Counters are only appended, at the tail, so that the list can be walked
+ * while counters are added
+ */
+static struct counter *first = NULL;
+static struct counter *last = NULL;
+
+void counters_add(char *name, char *labels, char *help, int type, uint64_t *value) {
+    struct counter *c;
+
+    c = malloc(sizeof(struct counter));
+    error_if_null(c);
+    c->name = strdup(name);
+    c->labels = labels ? strdup(labels) : NULL;
+    c->help = help;
+    c->type = type;
+    c->value = value;
+    c->next = NULL;
+    if (last)
+        last->next = c;
+    else
+        first = c;
+    last = c;
+}
+
+struct counter *counters_first() {
+    return first;
+}
+
+struct counter *counters_find(char *name, char *labels) {
+    struct counter *c;
+
+    for (c = first; c; c = c->next) {
+        if ((strcmp(c->name, name) == 0) &&
+            ((labels == NULL) ? (c->labels == NULL) :
+             ((c->labels != NULL) && (strcmp(c->labels, labels) == 0))))
+            return c;
+    }
+    return NULL;
+}
+
+void counters_dump(FILE *f) {
+    struct counter *c;
+
+    for (c = first; c; c = c->next) {
+        if (c->labels)
+            fprintf(f, "%s{%s} %" PRIu64 "\n", c->name, c->labels, *c->value);
+        else
+            fprintf(f, "%s %" PRIu64 "\n", c->name, *c->value);
+    }
+}
+
+void counters_write_prometheus(FILE *f) {
+    struct counter *c, *other;
+
+    for (c = first; c; c = c->next) {
+        for (other = first; (other != c) && strcmp(other->name, c->name); other = other->next);
+        /* Already written with the first counter of the same name */
+        if (other != c)
+            continue;
+        fprintf(f, "# HELP %s %s\n", c->name, c->help);
+        fprintf(f, "# TYPE %s %s\n", c->name, c->type == COUNTER ? "counter" : "gauge");
+        for (other = c; other; other = other->next) {
+            if (strcmp(other->name, c->name))
+                continue;
+            if (other->labels)
+                fprintf(f, "%s{%s} %" PRIu64 "\n", other->name, other->labels, *other->value);
+            else
+                fprintf(f, "%s %" PRIu64 "\n", other->name, *other->value);
+        }
+    }
+}
+
+void counters_reset() {
+    struct counter *c;
+
+    for (c = first; c; c = c->next)
+        if (c->type == COUNTER)
+            *c->value = 0;
+}
+
+void counters_clear() {
+    struct counter *c, *next;
+
+    for (c = first; c; c = next) {
+        next = c->next;
+        free(c->name);
+        free(c->labels);
+        free(c);
+    }
+    first = last = NULL;
+}
@@ -0,0 +1,58 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __COUNTERS_H__
+#define __COUNTERS_H__
+#include <stdio.h>
+#include <stdint.h>
+
+/* Registry of the named counters exported by the instrumentation modules, so
+ * that they can be listed, read and reset at runtime. A counter is identified
+ * by its name and its labels (as in name{labels}, labels may be NULL), its
+ * value stays owned by the module that registered it.
+ */
+#define COUNTER 0
+#define GAUGE 1
+
+struct counter {
+    char *name;
+    char *labels;
+    char *help;
+    int type;
+    uint64_t *value;
+    struct counter *next;
+};
+
+void counters_add(char *name, char *labels, char *help, int type, uint64_t * value);
+struct counter *counters_first();
+struct counter *counters_find(char *name, char *labels);
+/* One "name{labels} value" line per counter */
+void counters_dump(FILE * f);
+/* Prometheus text exposition format : the HELP and TYPE lines of a name are
+ * followed by all the samples of this name
+ */
+void counters_write_prometheus(FILE * f);
+/* Zeroes the counters, gauges are left untouched */
+void counters_reset();
+void counters_clear();
+
+#endif
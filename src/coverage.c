@@ -0,0 +1,266 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "coverage.h"
+#include "util.h"
+
+#define COVERAGE_MAGIC "ARMCOV1"
+/* Longest range of addresses given to a single row of the line table */
+#define MAX_LINE_RANGE 0x10000
+
+enum { EXECUTED, PASSED, FAILED, BITMAPS };
+
+int coverage_enabled = 0;
+static uint32_t words;
+static uint8_t *bitmaps[BITMAPS];
+
+/* One line of the lcov report, gathering the instructions of its rows */
+struct lcov_line {
+    char *file;
+    int line;
+    int hit, passed, failed;
+};
+
+int coverage_enable(uint32_t memory_size) {
+    int i;
+
+    words = memory_size / 4;
+    for (i = 0; i < BITMAPS; i++) {
+        bitmaps[i] = calloc((words + 7) / 8, 1);
+        if (bitmaps[i] == NULL)
+            return -1;
+    }
+    coverage_enabled = 1;
+    return 0;
+}
+
+void coverage_disable() {
+    int i;
+
+    for (i = 0; i < BITMAPS; i++) {
+        free(bitmaps[i]);
+        bitmaps[i] = NULL;
+    }
+    coverage_enabled = 0;
+}
+
+static int coverage_bit(int bitmap, uint32_t address) {
+    uint32_t word = address / 4;
+
+    return (word < words) && (bitmaps[bitmap][word / 8] & (1 << (word % 8)));
+}
+
+void coverage_record(arm_core p, int executed) {
+    uint32_t word, condition;
+
+    word = p->current_address / 4;
+    if (word >= words)
+        return;
+    bitmaps[EXECUTED][word / 8] |= 1 << (word % 8);
+    condition = get_bits(p->current_instruction, 31, 28);
+    if (condition < 0xE)
+        bitmaps[executed ? PASSED : FAILED][word / 8] |= 1 << (word % 8);
+}
+
+int coverage_write(char *filename) {
+    FILE *f;
+    int i, result = 0;
+
+    f = fopen(filename, "w");
+    if (f == NULL)
+        return -1;
+    fprintf(f, "%s %u\n", COVERAGE_MAGIC, words);
+    for (i = 0; i < BITMAPS; i++)
+        if (fwrite(bitmaps[i], 1, (words + 7) / 8, f) != (words + 7) / 8)
+            result = -1;
+    if (fclose(f) != 0)
+        result = -1;
+    return result;
+}
+
+static FILE *coverage_open(char *filename, uint32_t *file_words) {
+    FILE *f;
+
+    f = fopen(filename, "r");
+    if (f == NULL)
+        return NULL;
+    if ((fscanf(f, COVERAGE_MAGIC " %u", file_words) != 1) || (fgetc(f) != '\n')) {
+        fclose(f);
+        return NULL;
+    }
+    return f;
+}
+
+uint32_t coverage_file_words(char *filename) {
+    uint32_t result;
+    FILE *f;
+
+    f = coverage_open(filename, &result);
+    if (f == NULL)
+        return 0;
+    fclose(f);
+    return result;
+}
+
+/* Files covering more memory than the current one are cut */
+int coverage_merge(char *filename) {
+    uint32_t file_words, bytes, file_bytes, i;
+    uint8_t *buffer;
+    FILE *f;
+    int b, result = 0;
+
+    if (!coverage_enabled)
+        return -1;
+    f = coverage_open(filename, &file_words);
+    if (f == NULL)
+        return -1;
+    bytes = (words + 7) / 8;
+    file_bytes = (file_words + 7) / 8;
+    buffer = malloc(file_bytes);
+    error_if_null(buffer);
+    for (b = 0; (b < BITMAPS) && (result == 0); b++) {
+        if (fread(buffer, 1, file_bytes, f) != file_bytes) {
+            result = -1;
+            break;
+        }
+        for (i = 0; (i < file_bytes) && (i < bytes); i++)
+            bitmaps[b][i] |= buffer[i];
+    }
+    free(buffer);
+    fclose(f);
+    return result;
+}
+
+static int lcov_line_compare(const void *a, const void *b) {
+    const struct lcov_line *first = a, *second = b;
+    int result = strcmp(first->file, second->file);
+
+    return result ? result : first->line - second->line;
+}
+
+/* Lines of the line table, sorted by file and line, each once */
+static struct lcov_line *coverage_lines(elf_reader elf, int *number) {
+    struct lcov_line *lines;
+    struct elf_line *row;
+    uint32_t address, end;
+    int i, count = 0;
+
+    lines = malloc((elf_reader_lines_number(elf) + 1) * sizeof(struct lcov_line));
+    error_if_null(lines);
+    for (i = 0; i < elf_reader_lines_number(elf); i++) {
+        row = elf_reader_line(elf, i);
+        if (row->line == 0)
+            continue;
+        end = (i + 1 < elf_reader_lines_number(elf)) ? elf_reader_line(elf, i + 1)->address :
+            row->address + 4;
+        if (end - row->address > MAX_LINE_RANGE)
+            end = row->address + MAX_LINE_RANGE;
+        lines[count].file = row->file;
+        lines[count].line = row->line;
+        lines[count].hit = lines[count].passed = lines[count].failed = 0;
+        for (address = row->address & ~3; address < end; address += 4) {
+            lines[count].hit |= coverage_bit(EXECUTED, address);
+            lines[count].passed |= coverage_bit(PASSED, address);
+            lines[count].failed |= coverage_bit(FAILED, address);
+        }
+        count++;
+    }
+    qsort(lines, count, sizeof(struct lcov_line), lcov_line_compare);
+    *number = 0;
+    for (i = 0; i < count; i++) {
+        if ((*number > 0) && !lcov_line_compare(&lines[*number - 1], &lines[i])) {
+            lines[*number - 1].hit |= lines[i].hit;
+            lines[*number - 1].passed |= lines[i].passed;
+            lines[*number - 1].failed |= lines[i].failed;
+        } else {
+            lines[(*number)++] = lines[i];
+        }
+    }
+    return lines;
+}
+
+/* Functions of the given file (any when file is NULL), declared at their line */
+static void coverage_write_functions(FILE *f, elf_reader elf, char *file) {
+    struct elf_symbol *symbol;
+    struct elf_line *row;
+    int i, index, line, found = 0, hit = 0;
+
+    for (i = 0; i < elf_reader_symbols_number(elf); i++) {
+        symbol = elf_reader_symbol(elf, i);
+        index = elf_reader_find_line(elf, symbol->address);
+        row = index == -1 ? NULL : elf_reader_line(elf, index);
+        if (file && ((row == NULL) || (row->line == 0) || strcmp(row->file, file)))
+            continue;
+        line = row ? row->line : 0;
+        fprintf(f, "FN:%d,%s\n", line, symbol->name);
+    }
+    for (i = 0; i < elf_reader_symbols_number(elf); i++) {
+        symbol = elf_reader_symbol(elf, i);
+        index = elf_reader_find_line(elf, symbol->address);
+        row = index == -1 ? NULL : elf_reader_line(elf, index);
+        if (file && ((row == NULL) || (row->line == 0) || strcmp(row->file, file)))
+            continue;
+        fprintf(f, "FNDA:%d,%s\n", coverage_bit(EXECUTED, symbol->address), symbol->name);
+        found++;
+        hit += coverage_bit(EXECUTED, symbol->address);
+    }
+    fprintf(f, "FNF:%d\nFNH:%d\n", found, hit);
+}
+
+void coverage_write_lcov(FILE *f, elf_reader elf, char *elf_name) {
+    struct lcov_line *lines;
+    int number, first, i, branches, branches_hit, lines_hit;
+
+    if (!coverage_enabled)
+        return;
+    fprintf(f, "TN:\n");
+    if (elf_reader_lines_number(elf) == 0) {
+        fprintf(f, "SF:%s\n", elf_name);
+        coverage_write_functions(f, elf, NULL);
+        fprintf(f, "end_of_record\n");
+        return;
+    }
+    lines = coverage_lines(elf, &number);
+    for (first = 0; first < number; first = i) {
+        fprintf(f, "%sSF:%s\n", first ? "TN:\n" : "", lines[first].file);
+        coverage_write_functions(f, elf, lines[first].file);
+        branches = branches_hit = 0;
+        for (i = first; (i < number) && !strcmp(lines[i].file, lines[first].file); i++) {
+            if (lines[i].passed || lines[i].failed) {
+                fprintf(f, "BRDA:%d,0,0,%d\nBRDA:%d,0,1,%d\n", lines[i].line, lines[i].passed,
+                        lines[i].line, lines[i].failed);
+                branches += 2;
+                branches_hit += lines[i].passed + lines[i].failed;
+            }
+        }
+        fprintf(f, "BRF:%d\nBRH:%d\n", branches, branches_hit);
+        lines_hit = 0;
+        for (i = first; (i < number) && !strcmp(lines[i].file, lines[first].file); i++) {
+            fprintf(f, "DA:%d,%d\n", lines[i].line, lines[i].hit);
+            lines_hit += lines[i].hit;
+        }
+        fprintf(f, "LF:%d\nLH:%d\nend_of_record\n", i - first, lines_hit);
+    }
+    free(lines);
+}
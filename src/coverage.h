@@ -0,0 +1,62 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __COVERAGE_H__
+#define __COVERAGE_H__
+#include <stdio.h>
+#include <stdint.h>
+#include "arm_core.h"
+#include "elf_reader.h"
+
+/* Address level code coverage : one bit per word of memory telling whether
+ * the instruction at this address has been executed (or skipped by its
+ * condition) and, for conditional instructions, one bit for each outcome of
+ * the condition. Coverage files merge by a bitwise or of their bitmaps.
+ *
+ * Raw format : a "ARMCOV1 <words>\n" text line, followed by the executed,
+ * condition passed and condition failed bitmaps, of (words + 7) / 8 bytes
+ * each. Bit i of byte j stands for the word at address 4 * (8 * j + i).
+ */
+int coverage_enable(uint32_t memory_size);
+void coverage_disable();
+
+/* To be called after each fetched instruction, executed or not. Without
+ * coverage, it costs the inline test of coverage_enabled.
+ */
+extern int coverage_enabled;
+void coverage_record(arm_core p, int executed);
+#define coverage_instruction(p, executed) \
+    do { if (coverage_enabled) coverage_record(p, executed); } while (0)
+
+/* Return -1 on error, merging requires enabled coverage and ors into it */
+int coverage_write(char *filename);
+int coverage_merge(char *filename);
+/* Words covered by a raw coverage file, 0 on error */
+uint32_t coverage_file_words(char *filename);
+
+/* lcov tracefile : lines (DA), conditions of the lines as branches (BRDA),
+ * taken meaning condition passed, and functions (FN, FNDA). Without line
+ * table, only the functions are reported, in a record of the ELF file.
+ */
+void coverage_write_lcov(FILE * f, elf_reader elf, char *elf_name);
+
+#endif
@@ -0,0 +1,111 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+#include "coverage.h"
+#include "elf_reader.h"
+
+/* Merges raw coverage files written by arm_simulator --coverage, by a bitwise
+ * or of their bitmaps, and optionally writes the lcov tracefile of the result
+ */
+void usage(char *name) {
+    fprintf(stderr, "Usage:\n"
+            "%s [ --help ] [ --lcov file --elf elf_file ] output input ...\n\n"
+            "Merges the given raw coverage files into output and, when the lcov"
+            " switch is given, writes the merged coverage as an lcov tracefile"
+            " using the symbols and the line table of the ELF file.\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    struct option longopts[] = {
+        { "lcov", required_argument, NULL, 'l' },
+        { "elf", required_argument, NULL, 'e' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    char *lcov = NULL, *elf_file = NULL;
+    uint32_t words, max_words = 0;
+    elf_reader elf;
+    FILE *f;
+    int opt, i;
+
+    while ((opt = getopt_long(argc, argv, "l:e:h", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'l':
+            lcov = optarg;
+            break;
+        case 'e':
+            elf_file = optarg;
+            break;
+        case 'h':
+            usage(argv[0]);
+            exit(0);
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if ((argc - optind < 2) || ((lcov == NULL) != (elf_file == NULL))) {
+        usage(argv[0]);
+        exit(1);
+    }
+    for (i = optind + 1; i < argc; i++) {
+        words = coverage_file_words(argv[i]);
+        if (words == 0) {
+            fprintf(stderr, "%s is not a coverage file\n", argv[i]);
+            exit(1);
+        }
+        if (words > max_words)
+            max_words = words;
+    }
+    if (coverage_enable(4 * max_words) == -1) {
+        fprintf(stderr, "Cannot allocate the coverage bitmaps\n");
+        exit(1);
+    }
+    for (i = optind + 1; i < argc; i++) {
+        if (coverage_merge(argv[i]) == -1) {
+            fprintf(stderr, "Cannot read coverage file %s\n", argv[i]);
+            exit(1);
+        }
+    }
+    if (coverage_write(argv[optind]) == -1) {
+        perror(argv[optind]);
+        exit(1);
+    }
+    if (lcov) {
+        elf = elf_reader_open(elf_file);
+        if (elf == NULL)
+            exit(1);
+        f = fopen(lcov, "w");
+        if (f == NULL) {
+            perror(lcov);
+            exit(1);
+        }
+        coverage_write_lcov(f, elf, elf_file);
+        fclose(f);
+        elf_reader_close(elf);
+    }
+    coverage_disable();
+    return 0;
+}
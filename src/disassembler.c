@@ -0,0 +1,289 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <string.h>
+#include "disassembler.h"
+#include "arm_constants.h"
+#include "util.h"
+
+static char *conditions[] = { "eq", "ne", "cs", "cc", "mi", "pl", "vs", "vc",
+    "hi", "ls", "ge", "lt", "gt", "le", "", ""
+};
+
+static char *opcodes[] = { "and", "eor", "sub", "rsb", "add", "adc", "sbc", "rsc",
+    "tst", "teq", "cmp", "cmn", "orr", "mov", "bic", "mvn"
+};
+
+static char *registers[] = { "r0", "r1", "r2", "r3", "r4", "r5", "r6", "r7",
+    "r8", "r9", "r10", "r11", "r12", "sp", "lr", "pc"
+};
+
+static char *shifts[] = { "lsl", "lsr", "asr", "ror" };
+
+static char *multiple_modes[] = { "da", "ia", "db", "ib" };
+
+#define reg(ins, h, l) registers[get_bits(ins, h, l)]
+#define cond(ins) conditions[get_bits(ins, 31, 28)]
+
+/* Rotated immediate operand of data processing instructions */
+static uint32_t immediate(uint32_t ins) {
+    uint32_t rotation = 2 * get_bits(ins, 11, 8);
+
+    return rotation ? ror(get_bits(ins, 7, 0), rotation) : get_bits(ins, 7, 0);
+}
+
+/* Register operand with its immediate or register shift */
+static int shifted_register(uint32_t ins, char *buffer, int size) {
+    uint32_t shift = get_bits(ins, 6, 5), amount = get_bits(ins, 11, 7);
+
+    if (get_bit(ins, 4))
+        return snprintf(buffer, size, "%s, %s %s", reg(ins, 3, 0), shifts[shift],
+                        reg(ins, 11, 8));
+    if ((shift == LSL) && (amount == 0))
+        return snprintf(buffer, size, "%s", reg(ins, 3, 0));
+    if ((shift == ROR) && (amount == 0))
+        return snprintf(buffer, size, "%s, rrx", reg(ins, 3, 0));
+    if (amount == 0)
+        amount = 32;
+    return snprintf(buffer, size, "%s, %s #%u", reg(ins, 3, 0), shifts[shift], amount);
+}
+
+static void data_processing(uint32_t ins, char *buffer, int size) {
+    uint32_t opcode = get_bits(ins, 24, 21);
+    char operand[32];
+    int n;
+
+    if (get_bit(ins, 25))
+        snprintf(operand, sizeof(operand), "#%u", immediate(ins));
+    else
+        shifted_register(ins, operand, sizeof(operand));
+    n = snprintf(buffer, size, "%s%s", opcodes[opcode], cond(ins));
+    if ((opcode >= TST) && (opcode <= CMN))
+        snprintf(buffer + n, size - n, " %s, %s", reg(ins, 19, 16), operand);
+    else if ((opcode == MOV) || (opcode == MVN))
+        snprintf(buffer + n, size - n, "%s %s, %s", get_bit(ins, 20) ? "s" : "",
+                 reg(ins, 15, 12), operand);
+    else
+        snprintf(buffer + n, size - n, "%s %s, %s, %s", get_bit(ins, 20) ? "s" : "",
+                 reg(ins, 15, 12), reg(ins, 19, 16), operand);
+}
+
+static void status_register(uint32_t ins, char *buffer, int size) {
+    char fields[5];
+    int i, n = 0;
+
+    if (get_bit(ins, 21) == 0) {
+        snprintf(buffer, size, "mrs%s %s, %s", cond(ins), reg(ins, 15, 12),
+                 get_bit(ins, 22) ? "spsr" : "cpsr");
+        return;
+    }
+    for (i = 0; i < 4; i++)
+        if (get_bit(ins, 16 + i))
+            fields[n++] = "cxsf"[i];
+    fields[n] = '\0';
+    if (get_bit(ins, 25))
+        snprintf(buffer, size, "msr%s %s_%s, #%u", cond(ins), get_bit(ins, 22) ? "spsr" : "cpsr",
+                 fields, immediate(ins));
+    else
+        snprintf(buffer, size, "msr%s %s_%s, %s", cond(ins), get_bit(ins, 22) ? "spsr" : "cpsr",
+                 fields, reg(ins, 3, 0));
+}
+
+/* Addressing mode of word/byte and halfword transfers, the offset being already
+ * formatted
+ */
+static void addressing(uint32_t ins, char *offset, char *buffer, int size) {
+    if (get_bit(ins, 24))
+        snprintf(buffer, size, "[%s%s%s]%s", reg(ins, 19, 16), *offset ? ", " : "", offset,
+                 get_bit(ins, 21) ? "!" : "");
+    else
+        snprintf(buffer, size, "[%s]%s%s", reg(ins, 19, 16), *offset ? ", " : "", offset);
+}
+
+static void load_store(uint32_t ins, char *buffer, int size) {
+    char offset[32], address[48];
+    char *sign = get_bit(ins, 23) ? "" : "-";
+
+    if (get_bit(ins, 25)) {
+        snprintf(offset, sizeof(offset), "%s", sign);
+        shifted_register(ins & ~(1 << 4), offset + strlen(sign), sizeof(offset) - 1);
+    } else if (get_bits(ins, 11, 0) || !get_bit(ins, 23)) {
+        snprintf(offset, sizeof(offset), "#%s%u", sign, get_bits(ins, 11, 0));
+    } else {
+        offset[0] = '\0';
+    }
+    addressing(ins, offset, address, sizeof(address));
+    snprintf(buffer, size, "%s%s%s%s %s, %s", get_bit(ins, 20) ? "ldr" : "str", cond(ins),
+             get_bit(ins, 22) ? "b" : "", (!get_bit(ins, 24) && get_bit(ins, 21)) ? "t" : "",
+             reg(ins, 15, 12), address);
+}
+
+static void load_store_halfword(uint32_t ins, char *buffer, int size) {
+    static char *types[] = { "", "h", "sb", "sh" };
+    char offset[32], address[48];
+    char *sign = get_bit(ins, 23) ? "" : "-";
+    uint32_t immediate = (get_bits(ins, 11, 8) << 4) | get_bits(ins, 3, 0);
+
+    if (!get_bit(ins, 22))
+        snprintf(offset, sizeof(offset), "%s%s", sign, reg(ins, 3, 0));
+    else if (immediate || !get_bit(ins, 23))
+        snprintf(offset, sizeof(offset), "#%s%u", sign, immediate);
+    else
+        offset[0] = '\0';
+    addressing(ins, offset, address, sizeof(address));
+    snprintf(buffer, size, "%s%s%s %s, %s", get_bit(ins, 20) ? "ldr" : "str", cond(ins),
+             types[get_bits(ins, 6, 5)], reg(ins, 15, 12), address);
+}
+
+static void load_store_multiple(uint32_t ins, char *buffer, int size) {
+    int i, n, first = 1;
+
+    n = snprintf(buffer, size, "%s%s%s %s%s, {", get_bit(ins, 20) ? "ldm" : "stm", cond(ins),
+                 multiple_modes[get_bits(ins, 24, 23)], reg(ins, 19, 16),
+                 get_bit(ins, 21) ? "!" : "");
+    for (i = 0; (i < 16) && (n < size); i++) {
+        if (get_bit(ins, i)) {
+            n += snprintf(buffer + n, size - n, "%s%s", first ? "" : ", ", registers[i]);
+            first = 0;
+        }
+    }
+    if (n < size)
+        snprintf(buffer + n, size - n, "}%s", get_bit(ins, 22) ? "^" : "");
+}
+
+static void multiply(uint32_t ins, char *buffer, int size) {
+    static char *long_names[] = { "umull", "umlal", "smull", "smlal" };
+    char *s = get_bit(ins, 20) ? "s" : "";
+
+    if (get_bit(ins, 23))
+        snprintf(buffer, size, "%s%s%s %s, %s, %s, %s", long_names[get_bits(ins, 22, 21)],
+                 cond(ins), s, reg(ins, 15, 12), reg(ins, 19, 16), reg(ins, 3, 0),
+                 reg(ins, 11, 8));
+    else if (get_bit(ins, 21))
+        snprintf(buffer, size, "mla%s%s %s, %s, %s, %s", cond(ins), s, reg(ins, 19, 16),
+                 reg(ins, 3, 0), reg(ins, 11, 8), reg(ins, 15, 12));
+    else
+        snprintf(buffer, size, "mul%s%s %s, %s, %s", cond(ins), s, reg(ins, 19, 16),
+                 reg(ins, 3, 0), reg(ins, 11, 8));
+}
+
+static uint32_t branch_target(uint32_t address, uint32_t ins) {
+    return address + 8 + (asr(get_bits(ins, 23, 0) << 8, 8) << 2);
+}
+
+char *arm_disassemble(uint32_t address, uint32_t ins, char *buffer, int size) {
+    if (get_bits(ins, 31, 28) == 0xF) {
+        if (get_bits(ins, 27, 25) == 0b101)
+            snprintf(buffer, size, "blx 0x%08x",
+                     branch_target(address, ins) + (get_bit(ins, 24) << 1));
+        else
+            snprintf(buffer, size, ".word 0x%08x", ins);
+        return buffer;
+    }
+    switch (get_bits(ins, 27, 25)) {
+    case 0b000:
+        if ((ins & 0x0FFFFFD0) == 0x012FFF10)
+            snprintf(buffer, size, "%s%s %s", get_bit(ins, 5) ? "blx" : "bx", cond(ins),
+                     reg(ins, 3, 0));
+        else if ((ins & 0x0F0000F0) == 0x00000090)
+            multiply(ins, buffer, size);
+        else if ((ins & 0x0FB00FF0) == 0x01000090)
+            snprintf(buffer, size, "swp%s%s %s, %s, [%s]", cond(ins), get_bit(ins, 22) ? "b" : "",
+                     reg(ins, 15, 12), reg(ins, 3, 0), reg(ins, 19, 16));
+        else if ((ins & 0x0FFF0FF0) == 0x016F0F10)
+            snprintf(buffer, size, "clz%s %s, %s", cond(ins), reg(ins, 15, 12), reg(ins, 3, 0));
+        else if ((ins & 0x0F900000) == 0x01000000 && !get_bit(ins, 7) && !get_bit(ins, 4))
+            status_register(ins, buffer, size);
+        else if (get_bit(ins, 7) && get_bit(ins, 4))
+            load_store_halfword(ins, buffer, size);
+        else
+            data_processing(ins, buffer, size);
+        break;
+    case 0b001:
+        if ((ins & 0x0FB00000) == 0x03200000)
+            status_register(ins, buffer, size);
+        else
+            data_processing(ins, buffer, size);
+        break;
+    case 0b011:
+        if (get_bit(ins, 4)) {
+            snprintf(buffer, size, ".word 0x%08x", ins);
+            break;
+        }
+        /* Fall through */
+    case 0b010:
+        load_store(ins, buffer, size);
+        break;
+    case 0b100:
+        load_store_multiple(ins, buffer, size);
+        break;
+    case 0b101:
+        snprintf(buffer, size, "b%s%s 0x%08x", get_bit(ins, 24) ? "l" : "", cond(ins),
+                 branch_target(address, ins));
+        break;
+    default:
+        if (get_bits(ins, 27, 24) == 0xF)
+            snprintf(buffer, size, "swi%s 0x%06x", cond(ins), get_bits(ins, 23, 0));
+        else
+            snprintf(buffer, size, "coprocessor%s 0x%08x", cond(ins), ins);
+    }
+    return buffer;
+}
+
+int arm_is_control_transfer(uint32_t ins) {
+    uint32_t opcode;
+
+    if (get_bits(ins, 31, 28) == 0xF)
+        return get_bits(ins, 27, 25) == 0b101;
+    switch (get_bits(ins, 27, 25)) {
+    case 0b000:
+        if ((ins & 0x0FFFFFD0) == 0x012FFF10)
+            return 1;
+        if (get_bit(ins, 7) && get_bit(ins, 4))
+            /* Multiplies and swaps do not write the PC, halfword loads may */
+            return ((ins & 0x0F0000F0) != 0x00000090) && get_bit(ins, 20) &&
+                (get_bits(ins, 15, 12) == 15);
+        /* Fall through */
+    case 0b001:
+        opcode = get_bits(ins, 24, 21);
+        if ((opcode >= TST) && (opcode <= CMN))
+            return 0;
+        return get_bits(ins, 15, 12) == 15;
+    case 0b010:
+    case 0b011:
+        return get_bit(ins, 20) && (get_bits(ins, 15, 12) == 15);
+    case 0b100:
+        return get_bit(ins, 20) && get_bit(ins, 15);
+    case 0b101:
+        return 1;
+    default:
+        return get_bits(ins, 27, 24) == 0xF;
+    }
+}
+
+int arm_is_return(uint32_t ins) {
+    return ((ins & 0x0FFFFFFF) == 0x01A0F00E) ||        /* mov pc, lr */
+        ((ins & 0x0FFFFFFF) == 0x012FFF1E) ||   /* bx lr */
+        ((ins & 0x0E108000) == 0x08108000) ||   /* ldm ..., {..., pc} */
+        ((ins & 0x0C10F000) == 0x0410F000);     /* ldr pc, ... */
+}
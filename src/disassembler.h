@@ -0,0 +1,42 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __DISASSEMBLER_H__
+#define __DISASSEMBLER_H__
+#include <stdint.h>
+
+/* Textual form, in the usual assembler syntax, of the ARM instruction found
+ * at the given address (needed for branch targets), written into buffer
+ */
+char *arm_disassemble(uint32_t address, uint32_t instruction, char *buffer, int size);
+
+/* Non zero when the instruction may change the flow of control (branches,
+ * software interrupts and any instruction writing the PC), so ends a basic
+ * block
+ */
+int arm_is_control_transfer(uint32_t instruction);
+/* Non zero for the usual function returns : mov pc, lr, bx lr, and loads of
+ * the PC (ldm ..., {..., pc} and ldr pc, ...)
+ */
+int arm_is_return(uint32_t instruction);
+
+#endif
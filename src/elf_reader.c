@@ -0,0 +1,722 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <elf.h>
+#include "elf_reader.h"
+#include "util.h"
+
+/* DWARF constants of the line table */
+#define DW_LNS_copy 1
+#define DW_LNS_advance_pc 2
+#define DW_LNS_advance_line 3
+#define DW_LNS_set_file 4
+#define DW_LNS_const_add_pc 8
+#define DW_LNS_fixed_advance_pc 9
+#define DW_LNE_end_sequence 1
+#define DW_LNE_set_address 2
+#define DW_LNCT_path 1
+#define DW_LNCT_directory_index 2
+#define DW_FORM_block 0x09
+#define DW_FORM_data1 0x0b
+#define DW_FORM_data2 0x05
+#define DW_FORM_data4 0x06
+#define DW_FORM_data8 0x07
+#define DW_FORM_data16 0x1e
+#define DW_FORM_string 0x08
+#define DW_FORM_strp 0x0e
+#define DW_FORM_udata 0x0f
+#define DW_FORM_line_strp 0x1f
+
+struct elf_reader_data {
+    uint8_t *content;
+    size_t size;
+    int big_endian;
+    struct elf_symbol *symbols;
+    int symbols_number;
+    struct elf_line *lines;
+    int lines_number, lines_size;
+    /* File names of the line table, built from their directory and name */
+    char **files;
+    int files_number, files_size;
+    struct elf_segment *segments;
+    int segments_number;
+};
+
+/* Cursor over a DWARF section */
+struct dwarf_cursor {
+    elf_reader e;
+    uint8_t *position, *end;
+};
+
+/* Sections used by the line table, NULL when missing */
+struct dwarf_sections {
+    uint8_t *line_str, *str;
+    uint32_t line_str_size, str_size;
+};
+
+/* Line table header, for a sequence of line programs */
+struct dwarf_line_header {
+    int version;
+    uint8_t minimum_instruction_length, default_is_stmt, line_range, opcode_base;
+    int8_t line_base;
+    uint8_t *standard_opcode_lengths;
+    char **directories, **files;
+    int directories_number, files_number;
+};
+
+static uint16_t elf_half(elf_reader e, uint16_t value) {
+    return e->big_endian != is_big_endian() ? reverse_2(value) : value;
+}
+
+static uint32_t elf_word(elf_reader e, uint32_t value) {
+    return e->big_endian != is_big_endian() ? reverse_4(value) : value;
+}
+
+static int elf_symbol_compare(const void *a, const void *b) {
+    const struct elf_symbol *first = a, *second = b;
+
+    if (first->address != second->address)
+        return first->address < second->address ? -1 : 1;
+    /* Symbols with a size first, they are more precise */
+    return second->size < first->size ? -1 : second->size > first->size;
+}
+
+/* Keeps functions and global code labels (entry points of assembly sources),
+ * drops local labels and mapping symbols ($a, $d, $t), which do not name
+ * functions
+ */
+static int elf_is_code_symbol(elf_reader e, Elf32_Sym *symbol, Elf32_Shdr *sections,
+                              int sections_number, char *name) {
+    int type = ELF32_ST_TYPE(symbol->st_info);
+    uint16_t section = elf_half(e, symbol->st_shndx);
+
+    if ((type != STT_FUNC) &&
+        ((type != STT_NOTYPE) || (ELF32_ST_BIND(symbol->st_info) == STB_LOCAL)))
+        return 0;
+    if ((name[0] == '\0') || (name[0] == '$'))
+        return 0;
+    if ((section == SHN_UNDEF) || (section >= sections_number))
+        return 0;
+    return (elf_word(e, sections[section].sh_flags) & SHF_EXECINSTR) != 0;
+}
+
+static int elf_load_symbols(elf_reader e) {
+    Elf32_Ehdr *header = (Elf32_Ehdr *) e->content;
+    Elf32_Shdr *sections, *strings;
+    Elf32_Sym *symbols;
+    uint32_t offset, count, i;
+    int sections_number, s;
+    char *name;
+
+    offset = elf_word(e, header->e_shoff);
+    sections_number = elf_half(e, header->e_shnum);
+    if (offset + sections_number * sizeof(Elf32_Shdr) > e->size)
+        return -1;
+    sections = (Elf32_Shdr *) (e->content + offset);
+    for (s = 0; s < sections_number; s++) {
+        if (elf_word(e, sections[s].sh_type) != SHT_SYMTAB)
+            continue;
+        strings = &sections[elf_word(e, sections[s].sh_link)];
+        symbols = (Elf32_Sym *) (e->content + elf_word(e, sections[s].sh_offset));
+        count = elf_word(e, sections[s].sh_size) / sizeof(Elf32_Sym);
+        if ((elf_word(e, sections[s].sh_offset) + count * sizeof(Elf32_Sym) > e->size) ||
+            (elf_word(e, strings->sh_offset) + elf_word(e, strings->sh_size) > e->size))
+            return -1;
+        e->symbols = malloc(count * sizeof(struct elf_symbol));
+        if (e->symbols == NULL)
+            return -1;
+        for (i = 0; i < count; i++) {
+            if (elf_word(e, symbols[i].st_name) >= elf_word(e, strings->sh_size))
+                continue;
+            name = (char *) e->content + elf_word(e, strings->sh_offset) +
+                elf_word(e, symbols[i].st_name);
+            if (elf_is_code_symbol(e, &symbols[i], sections, sections_number, name)) {
+                e->symbols[e->symbols_number].name = name;
+                e->symbols[e->symbols_number].address = elf_word(e, symbols[i].st_value);
+                e->symbols[e->symbols_number].size = elf_word(e, symbols[i].st_size);
+                e->symbols_number++;
+            }
+        }
+        qsort(e->symbols, e->symbols_number, sizeof(struct elf_symbol), elf_symbol_compare);
+        return 0;
+    }
+    return 0;
+}
+
+static int elf_load_segments(elf_reader e) {
+    Elf32_Ehdr *header = (Elf32_Ehdr *) e->content;
+    Elf32_Phdr *program_headers;
+    uint32_t offset, file_offset;
+    int headers_number, h;
+    struct elf_segment *segment;
+
+    offset = elf_word(e, header->e_phoff);
+    headers_number = elf_half(e, header->e_phnum);
+    if (headers_number == 0)
+        return 0;
+    if (offset + headers_number * sizeof(Elf32_Phdr) > e->size)
+        return -1;
+    program_headers = (Elf32_Phdr *) (e->content + offset);
+    e->segments = malloc(headers_number * sizeof(struct elf_segment));
+    if (e->segments == NULL)
+        return -1;
+    for (h = 0; h < headers_number; h++) {
+        if (elf_word(e, program_headers[h].p_type) != PT_LOAD)
+            continue;
+        segment = &e->segments[e->segments_number];
+        file_offset = elf_word(e, program_headers[h].p_offset);
+        segment->address = elf_word(e, program_headers[h].p_paddr);
+        segment->file_size = elf_word(e, program_headers[h].p_filesz);
+        segment->memory_size = elf_word(e, program_headers[h].p_memsz);
+        if ((file_offset + segment->file_size > e->size) ||
+            (segment->file_size > segment->memory_size))
+            return -1;
+        segment->content = e->content + file_offset;
+        e->segments_number++;
+    }
+    return 0;
+}
+
+static Elf32_Shdr *elf_find_section(elf_reader e, char *name) {
+    Elf32_Ehdr *header = (Elf32_Ehdr *) e->content;
+    Elf32_Shdr *sections, *names;
+    uint32_t offset, index;
+    int sections_number, s;
+
+    offset = elf_word(e, header->e_shoff);
+    sections_number = elf_half(e, header->e_shnum);
+    index = elf_half(e, header->e_shstrndx);
+    if ((offset + sections_number * sizeof(Elf32_Shdr) > e->size) || (index >= sections_number))
+        return NULL;
+    sections = (Elf32_Shdr *) (e->content + offset);
+    names = &sections[index];
+    for (s = 0; s < sections_number; s++) {
+        if (elf_word(e, sections[s].sh_name) >= elf_word(e, names->sh_size))
+            continue;
+        if (!strcmp((char *) e->content + elf_word(e, names->sh_offset) +
+                    elf_word(e, sections[s].sh_name), name)) {
+            if (elf_word(e, sections[s].sh_offset) + elf_word(e, sections[s].sh_size) > e->size)
+                return NULL;
+            return &sections[s];
+        }
+    }
+    return NULL;
+}
+
+static uint8_t *elf_section_content(elf_reader e, char *name, uint32_t *size) {
+    Elf32_Shdr *section = elf_find_section(e, name);
+
+    if (section == NULL)
+        return NULL;
+    *size = elf_word(e, section->sh_size);
+    return e->content + elf_word(e, section->sh_offset);
+}
+
+/* Readers of the DWARF encodings, reading 0 past the end */
+static uint64_t dwarf_bytes(struct dwarf_cursor *c, int size) {
+    uint64_t value = 0;
+    int i;
+
+    if (c->end - c->position < size) {
+        c->position = c->end;
+        return 0;
+    }
+    for (i = 0; i < size; i++) {
+        if (c->e->big_endian)
+            value = (value << 8) | c->position[i];
+        else
+            value |= (uint64_t) c->position[i] << (8 * i);
+    }
+    c->position += size;
+    return value;
+}
+
+static uint64_t dwarf_uleb128(struct dwarf_cursor *c) {
+    uint64_t value = 0;
+    int shift = 0;
+    uint8_t byte;
+
+    do {
+        if (c->position >= c->end)
+            return value;
+        byte = *c->position++;
+        if (shift < 64)
+            value |= (uint64_t) (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    return value;
+}
+
+static int64_t dwarf_sleb128(struct dwarf_cursor *c) {
+    int64_t value = 0;
+    int shift = 0;
+    uint8_t byte;
+
+    do {
+        if (c->position >= c->end)
+            return value;
+        byte = *c->position++;
+        if (shift < 64)
+            value |= (int64_t) (byte & 0x7F) << shift;
+        shift += 7;
+    } while (byte & 0x80);
+    if ((shift < 64) && (byte & 0x40))
+        value |= -((int64_t) 1 << shift);
+    return value;
+}
+
+static char *dwarf_string(struct dwarf_cursor *c) {
+    char *result = (char *) c->position;
+
+    while ((c->position < c->end) && *c->position)
+        c->position++;
+    if (c->position == c->end)
+        return "";
+    c->position++;
+    return result;
+}
+
+static char *dwarf_section_string(uint8_t *section, uint32_t size, uint32_t offset) {
+    if ((section == NULL) || (offset >= size) || (memchr(section + offset, 0, size - offset) == NULL))
+        return "";
+    return (char *) section + offset;
+}
+
+/* Directory or file entry of a DWARF 5 header, described by its format :
+ * only the path and the directory index are kept
+ */
+static void dwarf_entry(struct dwarf_cursor *c, struct dwarf_sections *s, uint64_t *format,
+                        int format_count, char **path, uint64_t *directory) {
+    uint64_t value;
+    char *string;
+    int i;
+
+    *path = "";
+    *directory = 0;
+    for (i = 0; i < format_count; i++) {
+        value = 0;
+        string = NULL;
+        switch (format[2 * i + 1]) {
+        case DW_FORM_string:
+            string = dwarf_string(c);
+            break;
+        case DW_FORM_line_strp:
+            string = dwarf_section_string(s->line_str, s->line_str_size, dwarf_bytes(c, 4));
+            break;
+        case DW_FORM_strp:
+            string = dwarf_section_string(s->str, s->str_size, dwarf_bytes(c, 4));
+            break;
+        case DW_FORM_udata:
+            value = dwarf_uleb128(c);
+            break;
+        case DW_FORM_data1:
+            value = dwarf_bytes(c, 1);
+            break;
+        case DW_FORM_data2:
+            value = dwarf_bytes(c, 2);
+            break;
+        case DW_FORM_data4:
+            value = dwarf_bytes(c, 4);
+            break;
+        case DW_FORM_data8:
+            value = dwarf_bytes(c, 8);
+            break;
+        case DW_FORM_data16:
+            c->position = c->end - c->position < 16 ? c->end : c->position + 16;
+            break;
+        case DW_FORM_block:
+            value = dwarf_uleb128(c);
+            c->position = c->end - c->position < value ? c->end : c->position + value;
+            break;
+        default:
+            /* Unknown form, the rest of the header cannot be read */
+            c->position = c->end;
+            return;
+        }
+        if ((format[2 * i] == DW_LNCT_path) && string)
+            *path = string;
+        else if (format[2 * i] == DW_LNCT_directory_index)
+            *directory = value;
+    }
+}
+
+static char *elf_add_file(elf_reader e, char *directory, char *name) {
+    char *result;
+
+    if (e->files_number == e->files_size) {
+        e->files_size = e->files_size ? 2 * e->files_size : 64;
+        e->files = realloc(e->files, e->files_size * sizeof(char *));
+        error_if_null(e->files);
+    }
+    result = malloc(strlen(directory) + strlen(name) + 2);
+    error_if_null(result);
+    if ((name[0] == '/') || (directory[0] == '\0'))
+        strcpy(result, name);
+    else
+        sprintf(result, "%s/%s", directory, name);
+    e->files[e->files_number++] = result;
+    return result;
+}
+
+/* Directories and files of the header, files get their full name */
+static int dwarf_read_entries(elf_reader e, struct dwarf_cursor *c, struct dwarf_sections *s,
+                              struct dwarf_line_header *h) {
+    uint64_t format[64], directory, count, i;
+    int format_count, j;
+    char *path;
+
+    if (h->version >= 5) {
+        format_count = dwarf_bytes(c, 1);
+        if (format_count > 32)
+            return -1;
+        for (j = 0; j < 2 * format_count; j++)
+            format[j] = dwarf_uleb128(c);
+        count = dwarf_uleb128(c);
+        h->directories = calloc(count + 1, sizeof(char *));
+        error_if_null(h->directories);
+        for (i = 0; (i < count) && (c->position < c->end); i++)
+            dwarf_entry(c, s, format, format_count, &h->directories[i], &directory);
+        h->directories_number = i;
+        format_count = dwarf_bytes(c, 1);
+        if (format_count > 32)
+            return -1;
+        for (j = 0; j < 2 * format_count; j++)
+            format[j] = dwarf_uleb128(c);
+        count = dwarf_uleb128(c);
+        h->files = calloc(count + 1, sizeof(char *));
+        error_if_null(h->files);
+        for (i = 0; (i < count) && (c->position < c->end); i++) {
+            dwarf_entry(c, s, format, format_count, &path, &directory);
+            h->files[i] = elf_add_file(e, directory < h->directories_number ?
+                                       h->directories[directory] : "", path);
+        }
+        h->files_number = i;
+        return 0;
+    }
+    /* Before version 5, index 0 is the compilation directory, unknown here,
+     * and files are numbered from 1
+     */
+    h->directories = calloc(1, sizeof(char *));
+    error_if_null(h->directories);
+    h->directories[0] = "";
+    h->directories_number = 1;
+    while ((c->position < c->end) && *(path = dwarf_string(c))) {
+        h->directories = realloc(h->directories, (h->directories_number + 1) * sizeof(char *));
+        error_if_null(h->directories);
+        h->directories[h->directories_number++] = path;
+    }
+    h->files = calloc(1, sizeof(char *));
+    error_if_null(h->files);
+    h->files[0] = "";
+    h->files_number = 1;
+    while ((c->position < c->end) && *(path = dwarf_string(c))) {
+        directory = dwarf_uleb128(c);
+        dwarf_uleb128(c);       /* modification time */
+        dwarf_uleb128(c);       /* length */
+        h->files = realloc(h->files, (h->files_number + 1) * sizeof(char *));
+        error_if_null(h->files);
+        h->files[h->files_number++] = elf_add_file(e, directory < h->directories_number ?
+                                                   h->directories[directory] : "", path);
+    }
+    return 0;
+}
+
+static void elf_add_line(elf_reader e, uint32_t address, char *file, int line) {
+    if (e->lines_number == e->lines_size) {
+        e->lines_size = e->lines_size ? 2 * e->lines_size : 1024;
+        e->lines = realloc(e->lines, e->lines_size * sizeof(struct elf_line));
+        error_if_null(e->lines);
+    }
+    e->lines[e->lines_number].address = address;
+    e->lines[e->lines_number].file = file;
+    e->lines[e->lines_number].line = line;
+    e->lines_number++;
+}
+
+/* Runs the line program of one unit, see the DWARF specification, section
+ * 6.2. The rows of a sequence are added along with its end, as line 0.
+ */
+static void dwarf_run_program(elf_reader e, struct dwarf_cursor *c, struct dwarf_line_header *h) {
+    uint32_t address = 0;
+    uint64_t file = 1, length;
+    int line = 1, i;
+    uint8_t opcode, adjusted;
+    uint8_t *next;
+
+    while (c->position < c->end) {
+        opcode = dwarf_bytes(c, 1);
+        if (opcode >= h->opcode_base) {
+            adjusted = opcode - h->opcode_base;
+            address += (adjusted / h->line_range) * h->minimum_instruction_length;
+            line += h->line_base + adjusted % h->line_range;
+            elf_add_line(e, address, file < h->files_number ? h->files[file] : "", line);
+            continue;
+        }
+        switch (opcode) {
+        case 0:
+            length = dwarf_uleb128(c);
+            if ((length == 0) || (c->end - c->position < length))
+                return;
+            next = c->position + length;
+            switch (dwarf_bytes(c, 1)) {
+            case DW_LNE_end_sequence:
+                elf_add_line(e, address, "", 0);
+                address = 0;
+                file = 1;
+                line = 1;
+                break;
+            case DW_LNE_set_address:
+                address = dwarf_bytes(c, length - 1 > 4 ? 4 : length - 1);
+                break;
+            }
+            c->position = next;
+            break;
+        case DW_LNS_copy:
+            elf_add_line(e, address, file < h->files_number ? h->files[file] : "", line);
+            break;
+        case DW_LNS_advance_pc:
+            address += dwarf_uleb128(c) * h->minimum_instruction_length;
+            break;
+        case DW_LNS_advance_line:
+            line += dwarf_sleb128(c);
+            break;
+        case DW_LNS_set_file:
+            file = dwarf_uleb128(c);
+            break;
+        case DW_LNS_const_add_pc:
+            address += ((255 - h->opcode_base) / h->line_range) * h->minimum_instruction_length;
+            break;
+        case DW_LNS_fixed_advance_pc:
+            address += dwarf_bytes(c, 2);
+            break;
+        default:
+            /* Operands of the other standard opcodes are skipped */
+            for (i = 0; i < h->standard_opcode_lengths[opcode - 1]; i++)
+                dwarf_uleb128(c);
+        }
+    }
+}
+
+static int elf_line_compare(const void *a, const void *b) {
+    const struct elf_line *first = a, *second = b;
+
+    if (first->address != second->address)
+        return first->address < second->address ? -1 : 1;
+    /* At the same address, the end of a sequence comes before the next one */
+    return (first->line != 0) - (second->line != 0);
+}
+
+static int elf_load_lines(elf_reader e) {
+    struct dwarf_sections sections;
+    struct dwarf_line_header h;
+    struct dwarf_cursor c, unit;
+    uint8_t *content;
+    uint32_t size, length, header_length;
+
+    content = elf_section_content(e, ".debug_line", &size);
+    if (content == NULL)
+        return 0;
+    sections.line_str = elf_section_content(e, ".debug_line_str", &sections.line_str_size);
+    sections.str = elf_section_content(e, ".debug_str", &sections.str_size);
+    c.e = e;
+    c.position = content;
+    c.end = content + size;
+    while (c.position < c.end) {
+        length = dwarf_bytes(&c, 4);
+        /* 64 bits DWARF is not used for 32 bits targets */
+        if ((length >= 0xFFFFFFF0) || (c.end - c.position < length))
+            return -1;
+        unit.e = e;
+        unit.position = c.position;
+        unit.end = c.position + length;
+        c.position = unit.end;
+        memset(&h, 0, sizeof(h));
+        h.version = dwarf_bytes(&unit, 2);
+        if ((h.version < 2) || (h.version > 5))
+            return -1;
+        if (h.version >= 5)
+            dwarf_bytes(&unit, 2);      /* address and segment selector sizes */
+        header_length = dwarf_bytes(&unit, 4);
+        if (unit.end - unit.position < header_length)
+            return -1;
+        h.minimum_instruction_length = dwarf_bytes(&unit, 1);
+        if (h.version >= 4)
+            dwarf_bytes(&unit, 1);      /* maximum operations per instruction */
+        h.default_is_stmt = dwarf_bytes(&unit, 1);
+        h.line_base = dwarf_bytes(&unit, 1);
+        h.line_range = dwarf_bytes(&unit, 1);
+        h.opcode_base = dwarf_bytes(&unit, 1);
+        if ((h.line_range == 0) || (h.opcode_base == 0) ||
+            (unit.end - unit.position < h.opcode_base - 1))
+            return -1;
+        h.standard_opcode_lengths = unit.position;
+        unit.position += h.opcode_base - 1;
+        if (dwarf_read_entries(e, &unit, &sections, &h) == 0) {
+            unit.position = unit.end - length + (h.version >= 5 ? 8 : 6) + header_length;
+            dwarf_run_program(e, &unit, &h);
+        }
+        free(h.directories);
+        free(h.files);
+    }
+    qsort(e->lines, e->lines_number, sizeof(struct elf_line), elf_line_compare);
+    return 0;
+}
+
+elf_reader elf_reader_open(char *filename) {
+    Elf32_Ehdr *header;
+    elf_reader e;
+    FILE *f;
+
+    f = fopen(filename, "r");
+    if (f == NULL) {
+        perror(filename);
+        return NULL;
+    }
+    e = calloc(1, sizeof(struct elf_reader_data));
+    error_if_null(e);
+    fseek(f, 0, SEEK_END);
+    e->size = ftell(f);
+    rewind(f);
+    e->content = malloc(e->size);
+    error_if_null(e->content);
+    if (fread(e->content, 1, e->size, f) != e->size) {
+        perror(filename);
+        fclose(f);
+        elf_reader_close(e);
+        return NULL;
+    }
+    fclose(f);
+    header = (Elf32_Ehdr *) e->content;
+    if ((e->size < sizeof(Elf32_Ehdr)) || (memcmp(header->e_ident, ELFMAG, SELFMAG) != 0) ||
+        (header->e_ident[EI_CLASS] != ELFCLASS32)) {
+        fprintf(stderr, "%s is not a 32 bits ELF file\n", filename);
+        elf_reader_close(e);
+        return NULL;
+    }
+    e->big_endian = header->e_ident[EI_DATA] == ELFDATA2MSB;
+    if (elf_load_symbols(e) == -1) {
+        fprintf(stderr, "%s has an invalid symbol table\n", filename);
+        elf_reader_close(e);
+        return NULL;
+    }
+    if (elf_load_segments(e) == -1) {
+        fprintf(stderr, "%s has an invalid program header table\n", filename);
+        elf_reader_close(e);
+        return NULL;
+    }
+    if (elf_load_lines(e) == -1)
+        fprintf(stderr, "%s has an invalid line table, lines are ignored\n", filename);
+    return e;
+}
+
+void elf_reader_close(elf_reader e) {
+    int i;
+
+    for (i = 0; i < e->files_number; i++)
+        free(e->files[i]);
+    free(e->files);
+    free(e->lines);
+    free(e->symbols);
+    free(e->segments);
+    free(e->content);
+    free(e);
+}
+
+int elf_reader_segments_number(elf_reader e) {
+    return e->segments_number;
+}
+
+struct elf_segment *elf_reader_segment(elf_reader e, int index) {
+    return &e->segments[index];
+}
+
+uint32_t elf_reader_entry(elf_reader e) {
+    return elf_word(e, ((Elf32_Ehdr *) e->content)->e_entry);
+}
+
+int elf_reader_symbols_number(elf_reader e) {
+    return e->symbols_number;
+}
+
+struct elf_symbol *elf_reader_symbol(elf_reader e, int index) {
+    return &e->symbols[index];
+}
+
+int elf_reader_find_symbol(elf_reader e, uint32_t address) {
+    int begin = 0, end = e->symbols_number, middle;
+
+    /* Last symbol starting at or before address */
+    while (begin < end) {
+        middle = (begin + end) >> 1;
+        if (e->symbols[middle].address <= address)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    if (begin == 0)
+        return -1;
+    middle = begin - 1;
+    /* Several symbols at the same address, the first one has the largest size */
+    while ((middle > 0) && (e->symbols[middle - 1].address == e->symbols[middle].address))
+        middle--;
+    if (e->symbols[middle].size &&
+        (address - e->symbols[middle].address >= e->symbols[middle].size))
+        return -1;
+    return middle;
+}
+
+char *elf_reader_describe_address(elf_reader e, uint32_t address, char *buffer, int size) {
+    int index = e ? elf_reader_find_symbol(e, address) : -1;
+
+    if (index == -1)
+        snprintf(buffer, size, "%08x", address);
+    else if (address == e->symbols[index].address)
+        snprintf(buffer, size, "%s", e->symbols[index].name);
+    else
+        snprintf(buffer, size, "%s+0x%x", e->symbols[index].name,
+                 address - e->symbols[index].address);
+    return buffer;
+}
+
+int elf_reader_lines_number(elf_reader e) {
+    return e->lines_number;
+}
+
+struct elf_line *elf_reader_line(elf_reader e, int index) {
+    return &e->lines[index];
+}
+
+int elf_reader_find_line(elf_reader e, uint32_t address) {
+    int begin = 0, end = e->lines_number, middle;
+
+    while (begin < end) {
+        middle = (begin + end) >> 1;
+        if (e->lines[middle].address <= address)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return begin - 1;
+}
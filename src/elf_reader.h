@@ -0,0 +1,82 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __ELF_READER_H__
+#define __ELF_READER_H__
+#include <stdint.h>
+
+/* Minimal reader for the 32 bits ELF files produced for the simulator (of any
+ * endianess) : gives access to the code symbols of the symbol table and to
+ * the line table of the DWARF debug information (versions 2 to 5), both
+ * sorted by address, and to the loadable segments of the program.
+ */
+typedef struct elf_reader_data *elf_reader;
+
+struct elf_symbol {
+    char *name;
+    uint32_t address;
+    uint32_t size;
+};
+
+/* Row of the line table : the code from address up to the address of the
+ * next row comes from the given line of file. Line 0 ends a sequence.
+ */
+struct elf_line {
+    uint32_t address;
+    char *file;
+    int line;
+};
+
+/* Loadable segment : file_size bytes of content to copy at address (the
+ * load address, as gdb load does), followed by zeroes up to memory_size
+ */
+struct elf_segment {
+    uint32_t address;
+    uint32_t file_size, memory_size;
+    uint8_t *content;
+};
+
+elf_reader elf_reader_open(char *filename);
+void elf_reader_close(elf_reader e);
+
+int elf_reader_symbols_number(elf_reader e);
+struct elf_symbol *elf_reader_symbol(elf_reader e, int index);
+/* Index of the symbol containing the given address, -1 if none. Symbols
+ * without size extend up to the next symbol.
+ */
+int elf_reader_find_symbol(elf_reader e, uint32_t address);
+/* Name of the symbol containing the given address followed by the offset of
+ * the address within it (or the address alone), written into buffer
+ */
+char *elf_reader_describe_address(elf_reader e, uint32_t address, char *buffer, int size);
+
+/* No line when the file has no .debug_line section */
+int elf_reader_lines_number(elf_reader e);
+struct elf_line *elf_reader_line(elf_reader e, int index);
+/* Index of the last row at or before the given address, -1 if none */
+int elf_reader_find_line(elf_reader e, uint32_t address);
+
+int elf_reader_segments_number(elf_reader e);
+struct elf_segment *elf_reader_segment(elf_reader e, int index);
+uint32_t elf_reader_entry(elf_reader e);
+
+#endif
@@ -23,6 +23,7 @@ Contact: Guillaume.Huard@imag.fr
 #include <stdio.h>
 #include <assert.h>
 #include <errno.h>
+#include <ctype.h>
 #include "gdb_protocol.h"
 #include "debug.h"
 #include "csapp.h"
@@ -30,6 +31,12 @@ Contact: Guillaume.Huard@imag.fr
 #include "arm_core.h"
 #include "arm_constants.h"
 #include "trace.h"
+#include "replay.h"
+#include "host_stats.h"
+#include "self_profile.h"
+#include "monitor.h"
+#include "counters.h"
+#include "breakpoints.h"
 
 /* This file contains an implementation of the GDB RSP protocol that will be used to let GDB communicate
  * with our simulator. It is documented here for instance :
@@ -37,8 +44,11 @@ Contact: Guillaume.Huard@imag.fr
  * For those interested, GDB has a debug mode that provide you with the details of the communications :
  * set debug remote
  */
-#define MAX_PACKET_SIZE 4096
-#define MAX_BREAKPOINTS_NUMBER 1024
+/* Largest packet gdb may send, advertised in qSupported (in hexadecimal). The
+ * packet buffer grows to fit the replies, whatever their size.
+ */
+#define PACKET_SIZE 0x20000
+#define INITIAL_PACKET_SIZE 4096
 
 struct gdb_protocol_data {
     arm_core arm;
@@ -47,87 +57,173 @@ struct gdb_protocol_data {
     int target_exception;
     int fd;
     pthread_mutex_t *lock;
-    char packet[MAX_PACKET_SIZE];
-    uint32_t breakpoints[MAX_BREAKPOINTS_NUMBER];
-    int breakpoints_number;
+    /* Reply being sent, framed in place around buffer */
+    char *packet;
+    size_t packet_size;
+    /* Set by QStartNoAckMode, packets are then neither acknowledged nor
+     * retransmitted
+     */
+    int no_ack;
+    breakpoints breakpoints;
+    struct gdb_watchpoint *watchpoints;
+    int watchpoints_number, watchpoints_size;
+    /* Type of the watchpoint hit by the last step (0 for none) and accessed
+     * address within it
+     */
+    int watch_type;
+    uint32_t watch_address;
+    /* Length of the payload of the packet being handled, binary payloads may
+     * contain null characters
+     */
+    size_t payload_length;
     int len;
     char *buffer;
 };
 
+/* Types follow the Z packets : 2 for write, 3 for read, 4 for access */
+#define WATCH_WRITE 2
+#define WATCH_READ 3
+#define WATCH_ACCESS 4
+
+struct gdb_watchpoint {
+    int type;
+    uint32_t address, length;
+};
+
+static char *watch_names[] = { "watch", "rwatch", "awatch" };
+
 typedef void (*gdb_handler_t)(gdb_protocol_data_t, char *);
 static gdb_handler_t handler[256];
 
-static int gdb_find_breakpoint(gdb_protocol_data_t gdb, uint32_t address) {
-    int begin = 0, end, middle;
-    end = gdb->breakpoints_number;
-    while (begin < end) {
-        middle = (begin + end) >> 1;
-        if (gdb->breakpoints[middle] > address) {
-            end = middle;
-        } else {
-            if (gdb->breakpoints[middle] < address) {
-                begin = middle + 1;
-            } else {
-                return middle;
-            }
-        }
+enum { PACKET_HANDLED, PACKET_UNSUPPORTED, PACKET_BAD_CHECKSUM, PACKET_OUTCOMES };
+static char *packet_outcomes[PACKET_OUTCOMES] = { "handled", "unsupported", "bad_checksum" };
+static uint64_t packets[PACKET_OUTCOMES];
+
+/* Hexadecimal conversions go through tables rather than the stdio functions,
+ * they run for every byte of memory and register dumps. hex_values holds -1
+ * for characters that are not hexadecimal digits.
+ */
+static const char hex_digits[] = "0123456789abcdef";
+static int8_t hex_values[256];
+
+static char *hex_encode(char *destination, const uint8_t *source, size_t size) {
+    while (size--) {
+        *destination++ = hex_digits[*source >> 4];
+        *destination++ = hex_digits[*source++ & 0xF];
     }
-    return -1;
+    return destination;
 }
 
-static int gdb_add_breakpoint(gdb_protocol_data_t gdb, uint32_t address) {
-    if (gdb->breakpoints_number < MAX_BREAKPOINTS_NUMBER) {
-        if (gdb_find_breakpoint(gdb, address) != -1)
-            return 1;
-        int j = gdb->breakpoints_number++;
-        while ((j > 0) && (gdb->breakpoints[j - 1] > address)) {
-            gdb->breakpoints[j] = gdb->breakpoints[j - 1];
-            j--;
+/* Decodes up to size bytes, stopping at the first character that is not an
+ * hexadecimal digit, returns the number of bytes decoded
+ */
+static size_t hex_decode(uint8_t *destination, const char *source, size_t size) {
+    int high, low;
+    size_t i;
+
+    for (i = 0; i < size; i++) {
+        high = hex_values[(unsigned char) source[2 * i]];
+        if (high < 0)
+            break;
+        low = hex_values[(unsigned char) source[2 * i + 1]];
+        if (low < 0)
+            break;
+        destination[i] = (high << 4) | low;
+    }
+    return i;
+}
+
+/* Watch handler of the core, only called for the accesses to watched pages of
+ * memory, the first matching watchpoint stops the execution
+ */
+static void gdb_watch_access(void *data, uint32_t address, uint8_t size, int write) {
+    gdb_protocol_data_t gdb = data;
+    struct gdb_watchpoint *w;
+    int i;
+
+    for (i = 0; (i < gdb->watchpoints_number) && !gdb->watch_type; i++) {
+        w = &gdb->watchpoints[i];
+        if (((uint64_t) address < (uint64_t) w->address + w->length) &&
+            ((uint64_t) w->address < (uint64_t) address + size) &&
+            ((w->type == WATCH_ACCESS) || ((w->type == WATCH_WRITE) == write))) {
+            gdb->watch_type = w->type;
+            gdb->watch_address = max(address, w->address);
         }
-        gdb->breakpoints[j] = address;
-        return 1;
-    } else {
-        return 0;
     }
 }
 
-static int gdb_remove_breakpoint(gdb_protocol_data_t gdb, uint32_t address) {
-    int position;
-    position = gdb_find_breakpoint(gdb, address);
-    if (position == -1) {
-        return 0;
-    } else {
-        int last = --gdb->breakpoints_number;
-        for (int j = position; j < last; j++) {
-            gdb->breakpoints[j] = gdb->breakpoints[j + 1];
+static void gdb_add_watchpoint(gdb_protocol_data_t gdb, int type, uint32_t address,
+                               uint32_t length) {
+    struct gdb_watchpoint *w;
+
+    if (gdb->watchpoints_number == gdb->watchpoints_size) {
+        gdb->watchpoints_size = gdb->watchpoints_size ? 2 * gdb->watchpoints_size : 16;
+        gdb->watchpoints = realloc(gdb->watchpoints,
+                                   gdb->watchpoints_size * sizeof(struct gdb_watchpoint));
+        error_if_null(gdb->watchpoints);
+    }
+    w = &gdb->watchpoints[gdb->watchpoints_number++];
+    w->type = type;
+    w->address = address;
+    w->length = length ? length : 1;
+    memory_add_watch(gdb->mem, w->address, w->length);
+}
+
+static int gdb_remove_watchpoint(gdb_protocol_data_t gdb, int type, uint32_t address,
+                                 uint32_t length) {
+    struct gdb_watchpoint *w;
+    int i;
+
+    length = length ? length : 1;
+    for (i = 0; i < gdb->watchpoints_number; i++) {
+        w = &gdb->watchpoints[i];
+        if ((w->type == type) && (w->address == address) && (w->length == length)) {
+            memory_remove_watch(gdb->mem, address, length);
+            *w = gdb->watchpoints[--gdb->watchpoints_number];
+            return 1;
         }
-        return 1;
     }
+    return 0;
 }
 
 static void gdb_send_ack(gdb_protocol_data_t gdb) {
-    Rio_writen(gdb->fd, "+", 1);
+    if (!gdb->no_ack)
+        Rio_writen(gdb->fd, "+", 1);
 }
 
-static void gdb_send_buffer(gdb_protocol_data_t gdb) {
+/* Room for a reply of size characters, with its framing ($, #, checksum) */
+static void gdb_reserve(gdb_protocol_data_t gdb, size_t size) {
+    if (size + 5 > gdb->packet_size) {
+        while (size + 5 > gdb->packet_size)
+            gdb->packet_size *= 2;
+        gdb->packet = realloc(gdb->packet, gdb->packet_size);
+        error_if_null(gdb->packet);
+        gdb->buffer = gdb->packet + 1;
+    }
+}
+
+/* Sends the length characters of buffer, which may contain binary data */
+static void gdb_send_binary(gdb_protocol_data_t gdb, size_t length) {
     unsigned char check = 0;
-    int i;
+    size_t i;
 
     gdb->packet[0] = '$';
-    i = 1;
-    while (gdb->packet[i] != '\0') {
+    for (i = 1; i <= length; i++)
         check += gdb->packet[i];
-        i++;
-    }
     gdb->packet[i++] = '#';
-    snprintf(gdb->packet + i, 3, "%02x", check);
-    i += 2;
+    gdb->packet[i++] = hex_digits[check >> 4];
+    gdb->packet[i++] = hex_digits[check & 0xF];
     gdb->packet[i] = '\0';
     gdb->len = i;
     gdb_transmit_packet(gdb);
 }
 
+static void gdb_send_buffer(gdb_protocol_data_t gdb) {
+    gdb_send_binary(gdb, strlen(gdb->buffer));
+}
+
 static void gdb_send_data(gdb_protocol_data_t gdb, char *data) {
+    gdb_reserve(gdb, strlen(data));
     strcpy(gdb->buffer, data);
     gdb_send_buffer(gdb);
 }
@@ -136,13 +232,16 @@ static void gdb_send_data(gdb_protocol_data_t gdb, char *data) {
  * endian only : the byte order matches the textual representation
 */
 static uint32_t read_uint32(char *data) {
-    uint32_t value;
-    sscanf(data, "%08x", &value);
-    return value;
+    uint8_t bytes[4] = { 0, 0, 0, 0 };
+
+    hex_decode(bytes, data, 4);
+    return (bytes[0] << 24) | (bytes[1] << 16) | (bytes[2] << 8) | bytes[3];
 }
 
 static void write_uint32(char *data, uint32_t value) {
-    snprintf(data, 9, "%08x", value);
+    uint8_t bytes[4] = { value >> 24, value >> 16, value >> 8, value };
+
+    *hex_encode(data, bytes, 4) = '\0';
 }
 
 /* Handling of exception raised in target
@@ -150,7 +249,7 @@ static void write_uint32(char *data, uint32_t value) {
  * existing signals, but this is a rough interpretation of what's happening
  */
 void gdb_send_stop_reason(gdb_protocol_data_t gdb) {
-    char *action;
+    char *action, watch[32];
     switch (gdb->target_exception) {
     case UNDEFINED_INSTRUCTION:
         action = "S04";
@@ -165,15 +264,23 @@ void gdb_send_stop_reason(gdb_protocol_data_t gdb) {
         action = "X05";
         break;
     default:
-        action = "S05";
+        if (gdb->watch_type) {
+            snprintf(watch, sizeof(watch), "T05%s:%x;", watch_names[gdb->watch_type - WATCH_WRITE],
+                     gdb->watch_address);
+            action = watch;
+        } else {
+            action = "S05";
+        }
     }
     gdb_send_data(gdb, action);
 }
 
 /* GDB Protocol commands handlers */
 static void single_step(gdb_protocol_data_t gdb) {
+    gdb->watch_type = 0;
     gdb->target_exception = arm_step(gdb->arm);
     trace_arm_state(gdb->reg);
+    trace_keyframe(arm_get_cycle_count(gdb->arm), gdb->reg);
 }
 
 static void single_step_with_signal(gdb_protocol_data_t gdb) {
@@ -183,20 +290,26 @@ static void single_step_with_signal(gdb_protocol_data_t gdb) {
 
 
 static void cont(gdb_protocol_data_t gdb, char *data) {
-    int stop;
+    int stop, activity;
     uint32_t PC;
+
+    activity = host_stats_switch(HOST_STATS_EXECUTION);
     do {
         single_step(gdb);
         PC = registers_read(gdb->reg, 15, registers_get_mode(gdb->reg));
-        stop = (gdb_find_breakpoint(gdb, PC) != -1);
+        stop = breakpoints_find(gdb->breakpoints, PC);
         if (stop) {
             debug("Cont stopped by a breakpoint at address %x\n", PC);
+        } else if (gdb->watch_type) {
+            stop = 1;
+            debug("Cont stopped by a watchpoint at address %x\n", gdb->watch_address);
         } else {
             stop = gdb->target_exception;
             if (stop)
                 debug("Cont stopped by an exception (%d)\n", gdb->target_exception);
         }
     } while (!stop);
+    host_stats_switch(activity);
     gdb_send_stop_reason(gdb);
 }
 
@@ -208,12 +321,50 @@ static void kill_request(gdb_protocol_data_t gdb, char *data) {
     shutdown(gdb->fd, SHUT_WR);
 }
 
+/* Output of monitor commands, in console output packets small enough for any
+ * packet size
+ */
+#define MONITOR_OUTPUT_CHUNK 256
+
+static void monitor(gdb_protocol_data_t gdb, char *data) {
+    char *command, *output, *position;
+    size_t length, i, size;
+    FILE *f;
+
+    length = strlen(data) / 2;
+    command = malloc(length + 1);
+    error_if_null(command);
+    command[hex_decode((uint8_t *) command, data, length)] = '\0';
+    debug("Monitor command : %s\n", command);
+    f = open_memstream(&output, &size);
+    error_if_null(f);
+    monitor_command(gdb->arm, command, f);
+    fclose(f);
+    gdb_reserve(gdb, 2 * MONITOR_OUTPUT_CHUNK + 1);
+    for (i = 0; i < size; i += MONITOR_OUTPUT_CHUNK) {
+        position = gdb->buffer;
+        *position++ = 'O';
+        length = min(size - i, MONITOR_OUTPUT_CHUNK);
+        *hex_encode(position, (uint8_t *) output + i, length) = '\0';
+        gdb_send_buffer(gdb);
+    }
+    free(output);
+    free(command);
+    gdb_send_data(gdb, "OK");
+}
+
 static void query(gdb_protocol_data_t gdb, char *data) {
-    if (strcmp(data, "Offsets") == 0)
+    char supported[64];
+
+    if (strncmp(data, "Rcmd,", 5) == 0)
+        monitor(gdb, data + 5);
+    else if (strcmp(data, "Offsets") == 0)
         gdb_send_data(gdb, "Text=0;Data=0;Bss=0");
-    else if (strncmp(data, "Supported", 9) == 0)
-        gdb_send_data(gdb, "PacketSize=400");
-    else if (strcmp(data, "TStatus") == 0)
+    else if (strncmp(data, "Supported", 9) == 0) {
+        snprintf(supported, sizeof(supported), "PacketSize=%x;QStartNoAckMode+;binary-upload+",
+                 PACKET_SIZE);
+        gdb_send_data(gdb, supported);
+    } else if (strcmp(data, "TStatus") == 0)
         gdb_send_data(gdb, "T0;tnotrun:0");
     else if (strcmp(data, "Symbol::") == 0)
         gdb_send_data(gdb, "");
@@ -224,6 +375,18 @@ static void query(gdb_protocol_data_t gdb, char *data) {
     }
 }
 
+static void general_set(gdb_protocol_data_t gdb, char *data) {
+    if (strcmp(data, "StartNoAckMode") == 0) {
+        /* This reply is still acknowledged by gdb */
+        gdb_send_data(gdb, "OK");
+        gdb->no_ack = 1;
+        debug("No ack mode started\n");
+    } else {
+        debug("Unsupported set : [%s], giving empty answer\n", data);
+        gdb_send_data(gdb, "");
+    }
+}
+
 static void read_register(gdb_protocol_data_t gdb, char *buffer, uint8_t reg) {
     assert(reg < 16);
     write_uint32(buffer, registers_read(gdb->reg, reg, registers_get_mode(gdb->reg)));
@@ -231,7 +394,7 @@ static void read_register(gdb_protocol_data_t gdb, char *buffer, uint8_t reg) {
 
 static void read_general_registers(gdb_protocol_data_t gdb, char *data) {
     char *position;
-    int i, j;
+    int i;
 
     position = gdb->buffer;
     /* General register r0..r14 */
@@ -239,44 +402,90 @@ static void read_general_registers(gdb_protocol_data_t gdb, char *data) {
         read_register(gdb, position, i);
         position += 8;
     }
-    /* Floating point register f0..f7 */
+    /* Floating point register f0..f7, 3 words each */
     /* Not implemented */
-    for (i = 0; i < 8; i++) {
-        for (j = 0; j < 3; j++) {
-            snprintf(position, 9, "xxxxxxxx");
-            position += 8;
-        }
-    }
+    memset(position, 'x', 8 * 3 * 8);
+    position += 8 * 3 * 8;
     /* Status registers */
     /* fps not implemented */
-    snprintf(position, 9, "xxxxxxxx");
+    memset(position, 'x', 8);
     position += 8;
     write_uint32(position, registers_read_cpsr(gdb->reg));
     gdb_send_buffer(gdb);
 }
 
+/* Parses the address,size of memory reads, clamping the size to the end of
+ * memory, returns 0 when address is outside memory
+ */
+static int memory_range(gdb_protocol_data_t gdb, char *data, uint32_t *address,
+                        uint32_t *size) {
+    unsigned int parsed_address, parsed_size;
+
+    if (sscanf(data, "%x,%x", &parsed_address, &parsed_size) != 2)
+        return 0;
+    if (parsed_address >= memory_get_size(gdb->mem))
+        return 0;
+    *address = parsed_address;
+    *size = min(parsed_size, memory_get_size(gdb->mem) - parsed_address);
+    return 1;
+}
+
+static void memory_error(gdb_protocol_data_t gdb) {
+    snprintf(gdb->buffer, 4, "E%02X", EFAULT);
+    gdb_send_buffer(gdb);
+}
+
 static void read_memory(gdb_protocol_data_t gdb, char *data) {
-    unsigned int address, size;
+    uint32_t address, size;
+    uint8_t *content;
+
+    if (!memory_range(gdb, data, &address, &size)) {
+        memory_error(gdb);
+        return;
+    }
+    gdb_reserve(gdb, 2 * size);
+    /* The block is read into the second half of the reply and encoded from
+     * the start : each byte is read before its digits overwrite it
+     */
+    content = (uint8_t *) gdb->buffer + size;
+    memory_read_block(gdb->mem, address, content, size);
+    *hex_encode(gdb->buffer, content, size) = '\0';
+    gdb_send_buffer(gdb);
+}
+
+/* Binary variant of read_memory, the reply is 'b' followed by the escaped
+ * bytes, about half the size of the hexadecimal one
+ */
+static void read_memory_binary(gdb_protocol_data_t gdb, char *data) {
+    uint32_t address, size, i;
+    uint8_t *content, value;
     char *position;
-    uint8_t value;
 
-    sscanf(data, "%x,%x", &address, &size);
+    if (!memory_range(gdb, data, &address, &size)) {
+        memory_error(gdb);
+        return;
+    }
+    /* Every byte may need an escape, the block is read after this room */
+    gdb_reserve(gdb, 3 * size + 1);
+    content = (uint8_t *) gdb->buffer + 2 * size + 1;
+    memory_read_block(gdb->mem, address, content, size);
     position = gdb->buffer;
-    if (address < memory_get_size(gdb->mem)) {
-        position[0] = '\0';
-        while (size-- && (memory_read_byte(gdb->mem, address++, &value) != -1)) {
-            snprintf(position, 3, "%02x", value);
-            position += 2;
+    *position++ = 'b';
+    for (i = 0; i < size; i++) {
+        value = content[i];
+        if ((value == '#') || (value == '$') || (value == '}') || (value == '*')) {
+            *position++ = '}';
+            value ^= 0x20;
         }
-    } else {
-        snprintf(position, 4, "E%02X", EFAULT);
+        *position++ = value;
     }
-    gdb_send_buffer(gdb);
+    gdb_send_binary(gdb, position - gdb->buffer);
 }
 
 static void read_single_register(gdb_protocol_data_t gdb, char *data) {
     unsigned int reg;
-    reg = atoi(data);
+    /* The register number is in hexadecimal */
+    reg = strtoul(data, NULL, 16);
     read_register(gdb, gdb->buffer, reg);
     gdb_send_buffer(gdb);
 }
@@ -297,12 +506,18 @@ static void set_thread(gdb_protocol_data_t gdb, char *data) {
 }
 
 static void step(gdb_protocol_data_t gdb, char *data) {
+    int activity = host_stats_switch(HOST_STATS_EXECUTION);
+
     single_step(gdb);
+    host_stats_switch(activity);
     gdb_send_stop_reason(gdb);
 }
 
 static void step_with_signal(gdb_protocol_data_t gdb, char *data) {
+    int activity = host_stats_switch(HOST_STATS_EXECUTION);
+
     single_step_with_signal(gdb);
+    host_stats_switch(activity);
     gdb_send_stop_reason(gdb);
 }
 
@@ -316,6 +531,7 @@ static void write_register(gdb_protocol_data_t gdb, unsigned int reg, char *data
             ("PC value is outside the address space, did you set the right endianess in gdb ?\n");
     }
     registers_write(gdb->reg, reg, registers_get_mode(gdb->reg), value);
+    replay_record_register(gdb->arm, reg, registers_get_mode(gdb->reg), value);
     debug("Writing %d to register %d\n", value, reg);
 }
 
@@ -344,6 +560,7 @@ static void write_general_registers(gdb_protocol_data_t gdb, char *data) {
     position += 8;
     value = read_uint32(position);
     registers_write_cpsr(gdb->reg, value);
+    replay_record_cpsr(gdb->arm, value);
     debug("cpsr = %08x\n", value);
 
     gdb_send_data(gdb, "OK");
@@ -360,26 +577,44 @@ static void write_single_register(gdb_protocol_data_t gdb, char *data) {
 
 static void write_memory_binary(gdb_protocol_data_t gdb, char *data) {
     unsigned int address, size, i, write_ok;
-    char *content;
-    uint8_t value;
+    char *content, *end;
+    uint8_t *start_content, value;
 
-    sscanf(data, "%x,%x", &address, &size);
-    content = index(data, ':') + 1;
+    content = index(data, ':');
+    if ((sscanf(data, "%x,%x", &address, &size) != 2) || (content == NULL)) {
+        gdb_send_data(gdb, "E02");
+        return;
+    }
+    content++;
+    end = data + gdb->payload_length;
     debug("Writing %d bytes at address %08x : ", size, address);
-    write_ok = address < memory_get_size(gdb->mem);
-    for (i = 0; (i < size) && write_ok; i++) {
+    /* Binary data is unescaped in place, then written as a single block. The
+     * unescaped bytes never outrun the escaped ones, and both stop at the end
+     * of the payload whatever the announced size
+     */
+    start_content = (uint8_t *) content;
+    for (i = 0; (i < size) && (content < end); i++) {
         if (*content == 0x7d) {
-            content++;
+            if (++content == end)
+                break;
             value = *content ^ (char) 0x20;
         } else {
             value = *content;
         }
-        write_ok = memory_write_byte(gdb->mem, address++, value) == 0;
+        start_content[i] = value;
         if (i < 32)
             debug_raw("%02x", value);
         content++;
     }
     debug_raw("...\n");
+    if ((i != size) || (content != end)) {
+        debug("Payload holds %d bytes\n", i);
+        gdb_send_data(gdb, "E02");
+        return;
+    }
+    write_ok = memory_write_block(gdb->mem, address, start_content, size) == 0;
+    if (write_ok)
+        replay_record_memory(gdb->arm, address, start_content, size);
     if (write_ok)
         gdb_send_data(gdb, "OK");
     else
@@ -391,15 +626,17 @@ static void set_breakpoint(gdb_protocol_data_t gdb, char *data) {
     uint32_t address, length;
 
     sscanf(data, "%hhx,%x,%x", &type, &address, &length);
-    if (type != 0)
+    if ((type >= WATCH_WRITE) && (type <= WATCH_ACCESS)) {
+        gdb_add_watchpoint(gdb, type, address, length);
+        debug("Added %s of %d bytes at address %x\n", watch_names[type - WATCH_WRITE], length,
+              address);
+        gdb_send_data(gdb, "OK");
+    } else if (type != 0)
         gdb_send_data(gdb, "E03");
     else {
-        if (gdb_add_breakpoint(gdb, address)) {
-            debug("Added breakpoint at address %x\n", address);
-            gdb_send_data(gdb, "OK");
-        } else {
-            gdb_send_data(gdb, "E04");
-        }
+        breakpoints_add(gdb->breakpoints, address);
+        debug("Added breakpoint at address %x\n", address);
+        gdb_send_data(gdb, "OK");
     }
 }
 
@@ -408,10 +645,17 @@ static void remove_breakpoint(gdb_protocol_data_t gdb, char *data) {
     uint32_t address, length;
 
     sscanf(data, "%hhx,%x,%x", &type, &address, &length);
-    if (type != 0)
+    if ((type >= WATCH_WRITE) && (type <= WATCH_ACCESS)) {
+        if (gdb_remove_watchpoint(gdb, type, address, length)) {
+            debug("Removed %s from address %x\n", watch_names[type - WATCH_WRITE], address);
+            gdb_send_data(gdb, "OK");
+        } else {
+            gdb_send_data(gdb, "E05");
+        }
+    } else if (type != 0)
         gdb_send_data(gdb, "E03");
     else {
-        if (gdb_remove_breakpoint(gdb, address)) {
+        if (breakpoints_remove(gdb->breakpoints, address)) {
             debug("Removed breakpoint from address %x\n", address);
             gdb_send_data(gdb, "OK");
         } else {
@@ -435,13 +679,31 @@ gdb_protocol_data_t gdb_init_data(arm_core arm, registers reg, memory mem, int f
         gdb->fd = fd;
         gdb->lock = lock;
         gdb->len = 0;
+        gdb->packet_size = INITIAL_PACKET_SIZE;
+        gdb->packet = malloc(gdb->packet_size);
+        error_if_null(gdb->packet);
         gdb->buffer = gdb->packet + 1;
-        gdb->breakpoints_number = 0;
+        gdb->no_ack = 0;
+        gdb->breakpoints = breakpoints_create();
+        gdb->watchpoints = NULL;
+        gdb->watchpoints_number = gdb->watchpoints_size = 0;
+        gdb->watch_type = 0;
+        gdb->watch_address = 0;
+        arm_set_watch_handler(arm, gdb_watch_access, gdb);
     }
     return gdb;
 }
 
 void gdb_release_data(gdb_protocol_data_t gdb) {
+    int i;
+
+    /* The memory outlives the connection */
+    for (i = 0; i < gdb->watchpoints_number; i++)
+        memory_remove_watch(gdb->mem, gdb->watchpoints[i].address, gdb->watchpoints[i].length);
+    free(gdb->watchpoints);
+    arm_set_watch_handler(gdb->arm, NULL, NULL);
+    breakpoints_destroy(gdb->breakpoints);
+    free(gdb->packet);
     free(gdb);
 }
 
@@ -449,14 +711,22 @@ void gdb_init() {
     int i;
 
     debug("gdb protocol handlers initialization\n");
-    for (i = 0; i < 256; i++)
+    for (i = 0; i < 256; i++) {
         handler[i] = NULL;
+        hex_values[i] = -1;
+    }
+    for (i = 0; i < 16; i++) {
+        hex_values[(unsigned char) hex_digits[i]] = i;
+        hex_values[toupper(hex_digits[i])] = i;
+    }
     handler['c'] = cont;
     handler['C'] = cont_with_signal;
     handler['k'] = kill_request;
     handler['q'] = query;
+    handler['Q'] = general_set;
     handler['g'] = read_general_registers;
     handler['m'] = read_memory;
+    handler['x'] = read_memory_binary;
     handler['p'] = read_single_register;
     handler['?'] = reason;
     handler['H'] = set_thread;
@@ -469,6 +739,17 @@ void gdb_init() {
     handler['Z'] = set_breakpoint;
 }
 
+void gdb_add_counters() {
+    char labels[32];
+    int i;
+
+    for (i = 0; i < PACKET_OUTCOMES; i++) {
+        snprintf(labels, sizeof(labels), "outcome=\"%s\"", packet_outcomes[i]);
+        counters_add("gdb_packets", labels, "Packets received from gdb by outcome", COUNTER,
+                     &packets[i]);
+    }
+}
+
 void gdb_require_retransmission(gdb_protocol_data_t gdb) {
     Rio_writen(gdb->fd, "-", 1);
 }
@@ -476,12 +757,14 @@ void gdb_require_retransmission(gdb_protocol_data_t gdb) {
 void gdb_packet_analysis(gdb_protocol_data_t gdb, char *packet, int length) {
     int i;
     unsigned char check = 0;
-    unsigned int given;
+    uint8_t given = 0;
     unsigned char index;
+    int activity = host_stats_switch(HOST_STATS_GDB);
+    int profiled = self_profile_enter(SELF_PROFILE_GDB);
 
     for (i = 1; i < length - 3; i++)
         check += packet[i];
-    sscanf(packet + i + 1, "%x", &given);
+    hex_decode(&given, packet + i + 1, 1);
     debug("Received packet : ");
     debug_raw_binary(packet, min(16, strlen(packet)));
     if (check == given) {
@@ -489,20 +772,31 @@ void gdb_packet_analysis(gdb_protocol_data_t gdb, char *packet, int length) {
         gdb_send_ack(gdb);
     } else {
         debug_raw(", checksum failed, expected %02x got %02x\n", given, check);
-        debug("Requiring retransmission\n");
-        gdb_require_retransmission(gdb);
+        /* Without acks, gdb does not expect retransmission requests either */
+        if (!gdb->no_ack) {
+            debug("Requiring retransmission\n");
+            gdb_require_retransmission(gdb);
+        }
+        packets[PACKET_BAD_CHECKSUM]++;
+        self_profile_leave(profiled);
+        host_stats_switch(activity);
         return;
     }
     packet[i] = '\0';
+    gdb->payload_length = i - 2;
     index = packet[1];
     if (handler[index]) {
+        packets[PACKET_HANDLED]++;
         pthread_mutex_lock(gdb->lock);
         handler[index] (gdb, packet + 2);
         pthread_mutex_unlock(gdb->lock);
     } else {
+        packets[PACKET_UNSUPPORTED]++;
         debug("Unsupported request, sending empty answer\n");
         gdb_send_data(gdb, "");
     }
+    self_profile_leave(profiled);
+    host_stats_switch(activity);
 }
 
 void gdb_transmit_packet(gdb_protocol_data_t gdb) {
@@ -28,6 +28,8 @@ Contact: Guillaume.Huard@imag.fr
 typedef struct gdb_protocol_data *gdb_protocol_data_t;
 
 void gdb_init();
+/* Registers the counters of the packets received, by outcome */
+void gdb_add_counters();
 gdb_protocol_data_t gdb_init_data(arm_core arm, registers reg, memory mem, int fd,
 																	pthread_mutex_t * lock);
 void gdb_release_data(gdb_protocol_data_t gdb);
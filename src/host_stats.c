@@ -0,0 +1,108 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <time.h>
+#include <inttypes.h>
+#include "host_stats.h"
+#include "counters.h"
+
+static char *activity_names[HOST_STATS_ACTIVITIES] = { "idle", "execution", "tracing", "gdb",
+    "io"
+};
+
+static int enabled = 0;
+static int current = HOST_STATS_IDLE;
+static uint64_t last_switch;
+static uint64_t times[HOST_STATS_ACTIVITIES];
+/* State at the previous report */
+static uint64_t reported_instructions = 0, reported_execution = 0;
+
+static uint64_t host_stats_now() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+void host_stats_enable() {
+    char labels[32];
+    int i;
+
+    enabled = 1;
+    last_switch = host_stats_now();
+    for (i = 0; i < HOST_STATS_ACTIVITIES; i++) {
+        snprintf(labels, sizeof(labels), "activity=\"%s\"", activity_names[i]);
+        counters_add("host_time_ns", labels, "Host time spent per simulator activity",
+                     COUNTER, &times[i]);
+    }
+}
+
+int host_stats_switch(int activity) {
+    uint64_t now;
+    int previous = current;
+
+    if (!enabled)
+        return activity;
+    now = host_stats_now();
+    times[current] += now - last_switch;
+    last_switch = now;
+    current = activity;
+    return previous;
+}
+
+static double per_instruction(uint64_t ns, uint64_t instructions) {
+    return instructions ? (double) ns / instructions : 0.0;
+}
+
+static double mips(uint64_t ns, uint64_t instructions) {
+    return ns ? 1000.0 * instructions / ns : 0.0;
+}
+
+void host_stats_report(FILE *f, uint64_t instructions) {
+    uint64_t current_times[HOST_STATS_ACTIVITIES], total = 0;
+    uint64_t instructions_delta, execution_delta;
+    int i;
+
+    if (!enabled)
+        return;
+    /* Includes the time of the ongoing activity without switching */
+    for (i = 0; i < HOST_STATS_ACTIVITIES; i++)
+        current_times[i] = times[i];
+    current_times[current] += host_stats_now() - last_switch;
+    for (i = 0; i < HOST_STATS_ACTIVITIES; i++)
+        total += current_times[i];
+    fprintf(f, "Host : %" PRIu64 " instructions in %.3f s (", instructions, total / 1e9);
+    for (i = 0; i < HOST_STATS_ACTIVITIES; i++)
+        fprintf(f, "%s%s %.3f s", i ? ", " : "", activity_names[i], current_times[i] / 1e9);
+    fprintf(f, ")\n       %.3f MIPS, %.1f ns per instruction",
+            mips(current_times[HOST_STATS_EXECUTION], instructions),
+            per_instruction(current_times[HOST_STATS_EXECUTION], instructions));
+    instructions_delta = instructions - reported_instructions;
+    execution_delta = current_times[HOST_STATS_EXECUTION] - reported_execution;
+    if (reported_instructions)
+        fprintf(f, ", since previous report %.3f MIPS, %.1f ns per instruction",
+                mips(execution_delta, instructions_delta),
+                per_instruction(execution_delta, instructions_delta));
+    fprintf(f, "\n");
+    reported_instructions = instructions;
+    reported_execution = current_times[HOST_STATS_EXECUTION];
+}
@@ -0,0 +1,48 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __HOST_STATS_H__
+#define __HOST_STATS_H__
+#include <stdio.h>
+#include <stdint.h>
+
+/* Host time spent by the simulator, split by activity : the simulator is
+ * always in exactly one activity, switching activity charges the time
+ * elapsed since the previous switch to the previous activity. Together with
+ * the number of instructions executed, gives the simulation speed.
+ */
+#define HOST_STATS_IDLE 0
+#define HOST_STATS_EXECUTION 1
+#define HOST_STATS_TRACING 2
+#define HOST_STATS_GDB 3
+#define HOST_STATS_IO 4
+#define HOST_STATS_ACTIVITIES 5
+
+void host_stats_enable();
+/* Returns the previous activity, to switch back to it */
+int host_stats_switch(int activity);
+/* Time per activity, simulated MIPS and ns per instruction, in total and
+ * since the previous report
+ */
+void host_stats_report(FILE * f, uint64_t instructions);
+
+#endif
@@ -0,0 +1,198 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include "instruction_stats.h"
+#include "counters.h"
+#include "util.h"
+
+#define TAKEN 0
+#define NOT_TAKEN 1
+
+int instruction_stats_enabled = 0;
+static uint64_t data_processing[16];
+static uint64_t load_store[8];
+static uint64_t load_multiple[17], store_multiple[17];
+static uint64_t branches[4][2];
+static uint64_t multiply, swap, status_register, miscellaneous, coprocessor;
+static uint64_t condition_failed;
+
+static char *opcode_names[] = { "and", "eor", "sub", "rsb", "add", "adc", "sbc", "rsc",
+    "tst", "teq", "cmp", "cmn", "orr", "mov", "bic", "mvn"
+};
+
+/* Indexed by L, B for words and bytes, then by 4 + S, H for halfwords */
+static char *load_store_names[] = { "str", "strb", "ldr", "ldrb", "strh", "ldrh", "ldrsb",
+    "ldrsh"
+};
+
+static char *branch_names[] = { "b", "bl", "bx", "blx" };
+
+/* Software interrupts counters are created when their number first occurs */
+struct swi_counter {
+    uint32_t number;
+    uint64_t count;
+    struct swi_counter *next;
+};
+static struct swi_counter *swis = NULL;
+
+#define BRANCH_HELP "Branches by type and outcome"
+
+void instruction_stats_enable() {
+    char labels[64];
+    int i;
+
+    if (instruction_stats_enabled)
+        return;
+    instruction_stats_enabled = 1;
+    for (i = 0; i < 16; i++) {
+        snprintf(labels, sizeof(labels), "opcode=\"%s\"", opcode_names[i]);
+        counters_add("instructions_data_processing", labels,
+                     "Data processing instructions by opcode", COUNTER, &data_processing[i]);
+    }
+    for (i = 0; i < 8; i++) {
+        snprintf(labels, sizeof(labels), "type=\"%s\"", load_store_names[i]);
+        counters_add("instructions_load_store", labels, "Loads and stores by variant", COUNTER,
+                     &load_store[i]);
+    }
+    for (i = 0; i <= 16; i++) {
+        snprintf(labels, sizeof(labels), "registers=\"%d\"", i);
+        counters_add("instructions_load_multiple", labels,
+                     "Load multiple instructions by number of registers", COUNTER,
+                     &load_multiple[i]);
+    }
+    for (i = 0; i <= 16; i++) {
+        snprintf(labels, sizeof(labels), "registers=\"%d\"", i);
+        counters_add("instructions_store_multiple", labels,
+                     "Store multiple instructions by number of registers", COUNTER,
+                     &store_multiple[i]);
+    }
+    for (i = 0; i < 4; i++) {
+        snprintf(labels, sizeof(labels), "type=\"%s\",outcome=\"taken\"", branch_names[i]);
+        counters_add("instructions_branch", labels, BRANCH_HELP, COUNTER, &branches[i][TAKEN]);
+        snprintf(labels, sizeof(labels), "type=\"%s\",outcome=\"not_taken\"", branch_names[i]);
+        counters_add("instructions_branch", labels, BRANCH_HELP, COUNTER,
+                     &branches[i][NOT_TAKEN]);
+    }
+    counters_add("instructions_multiply", NULL, "Multiply instructions", COUNTER, &multiply);
+    counters_add("instructions_swap", NULL, "Swap instructions", COUNTER, &swap);
+    counters_add("instructions_status_register", NULL, "Status register transfers (mrs, msr)",
+                 COUNTER, &status_register);
+    counters_add("instructions_miscellaneous", NULL, "Other miscellaneous instructions",
+                 COUNTER, &miscellaneous);
+    counters_add("instructions_coprocessor", NULL, "Coprocessor instructions", COUNTER,
+                 &coprocessor);
+    counters_add("instructions_condition_failed", NULL,
+                 "Instructions skipped because their condition failed", COUNTER,
+                 &condition_failed);
+}
+
+static void instruction_stats_swi(uint32_t number) {
+    struct swi_counter *s;
+    char labels[32];
+
+    for (s = swis; s && (s->number != number); s = s->next);
+    if (s == NULL) {
+        s = malloc(sizeof(struct swi_counter));
+        error_if_null(s);
+        s->number = number;
+        s->count = 0;
+        s->next = swis;
+        swis = s;
+        snprintf(labels, sizeof(labels), "number=\"0x%06x\"", number);
+        counters_add("instructions_swi", labels, "Software interrupts by number", COUNTER,
+                     &s->count);
+    }
+    s->count++;
+}
+
+/* Index in branch_names of a branch instruction, -1 for other instructions */
+static int instruction_stats_branch_type(uint32_t ins) {
+    if (get_bits(ins, 27, 25) == 0b101)
+        return get_bit(ins, 24);
+    if ((ins & 0x0FFFFFD0) == 0x012FFF10)
+        return 2 + get_bit(ins, 5);
+    return -1;
+}
+
+static void instruction_stats_load_store(uint32_t ins) {
+    if (get_bits(ins, 27, 25) != 0b000) {
+        load_store[(get_bit(ins, 20) << 1) | get_bit(ins, 22)]++;
+    } else if ((ins & 0x0F0000F0) == 0x00000090) {
+        multiply++;
+    } else if ((ins & 0x0FB00FF0) == 0x01000090) {
+        swap++;
+    } else if (get_bit(ins, 20)) {
+        load_store[4 + get_bits(ins, 6, 5)]++;
+    } else {
+        load_store[4]++;
+    }
+}
+
+void instruction_stats_record(int class, uint32_t ins) {
+    int type;
+
+    switch (class) {
+    case INSTRUCTION_STATS_DATA_PROCESSING:
+        data_processing[get_bits(ins, 24, 21)]++;
+        break;
+    case INSTRUCTION_STATS_LOAD_STORE:
+        instruction_stats_load_store(ins);
+        break;
+    case INSTRUCTION_STATS_LOAD_STORE_MULTIPLE:
+        if (get_bit(ins, 20))
+            load_multiple[__builtin_popcount(get_bits(ins, 15, 0))]++;
+        else
+            store_multiple[__builtin_popcount(get_bits(ins, 15, 0))]++;
+        break;
+    case INSTRUCTION_STATS_BRANCH:
+        branches[get_bit(ins, 24)][TAKEN]++;
+        break;
+    case INSTRUCTION_STATS_MISCELLANEOUS:
+        type = instruction_stats_branch_type(ins);
+        if (type != -1)
+            branches[type][TAKEN]++;
+        else if ((ins & 0x0FB00FF0) == 0x01000090)
+            swap++;
+        else if (((ins & 0x0F9000F0) == 0x01000000) || ((ins & 0x0FB00000) == 0x03200000))
+            status_register++;
+        else
+            miscellaneous++;
+        break;
+    case INSTRUCTION_STATS_COPROCESSOR:
+        coprocessor++;
+        break;
+    case INSTRUCTION_STATS_SWI:
+        instruction_stats_swi(get_bits(ins, 23, 0));
+        break;
+    }
+}
+
+void instruction_stats_record_condition_failed(uint32_t ins) {
+    int type;
+
+    condition_failed++;
+    type = instruction_stats_branch_type(ins);
+    if (type != -1)
+        branches[type][NOT_TAKEN]++;
+}
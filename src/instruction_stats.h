@@ -0,0 +1,56 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __INSTRUCTION_STATS_H__
+#define __INSTRUCTION_STATS_H__
+#include <stdint.h>
+
+/* Instruction mix of the simulated program : counts of each data processing
+ * opcode, load/store variant, load/store multiple register count, branch
+ * taken or not, condition failed instruction and software interrupt number.
+ * The counters are registered in the counters registry (see counters.h).
+ */
+#define INSTRUCTION_STATS_DATA_PROCESSING 0
+#define INSTRUCTION_STATS_LOAD_STORE 1
+#define INSTRUCTION_STATS_LOAD_STORE_MULTIPLE 2
+#define INSTRUCTION_STATS_BRANCH 3
+#define INSTRUCTION_STATS_MISCELLANEOUS 4
+#define INSTRUCTION_STATS_COPROCESSOR 5
+#define INSTRUCTION_STATS_SWI 6
+
+void instruction_stats_enable();
+
+/* Executed instruction of the given class, as dispatched by the decoder, and
+ * instruction skipped by its condition. Both test instruction_stats_enabled
+ * inline, the decoder pays nothing more while the mix is not counted.
+ */
+extern int instruction_stats_enabled;
+void instruction_stats_record(int class, uint32_t instruction);
+void instruction_stats_record_condition_failed(uint32_t instruction);
+#define instruction_stats_count(class, instruction) \
+    do { if (instruction_stats_enabled) \
+             instruction_stats_record(class, instruction); } while (0)
+#define instruction_stats_condition_failed(instruction) \
+    do { if (instruction_stats_enabled) \
+             instruction_stats_record_condition_failed(instruction); } while (0)
+
+#endif
@@ -22,24 +22,22 @@ Contact: Guillaume.Huard@imag.fr
 
 */
 #include <stdlib.h>
+#include <string.h>
 #include "memory.h"
 #include "util.h"
 #include <stdio.h>
 
-struct memory_data
-{
-  size_t size;
-  uint8_t *data;
-};
-
 memory memory_create(size_t size)
 {
 
   memory mem = malloc(sizeof(struct memory_data));
   error_if_null(mem);
   mem->size = size;
-  mem->data = malloc(size);
+  // Zeroed so that runs do not depend on the previous content of the host memory
+  mem->data = calloc(size, 1);
   error_if_null(mem->data);
+  mem->watches = NULL;
+  mem->watch_pages = 0;
 
   return mem;
 }
@@ -57,17 +55,16 @@ void memory_destroy(memory mem)
   {
     free(mem->data);
   }
+  free(mem->watches);
   free(mem);
 }
 
 int memory_read_byte(memory mem, uint32_t address, uint8_t *value)
 {
   error_if_null(mem);
-  if (address > mem->size)
-  {
-    fprintf(stderr, "Erreur lors de l'allocation de la memoire");
-    exit(1);
-  }
+  // Hors memoire : erreur rapportee a l'appelant (data abort), comme en ecriture
+  if (address >= mem->size)
+    return -1;
   *value = mem->data[address];
 
   return 0;
@@ -78,11 +75,6 @@ int memory_read_half(memory mem, uint32_t address, uint16_t *value, uint8_t be)
 
   uint8_t byte1, byte2;
   error_if_null(mem);
-  if (address > mem->size)
-  {
-    fprintf(stderr, "Erreur lors de l'allocation de la memoire");
-    exit(1);
-  }
 
   if (memory_read_byte(mem, address, &byte1) != 0)
   {
@@ -113,11 +105,6 @@ int memory_read_word(memory mem, uint32_t address, uint32_t *value, uint8_t be)
   uint8_t byte1, byte2, byte3, byte4;
 
   error_if_null(mem);
-  if (address > mem->size)
-  {
-    fprintf(stderr, "Erreur lors de l'allocation de la memoire");
-    exit(1);
-  }
 
   if (memory_read_byte(mem, address, &byte1) != 0)
   {
@@ -200,3 +187,47 @@ int memory_write_word(memory mem, uint32_t address, uint32_t value, uint8_t be)
 
   return 0;
 }
+
+int memory_read_block(memory mem, uint32_t address, uint8_t *buffer, size_t size)
+{
+  if (mem == NULL || address > mem->size || size > mem->size - address)
+    return -1;
+  memcpy(buffer, mem->data + address, size);
+  return 0;
+}
+
+int memory_write_block(memory mem, uint32_t address, const uint8_t *buffer, size_t size)
+{
+  if (mem == NULL || address > mem->size || size > mem->size - address)
+    return -1;
+  memcpy(mem->data + address, buffer, size);
+  return 0;
+}
+
+static void memory_count_watch(memory mem, uint32_t address, uint32_t size, int count)
+{
+  uint32_t first, last, page;
+
+  if (address >= mem->size)
+    return;
+  first = (address < 3) ? 0 : address - 3;
+  last = (size > mem->size - address) ? mem->size - 1 : address + (size ? size : 1) - 1;
+  if (mem->watches == NULL)
+  {
+    mem->watch_pages = ((mem->size - 1) >> WATCH_PAGE_SHIFT) + 1;
+    mem->watches = calloc(mem->watch_pages, sizeof(uint32_t));
+    error_if_null(mem->watches);
+  }
+  for (page = first >> WATCH_PAGE_SHIFT; page <= last >> WATCH_PAGE_SHIFT; page++)
+    mem->watches[page] += count;
+}
+
+void memory_add_watch(memory mem, uint32_t address, uint32_t size)
+{
+  memory_count_watch(mem, address, size, 1);
+}
+
+void memory_remove_watch(memory mem, uint32_t address, uint32_t size)
+{
+  memory_count_watch(mem, address, size, -1);
+}
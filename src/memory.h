@@ -25,6 +25,17 @@ Contact: Guillaume.Huard@imag.fr
 #include <stdint.h>
 #include <sys/types.h>
 
+#define WATCH_PAGE_SHIFT 12
+
+struct memory_data
+{
+  size_t size;
+  uint8_t *data;
+  // Watches per page, allocated by the first watch, read by memory_watched
+  uint32_t *watches;
+  uint32_t watch_pages;
+};
+
 typedef struct memory_data *memory;
 
 memory memory_create(size_t size);
@@ -44,4 +55,26 @@ int memory_write_byte(memory mem, uint32_t address, uint8_t value);
 int memory_write_half(memory mem, uint32_t address, uint16_t value, uint8_t be);
 int memory_write_word(memory mem, uint32_t address, uint32_t value, uint8_t be);
 
+/* Copy size bytes, in address order, between mem at address and buffer, for
+ * the debugger to move whole blocks at once. Fails (-1) without copying
+ * anything when the block does not fit in mem.
+ */
+int memory_read_block(memory mem, uint32_t address, uint8_t *buffer, size_t size);
+int memory_write_block(memory mem, uint32_t address, const uint8_t *buffer, size_t size);
+
+/* Watches are counted per 4 KiB page of mem, so that the accesses to pages
+ * without watch are told apart by an inline test. A watch of size bytes at
+ * address also marks the 3 bytes before, the start of any access of up to a
+ * word that overlaps the watch is in a watched page.
+ */
+void memory_add_watch(memory mem, uint32_t address, uint32_t size);
+void memory_remove_watch(memory mem, uint32_t address, uint32_t size);
+
+static inline int memory_watched(memory mem, uint32_t address)
+{
+  uint32_t page = address >> WATCH_PAGE_SHIFT;
+
+  return (page < mem->watch_pages) && mem->watches[page];
+}
+
 #endif
@@ -0,0 +1,153 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "memory_stats.h"
+
+struct memory_stats_level {
+    char *name;
+    uint8_t shift;
+    uint32_t size;
+    uint64_t *counters[3];
+};
+
+static struct memory_stats_level pages = { "page", 0, 0, { NULL, NULL, NULL } };
+static struct memory_stats_level lines = { "line", 0, 0, { NULL, NULL, NULL } };
+int memory_stats_enabled = 0;
+
+static int log2_of(uint32_t value) {
+    int result = 0;
+
+    if ((value == 0) || (value & (value - 1)))
+        return -1;
+    while (value >>= 1)
+        result++;
+    return result;
+}
+
+static int memory_stats_level_init(struct memory_stats_level *level, size_t memory_size,
+                                   uint32_t granularity) {
+    int shift, kind;
+
+    shift = log2_of(granularity);
+    if (shift == -1)
+        return -1;
+    level->shift = shift;
+    level->size = (memory_size + granularity - 1) >> shift;
+    for (kind = 0; kind < 3; kind++) {
+        level->counters[kind] = calloc(level->size, sizeof(uint64_t));
+        if (level->counters[kind] == NULL)
+            return -1;
+    }
+    return 0;
+}
+
+int memory_stats_enable(size_t memory_size, uint32_t page_size, uint32_t line_size) {
+    if (memory_stats_level_init(&pages, memory_size, page_size) == -1)
+        return -1;
+    if (line_size && (memory_stats_level_init(&lines, memory_size, line_size) == -1))
+        return -1;
+    memory_stats_enabled = 1;
+    return 0;
+}
+
+void memory_stats_record(uint8_t kind, uint32_t address) {
+    uint32_t index;
+
+    index = address >> pages.shift;
+    if (index < pages.size)
+        pages.counters[kind][index]++;
+    index = address >> lines.shift;
+    if (index < lines.size)
+        lines.counters[kind][index]++;
+}
+
+static void memory_stats_dump_csv(FILE *f, struct memory_stats_level *level, int all) {
+    uint32_t i, start;
+
+    for (i = 0; i < level->size; i++) {
+        if (all || level->counters[MEMORY_STATS_FETCH][i] ||
+            level->counters[MEMORY_STATS_READ][i] || level->counters[MEMORY_STATS_WRITE][i]) {
+            start = i << level->shift;
+            fprintf(f, "%s,%u,0x%08X,0x%08X,%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+                    level->name, i, start, start + (1 << level->shift) - 1,
+                    level->counters[MEMORY_STATS_FETCH][i],
+                    level->counters[MEMORY_STATS_READ][i],
+                    level->counters[MEMORY_STATS_WRITE][i]);
+        }
+    }
+}
+
+static void memory_stats_dump_json(FILE *f, struct memory_stats_level *level, int all) {
+    uint32_t i;
+    int first = 1;
+
+    fprintf(f, "  \"%ss\": [", level->name);
+    for (i = 0; i < level->size; i++) {
+        if (all || level->counters[MEMORY_STATS_FETCH][i] ||
+            level->counters[MEMORY_STATS_READ][i] || level->counters[MEMORY_STATS_WRITE][i]) {
+            fprintf(f, "%s\n    { \"index\": %u, \"start\": %u, \"fetch\": %" PRIu64
+                    ", \"read\": %" PRIu64 ", \"write\": %" PRIu64 " }",
+                    first ? "" : ",", i, i << level->shift,
+                    level->counters[MEMORY_STATS_FETCH][i],
+                    level->counters[MEMORY_STATS_READ][i],
+                    level->counters[MEMORY_STATS_WRITE][i]);
+            first = 0;
+        }
+    }
+    fprintf(f, "\n  ]");
+}
+
+/* Every page is reported, lines are only reported when accessed */
+void memory_stats_dump(FILE *f, int format) {
+    if (!memory_stats_enabled)
+        return;
+    if (format == MEMORY_STATS_JSON) {
+        fprintf(f, "{\n  \"page_size\": %u,\n  \"line_size\": %u,\n",
+                1 << pages.shift, lines.size ? 1 << lines.shift : 0);
+        memory_stats_dump_json(f, &pages, 1);
+        if (lines.size) {
+            fprintf(f, ",\n");
+            memory_stats_dump_json(f, &lines, 0);
+        }
+        fprintf(f, "\n}\n");
+    } else {
+        fprintf(f, "granularity,index,start,end,fetch,read,write\n");
+        memory_stats_dump_csv(f, &pages, 1);
+        if (lines.size)
+            memory_stats_dump_csv(f, &lines, 0);
+    }
+    fflush(f);
+}
+
+void memory_stats_reset() {
+    int kind;
+
+    for (kind = 0; kind < 3; kind++) {
+        if (pages.size)
+            memset(pages.counters[kind], 0, pages.size * sizeof(uint64_t));
+        if (lines.size)
+            memset(lines.counters[kind], 0, lines.size * sizeof(uint64_t));
+    }
+}
@@ -0,0 +1,53 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __MEMORY_STATS_H__
+#define __MEMORY_STATS_H__
+#include <stdio.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* Aggregated view of the memory traffic of the simulated program : opcode
+ * fetches, data reads and data writes are counted per page and, optionally,
+ * per cache line. Sizes must be powers of two, a line size of 0 disables the
+ * per line counters.
+ */
+#define MEMORY_STATS_FETCH 0
+#define MEMORY_STATS_READ  1
+#define MEMORY_STATS_WRITE 2
+
+#define MEMORY_STATS_CSV  0
+#define MEMORY_STATS_JSON 1
+
+int memory_stats_enable(size_t memory_size, uint32_t page_size, uint32_t line_size);
+
+/* Tested inline by memory_stats_access, so that accesses cost a test of a
+ * global variable while the statistics are disabled
+ */
+extern int memory_stats_enabled;
+void memory_stats_record(uint8_t kind, uint32_t address);
+#define memory_stats_access(kind, address) \
+    do { if (memory_stats_enabled) memory_stats_record(kind, address); } while (0)
+void memory_stats_dump(FILE * f, int format);
+void memory_stats_reset();
+
+#endif
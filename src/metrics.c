@@ -0,0 +1,290 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "metrics.h"
+#include "counters.h"
+#include "util.h"
+
+#define MEMORY_PAGE_SIZE 4096
+/* Seconds a client has to send its request, the server answers one client
+ * at a time
+ */
+#define REQUEST_TIMEOUT 1
+
+static arm_core core;
+static int server = -1;
+static char *socket_path = NULL;
+static char *filename = NULL;
+static uint32_t file_interval;
+static pthread_t server_thread, file_thread;
+static int server_running = 0, file_running = 0;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+/* Once stopped, the counters may be freed */
+static int stopped = 0;
+
+/* Copies sampled at each export, so that resetting the counters leaves the
+ * simulated machine alone
+ */
+static uint64_t instructions, cycles, instructions_per_second;
+static uint64_t memory_bytes, memory_pages;
+static uint64_t last_instructions = 0;
+static double last_time = 0;
+
+static double metrics_now() {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+static void metrics_sample() {
+    double now = metrics_now();
+
+    instructions = arm_get_instruction_count(core);
+    cycles = arm_get_cycle_count(core);
+    if ((last_time > 0) && (now > last_time))
+        instructions_per_second = (instructions - last_instructions) / (now - last_time);
+    last_instructions = instructions;
+    last_time = now;
+    memory_bytes = memory_get_size(core->mem);
+    memory_pages = (memory_bytes + MEMORY_PAGE_SIZE - 1) / MEMORY_PAGE_SIZE;
+}
+
+int metrics_write(FILE *f) {
+    int result = -1;
+
+    pthread_mutex_lock(&lock);
+    if (!stopped) {
+        metrics_sample();
+        counters_write_prometheus(f);
+        result = 0;
+    }
+    pthread_mutex_unlock(&lock);
+    return result;
+}
+
+static void metrics_write_file() {
+    char *temporary;
+    int result;
+    FILE *f;
+
+    temporary = malloc(strlen(filename) + 5);
+    error_if_null(temporary);
+    sprintf(temporary, "%s.tmp", filename);
+    f = fopen(temporary, "w");
+    if (f == NULL) {
+        perror("Metrics file");
+    } else {
+        result = metrics_write(f);
+        fclose(f);
+        /* An empty export must not replace the last one */
+        if (result == -1)
+            unlink(temporary);
+        else if (rename(temporary, filename) == -1)
+            perror("Metrics file");
+    }
+    free(temporary);
+}
+
+/* The writer threads are only cancelled while waiting, never in the middle
+ * of an export
+ */
+static void *metrics_file_writer(void *arg) {
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    while (1) {
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+        sleep(file_interval);
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+        metrics_write_file();
+    }
+    return NULL;
+}
+
+/* Answers any request with the metrics, the connection is closed after */
+static void metrics_answer(int connection) {
+    char request[4096], header[256], *body;
+    size_t body_size;
+    ssize_t length;
+    int used = 0;
+    FILE *f;
+
+    /* Up to the end of the request header, the body is ignored */
+    while ((used < sizeof(request) - 1) &&
+           ((length = read(connection, request + used, sizeof(request) - 1 - used)) > 0)) {
+        used += length;
+        request[used] = '\0';
+        if (strstr(request, "\r\n\r\n") || strstr(request, "\n\n"))
+            break;
+    }
+    f = open_memstream(&body, &body_size);
+    error_if_null(f);
+    metrics_write(f);
+    fclose(f);
+    snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\n"
+             "Content-Type: text/plain; version=0.0.4\r\n"
+             "Content-Length: %zu\r\nConnection: close\r\n\r\n", body_size);
+    /* The scraper may have gone away, which must not kill the simulator */
+    if (send(connection, header, strlen(header), MSG_NOSIGNAL) > 0)
+        send(connection, body, body_size, MSG_NOSIGNAL);
+    free(body);
+}
+
+static void *metrics_server(void *arg) {
+    struct timeval timeout = { REQUEST_TIMEOUT, 0 };
+    int connection;
+
+    pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+    while (1) {
+        pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
+        connection = accept(server, NULL, NULL);
+        pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
+        if (connection == -1)
+            continue;
+        /* A client that never completes its request is answered anyway once
+         * the read times out, instead of blocking the others
+         */
+        setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+        metrics_answer(connection);
+        close(connection);
+    }
+    return NULL;
+}
+
+static int metrics_listen_tcp(char *port) {
+    struct sockaddr_in address;
+    int option_value = 1;
+    char *end;
+
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(strtoul(port, &end, 10));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if ((*port == '\0') || (*end != '\0'))
+        return -1;
+    server = socket(PF_INET, SOCK_STREAM, 0);
+    if (server == -1)
+        return -1;
+    setsockopt(server, SOL_SOCKET, SO_REUSEADDR, &option_value, sizeof(option_value));
+    return bind(server, (struct sockaddr *) &address, sizeof(address));
+}
+
+static int metrics_listen_unix(char *path) {
+    struct sockaddr_un address;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if ((*path == '\0') || (strlen(path) >= sizeof(address.sun_path)))
+        return -1;
+    strcpy(address.sun_path, path);
+    server = socket(PF_UNIX, SOCK_STREAM, 0);
+    if (server == -1)
+        return -1;
+    /* Left by a previous run */
+    unlink(path);
+    if (bind(server, (struct sockaddr *) &address, sizeof(address)) == -1)
+        return -1;
+    socket_path = path;
+    return 0;
+}
+
+static void metrics_add_counters() {
+    /* Registered once, whatever the number of endpoints */
+    if (counters_find("simulator_instructions_total", NULL))
+        return;
+    counters_add("simulator_instructions_total", NULL, "Instructions retired", COUNTER,
+                 &instructions);
+    counters_add("simulator_cycles_total", NULL, "Cycles of the timing model", COUNTER, &cycles);
+    counters_add("simulator_instructions_per_second", NULL,
+                 "Instructions retired per second since the previous export", GAUGE,
+                 &instructions_per_second);
+    counters_add("memory_bytes", NULL, "Simulated memory allocated", GAUGE, &memory_bytes);
+    counters_add("memory_pages", NULL, "Simulated memory allocated, in 4096 bytes pages", GAUGE,
+                 &memory_pages);
+}
+
+int metrics_start(char *endpoint, arm_core p, uint32_t interval) {
+    int result;
+
+    core = p;
+    if (strncmp(endpoint, "file:", 5) == 0) {
+        if ((endpoint[5] == '\0') || (interval == 0))
+            return -1;
+        filename = endpoint + 5;
+        file_interval = interval;
+        metrics_add_counters();
+        metrics_write_file();
+        file_running = pthread_create(&file_thread, NULL, metrics_file_writer, NULL) == 0;
+        return 0;
+    }
+    if (strncmp(endpoint, "http:", 5) == 0)
+        result = metrics_listen_tcp(endpoint + 5);
+    else if (strncmp(endpoint, "unix:", 5) == 0)
+        result = metrics_listen_unix(endpoint + 5);
+    else
+        return -1;
+    if ((result == -1) || (listen(server, 4) == -1)) {
+        perror("Metrics endpoint");
+        return -1;
+    }
+    metrics_add_counters();
+    server_running = pthread_create(&server_thread, NULL, metrics_server, NULL) == 0;
+    return 0;
+}
+
+void metrics_stop() {
+    /* The file writer is done before the last export, which nothing
+     * replaces after
+     */
+    if (file_running) {
+        pthread_cancel(file_thread);
+        pthread_join(file_thread, NULL);
+        file_running = 0;
+    }
+    if (filename)
+        metrics_write_file();
+    if (server_running) {
+        pthread_cancel(server_thread);
+        pthread_join(server_thread, NULL);
+        server_running = 0;
+    }
+    if (server != -1) {
+        close(server);
+        server = -1;
+    }
+    if (socket_path) {
+        unlink(socket_path);
+        socket_path = NULL;
+    }
+    pthread_mutex_lock(&lock);
+    stopped = 1;
+    pthread_mutex_unlock(&lock);
+}
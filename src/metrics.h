@@ -0,0 +1,48 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __METRICS_H__
+#define __METRICS_H__
+#include <stdio.h>
+#include <stdint.h>
+#include "arm_core.h"
+
+/* Export of the counters registry in the Prometheus text exposition format,
+ * along with the state of the simulated machine, sampled at each export :
+ * instructions and cycles executed, instructions per second since the
+ * previous export and memory allocated. The endpoint is one of :
+ *   http:port  HTTP server on the loopback interface, any path
+ *   unix:path  HTTP server on a unix socket (curl --unix-socket path ...)
+ *   file:path  file rewritten every interval seconds (through a temporary
+ *              file renamed, so that readers never see a partial export)
+ * Returns -1 when the endpoint is invalid or cannot be opened.
+ */
+int metrics_start(char *endpoint, arm_core p, uint32_t interval);
+/* Stops the server and file writer, after a last export of a file endpoint,
+ * and removes the unix socket. No export is done after.
+ */
+void metrics_stop();
+
+/* Returns -1, writing nothing, once stopped */
+int metrics_write(FILE * f);
+
+#endif
@@ -0,0 +1,283 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <pthread.h>
+#include "arm.h"
+#include "arm_data_processing.h"
+#include "gdb_protocol.h"
+#include "memory.h"
+#include "registers.h"
+#include "util.h"
+
+/* Microbenchmarks of the building blocks of the simulator, each timed in
+ * isolation over a number of batches of iterations : the mean time per
+ * operation and its standard deviation over the batches tell which layer a
+ * regression comes from. Each operation of a benchmark is selected from the
+ * iteration number so that the compiler cannot hoist it out of the loop.
+ */
+#define MEMORY_SIZE 0x8000
+
+struct microbenchmark {
+    char name[64];
+    void (*function)(struct microbenchmark *b, long iterations);
+    uint32_t parameter;
+};
+
+static memory mem;
+static registers reg;
+static arm_core arm;
+static gdb_protocol_data_t gdb;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile uint32_t sink;
+
+static void memory_read_word_benchmark(struct microbenchmark *b, long iterations) {
+    uint32_t value, sum = 0;
+    long i;
+
+    for (i = 0; i < iterations; i++) {
+        memory_read_word(mem, (i * 4) & (MEMORY_SIZE - 4), &value, 1);
+        sum += value;
+    }
+    sink = sum;
+}
+
+static void registers_read_benchmark(struct microbenchmark *b, long iterations) {
+    uint32_t sum = 0;
+    long i;
+
+    for (i = 0; i < iterations; i++)
+        sum += registers_read(reg, i & 15, b->parameter);
+    sink = sum;
+}
+
+static void verif_cond_benchmark(struct microbenchmark *b, long iterations) {
+    uint32_t sum = 0;
+    long i;
+
+    for (i = 0; i < iterations; i++)
+        sum += verif_cond((i % 15) << 28, reg);
+    sink = sum;
+}
+
+/* The decoding of arm_execute_instruction, down to the specialized decoder */
+static int decode(uint32_t ins) {
+    switch (get_bits(ins, 27, 25)) {
+    case 0:
+        if (get_bits(ins, 24, 23) == 0b10 && !get_bit(ins, 20))
+            return 1;
+        if (get_bit(ins, 4) & get_bit(ins, 7))
+            return 2;
+        return 0;
+    case 1:
+        if (get_bits(ins, 24, 23) == 0b10 && get_bits(ins, 21, 20) == 0b10)
+            return 1;
+        return 0;
+    case 2:
+    case 3:
+        return 2;
+    case 4:
+        return 3;
+    case 5:
+        return 4;
+    case 7:
+        return get_bit(ins, 24) ? 5 : 6;
+    default:
+        return 6;
+    }
+}
+
+static uint32_t decode_instructions[] = {
+    0xE0810002, 0xE2811001, 0xE1A00000, 0xE5910000, 0xE7962001, 0xE8BD8000,
+    0xEAFFFFFE, 0xEF123456, 0xE1540002, 0xE3510B01, 0xE0000291, 0xE10F0000,
+    0xE1D031B4, 0x1AFFFFFC, 0xE4903004, 0xEE010F10
+};
+
+static void decode_benchmark(struct microbenchmark *b, long iterations) {
+    uint32_t sum = 0;
+    long i;
+
+    for (i = 0; i < iterations; i++)
+        sum += decode(decode_instructions[i & 15]);
+    sink = sum;
+}
+
+/* <opcode>(s) r2, r1, #(iteration & 0xFF), with S set for the tests */
+static void data_processing_benchmark(struct microbenchmark *b, long iterations) {
+    uint32_t ins = 0xE2012000 | (b->parameter << 21);
+    long i;
+
+    if ((b->parameter >= 8) && (b->parameter <= 11))
+        ins |= 1 << 20;
+    for (i = 0; i < iterations; i++)
+        arm_data_processing_immediate(arm, ins | (i & 0xFF));
+    sink = arm_read_register(arm, 2);
+}
+
+static char *packets[] = { "$g#67", "$m0,40#2d", "$m0,400#5d", "$x0,400#68", "$?#3f", "$pf#d6" };
+
+static void gdb_packet_analysis_benchmark(struct microbenchmark *b, long iterations) {
+    char packet[32];
+    long i;
+
+    for (i = 0; i < iterations; i++) {
+        // The analysis overwrites the checksum
+        strcpy(packet, packets[b->parameter]);
+        gdb_packet_analysis(gdb, packet, strlen(packet));
+    }
+}
+
+static char *opcode_names[] = { "and", "eor", "sub", "rsb", "add", "adc", "sbc", "rsc",
+    "tst", "teq", "cmp", "cmn", "orr", "mov", "bic", "mvn"
+};
+
+static char *mode_names[] = { "usr", "fiq", "irq", "svc", "abt", "und", "sys" };
+static uint32_t modes[] = { USR, FIQ, IRQ, SVC, ABT, UND, SYS };
+
+static struct microbenchmark benchmarks[64];
+static int benchmarks_number = 0;
+
+static void add(void (*function)(struct microbenchmark *, long), uint32_t parameter,
+                char *format, char *argument) {
+    struct microbenchmark *b = &benchmarks[benchmarks_number++];
+
+    snprintf(b->name, sizeof(b->name), format, argument);
+    b->function = function;
+    b->parameter = parameter;
+}
+
+static double now() {
+    struct timespec t;
+
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+void usage(char *name) {
+    fprintf(stderr, "Usage:\n"
+            "%s [ --help ] [ --iterations number ] [ --batches number ] [ filter ... ]\n\n"
+            "Times the building blocks of the simulator (memory_read_word,"
+            " registers_read per mode, verif_cond, decoding,"
+            " arm_data_processing_immediate per opcode, gdb_packet_analysis per"
+            " packet) over the given number of batches (10 by default) of the"
+            " given number of iterations (1000000 by default, divided by 10 for"
+            " gdb packets). Prints the mean time per operation in ns, its"
+            " standard deviation over the batches and the fastest batch. Only"
+            " the benchmarks whose name contains one of the filters are run.\n",
+            name);
+}
+
+int main(int argc, char *argv[]) {
+    struct option longopts[] = {
+        { "iterations", required_argument, NULL, 'n' },
+        { "batches", required_argument, NULL, 'b' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    long iterations = 1000000, count;
+    int batches = 10, opt, i, j, selected;
+    double start, time, sum, square_sum, mean, best;
+    int fd;
+
+    while ((opt = getopt_long(argc, argv, "n:b:h", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'n':
+            iterations = atol(optarg);
+            break;
+        case 'b':
+            batches = atoi(optarg);
+            break;
+        case 'h':
+            usage(argv[0]);
+            exit(0);
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if ((iterations < 10) || (batches < 2)) {
+        fprintf(stderr, "At least 10 iterations and 2 batches are needed\n");
+        exit(1);
+    }
+
+    // gdb answers are thrown away
+    fd = open("/dev/null", O_WRONLY);
+    gdb_init();
+    arm_init();
+    mem = memory_create(MEMORY_SIZE);
+    reg = registers_create();
+    arm = arm_create(reg, mem);
+    gdb = gdb_init_data(arm, reg, mem, fd, &lock);
+
+    add(memory_read_word_benchmark, 0, "memory_read_word", NULL);
+    for (i = 0; i < sizeof(modes) / sizeof(uint32_t); i++)
+        add(registers_read_benchmark, modes[i], "registers_read %s", mode_names[i]);
+    add(verif_cond_benchmark, 0, "verif_cond", NULL);
+    add(decode_benchmark, 0, "decode", NULL);
+    for (i = 0; i < 16; i++)
+        add(data_processing_benchmark, i, "arm_data_processing_immediate %s", opcode_names[i]);
+    for (i = 0; i < sizeof(packets) / sizeof(char *); i++)
+        add(gdb_packet_analysis_benchmark, i, "gdb_packet_analysis %s", packets[i]);
+
+    printf("%-40s %10s %10s %10s\n", "benchmark", "ns/op", "stddev", "min");
+    for (i = 0; i < benchmarks_number; i++) {
+        selected = (optind == argc);
+        for (j = optind; j < argc; j++)
+            selected |= strstr(benchmarks[i].name, argv[j]) != NULL;
+        if (!selected)
+            continue;
+        count = iterations;
+        if (benchmarks[i].function == gdb_packet_analysis_benchmark)
+            count /= 10;
+        // Warm up, then measured batches
+        benchmarks[i].function(&benchmarks[i], count / 10);
+        sum = square_sum = 0;
+        best = -1;
+        for (j = 0; j < batches; j++) {
+            start = now();
+            benchmarks[i].function(&benchmarks[i], count);
+            time = (now() - start) / count;
+            sum += time;
+            square_sum += time * time;
+            if ((best < 0) || (time < best))
+                best = time;
+        }
+        mean = sum / batches;
+        printf("%-40s %10.2f %10.2f %10.2f\n", benchmarks[i].name, mean,
+               sqrt(fmax(0, (square_sum - batches * mean * mean) / (batches - 1))), best);
+    }
+
+    gdb_release_data(gdb);
+    arm_destroy(arm);
+    registers_destroy(reg);
+    memory_destroy(mem);
+    close(fd);
+    return 0;
+}
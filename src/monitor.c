@@ -0,0 +1,259 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include "monitor.h"
+#include "trace.h"
+#include "counters.h"
+#include "memory_stats.h"
+#include "timing.h"
+#include "elf_reader.h"
+#include "replay.h"
+#include "arm_constants.h"
+#include "arm_exception.h"
+
+#define MAX_ARGUMENTS 8
+
+typedef int (*monitor_handler_t)(arm_core, int, char **, FILE *);
+
+struct monitor_entry {
+    char *name;
+    char *usage;
+    monitor_handler_t run;
+};
+
+/* Program loaded by the last reload, reused when none is given */
+static char *program = NULL;
+
+static int monitor_help(arm_core p, int argc, char **argv, FILE *f);
+
+/* -1 when the word is neither on nor off */
+static int monitor_switch(char *word) {
+    if (strcmp(word, "on") == 0)
+        return 1;
+    if (strcmp(word, "off") == 0)
+        return 0;
+    return -1;
+}
+
+static int monitor_trace(arm_core p, int argc, char **argv, FILE *f) {
+    int on, flags;
+
+    if ((argc < 2) || ((on = monitor_switch(argv[argc - 1])) == -1))
+        return -1;
+    if (argc == 2) {
+        if (on)
+            trace_enable();
+        else
+            trace_disable();
+        fprintf(f, "Tracing %s\n", argv[1]);
+        return 0;
+    }
+    if ((argc == 4) && (strcmp(argv[1], "state") == 0)) {
+        flags = arm_get_mode_number(argv[2]);
+        if (flags == -1) {
+            fprintf(f, "Unknown mode %s\n", argv[2]);
+            return -1;
+        }
+    } else if (argc != 3) {
+        return -1;
+    } else if (strcmp(argv[1], "registers") == 0) {
+        flags = REGISTERS;
+    } else if (strcmp(argv[1], "memory") == 0) {
+        flags = MEMORY;
+    } else if (strcmp(argv[1], "position") == 0) {
+        flags = POSITION;
+    } else {
+        return -1;
+    }
+    if (on)
+        trace_add(flags);
+    else
+        trace_remove(flags);
+    fprintf(f, "Trace %s%s%s %s\n", argv[1], argc == 4 ? " " : "", argc == 4 ? argv[2] : "",
+            argv[argc - 1]);
+    return 0;
+}
+
+static int monitor_counters(arm_core p, int argc, char **argv, FILE *f) {
+    if (argc == 1) {
+        counters_dump(f);
+        return 0;
+    }
+    if ((argc == 2) && (strcmp(argv[1], "reset") == 0)) {
+        counters_reset();
+        fprintf(f, "Counters reset\n");
+        return 0;
+    }
+    return -1;
+}
+
+static int monitor_memory_stats(arm_core p, int argc, char **argv, FILE *f) {
+    if ((argc > 2) || ((argc == 2) && (strcmp(argv[1], "reset") != 0)))
+        return -1;
+    if (!memory_stats_enabled) {
+        fprintf(f, "Memory statistics are not enabled\n");
+        return 0;
+    }
+    if (argc == 1) {
+        memory_stats_dump(f, MEMORY_STATS_CSV);
+    } else {
+        memory_stats_reset();
+        fprintf(f, "Memory statistics reset\n");
+    }
+    return 0;
+}
+
+static int monitor_timing(arm_core p, int argc, char **argv, FILE *f) {
+    if (argc != 2)
+        return -1;
+    /* An invalid table falls back to arm9e, which is then in place */
+    if (timing_select(argv[1]) == -1)
+        fprintf(f, "Invalid timing table %s, arm9e selected instead\n", argv[1]);
+    else
+        fprintf(f, "Timing %s selected\n", argv[1]);
+    return 0;
+}
+
+static int monitor_segment_fits(arm_core p, struct elf_segment *segment) {
+    size_t size = memory_get_size(p->mem);
+
+    return (segment->memory_size <= size) && (segment->address <= size - segment->memory_size);
+}
+
+/* Writes a segment as gdb load would, so that it is recorded as well */
+static int monitor_load_segment(arm_core p, struct elf_segment *segment) {
+    uint8_t *content;
+    int result;
+
+    content = calloc(segment->memory_size, 1);
+    if (content == NULL)
+        return -1;
+    memcpy(content, segment->content, segment->file_size);
+    result = memory_write_block(p->mem, segment->address, content, segment->memory_size);
+    if (result == 0)
+        replay_record_memory(p, segment->address, content, segment->memory_size);
+    free(content);
+    return result;
+}
+
+static void monitor_reset(arm_core p) {
+    uint8_t mode;
+    int i;
+
+    arm_reset(p);
+    replay_record_irq(p, RESET);
+    mode = registers_get_mode(p->reg);
+    for (i = 0; i <= 13; i++)
+        replay_record_register(p, i, mode, registers_read(p->reg, i, mode));
+}
+
+static int monitor_reload(arm_core p, int argc, char **argv, FILE *f) {
+    elf_reader elf;
+    uint32_t entry;
+    int i;
+
+    if (argc > 2)
+        return -1;
+    if (argc == 2) {
+        free(program);
+        program = strdup(argv[1]);
+    }
+    if (program == NULL) {
+        fprintf(f, "No program given\n");
+        return -1;
+    }
+    elf = elf_reader_open(program);
+    if (elf == NULL) {
+        fprintf(f, "Cannot read %s\n", program);
+        return -1;
+    }
+    /* Nothing is written unless the whole program fits */
+    for (i = 0; i < elf_reader_segments_number(elf); i++) {
+        if (!monitor_segment_fits(p, elf_reader_segment(elf, i))) {
+            fprintf(f, "Segment at %08X does not fit in memory\n",
+                    elf_reader_segment(elf, i)->address);
+            elf_reader_close(elf);
+            return -1;
+        }
+    }
+    for (i = 0; i < elf_reader_segments_number(elf); i++) {
+        if (monitor_load_segment(p, elf_reader_segment(elf, i)) == -1) {
+            fprintf(f, "Cannot load the segment at %08X\n", elf_reader_segment(elf, i)->address);
+            elf_reader_close(elf);
+            return -1;
+        }
+    }
+    entry = elf_reader_entry(elf);
+    elf_reader_close(elf);
+    monitor_reset(p);
+    if (entry != 0) {
+        arm_write_register(p, 15, entry);
+        replay_record_register(p, 15, registers_get_mode(p->reg), entry);
+    }
+    fprintf(f, "Loaded %s, %d segments, entry %08X\n", program, i, entry);
+    return 0;
+}
+
+static struct monitor_entry commands[] = {
+    { "trace", "trace on|off, trace registers|memory|position on|off, trace state mode on|off",
+     monitor_trace },
+    { "counters", "counters [reset]", monitor_counters },
+    { "memory_stats", "memory_stats [reset]", monitor_memory_stats },
+    { "timing", "timing flat|arm9e|file", monitor_timing },
+    { "reload", "reload [elf_file]", monitor_reload },
+    { "help", "help", monitor_help },
+    { NULL, NULL, NULL }
+};
+
+static int monitor_help(arm_core p, int argc, char **argv, FILE *f) {
+    int i;
+
+    for (i = 0; commands[i].name; i++)
+        fprintf(f, "%s\n", commands[i].usage);
+    return 0;
+}
+
+int monitor_command(arm_core p, char *command, FILE *f) {
+    char *argv[MAX_ARGUMENTS + 1], *saved;
+    int argc = 0, i, too_many;
+
+    for (argv[0] = strtok_r(command, " \t\n", &saved); argv[argc] && (argc < MAX_ARGUMENTS);
+         argv[argc] = strtok_r(NULL, " \t\n", &saved))
+        argc++;
+    if (argc == 0)
+        return monitor_help(p, argc, argv, f);
+    /* argv[MAX_ARGUMENTS] holds the first argument that did not fit */
+    too_many = (argc == MAX_ARGUMENTS) && argv[argc];
+    for (i = 0; commands[i].name; i++) {
+        if (strcmp(argv[0], commands[i].name) == 0) {
+            if (too_many || (commands[i].run(p, argc, argv, f) == -1)) {
+                fprintf(f, "Usage : %s\n", commands[i].usage);
+                return -1;
+            }
+            return 0;
+        }
+    }
+    fprintf(f, "Unknown monitor command %s, try help\n", argv[0]);
+    return -1;
+}
@@ -0,0 +1,44 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __MONITOR_H__
+#define __MONITOR_H__
+#include <stdio.h>
+#include "arm_core.h"
+
+/* Commands of the gdb monitor (qRcmd packets, "monitor command" in gdb),
+ * changing the instrumentation of a running simulation without restarting
+ * it, so that caches, predictors and counters stay warm :
+ *   trace on|off                            all tracing
+ *   trace registers|memory|position on|off  one kind of trace record
+ *   trace state mode on|off                 processor state of a mode
+ *   counters [reset]                        counters registry
+ *   memory_stats [reset]                    memory statistics, in CSV
+ *   timing flat|arm9e|file                  timing model of the cycle count
+ *   reload [elf_file]                       loads the program again and resets
+ *   help
+ * Their output is written to f. Returns -1 for an unknown command or invalid
+ * arguments, with an explanation in f.
+ */
+int monitor_command(arm_core p, char *command, FILE * f);
+
+#endif
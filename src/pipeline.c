@@ -0,0 +1,215 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <inttypes.h>
+#include "pipeline.h"
+#include "timing.h"
+#include "counters.h"
+#include "util.h"
+
+#define LOAD_USE 0
+#define FLAGS 1
+#define PC_WRITE 2
+#define CAUSES 3
+
+static char *cause_names[CAUSES] = { "load_use", "flags", "pc_write" };
+
+static int enabled = 0;
+/* Registers loaded by the previous instruction and when they are available */
+static uint16_t loaded_registers = 0;
+static uint32_t load_latency = 0;
+static uint32_t flags_latency = 0;
+static uint64_t stalls[CAUSES], stall_cycles[CAUSES];
+
+void pipeline_enable() {
+    char labels[32];
+    int i;
+
+    enabled = 1;
+    timing_charge_latencies(0);
+    for (i = 0; i < CAUSES; i++) {
+        snprintf(labels, sizeof(labels), "cause=\"%s\"", cause_names[i]);
+        counters_add("pipeline_stalls", labels, "Pipeline stalls by cause", COUNTER,
+                     &stalls[i]);
+        counters_add("pipeline_stall_cycles", labels, "Cycles lost in pipeline stalls by cause",
+                     COUNTER, &stall_cycles[i]);
+    }
+}
+
+#define bit(r) (1 << (r))
+
+/* Registers read by the instruction, the PC excluded */
+static uint16_t pipeline_sources(uint32_t ins) {
+    uint16_t sources = 0;
+    uint32_t opcode;
+
+    switch (get_bits(ins, 27, 25)) {
+    case 0b000:
+        if ((ins & 0x0FFFFFD0) == 0x012FFF10)
+            return bit(get_bits(ins, 3, 0));
+        if ((ins & 0x0F0000F0) == 0x00000090) {
+            sources = bit(get_bits(ins, 3, 0)) | bit(get_bits(ins, 11, 8));
+            if (get_bit(ins, 21))
+                sources |= bit(get_bits(ins, 15, 12));
+            if (get_bit(ins, 21) && get_bit(ins, 23))
+                sources |= bit(get_bits(ins, 19, 16));
+            return sources;
+        }
+        if ((ins & 0x0FB00FF0) == 0x01000090)
+            return bit(get_bits(ins, 3, 0)) | bit(get_bits(ins, 19, 16));
+        if (get_bit(ins, 7) && get_bit(ins, 4)) {
+            sources = bit(get_bits(ins, 19, 16));
+            if (!get_bit(ins, 22))
+                sources |= bit(get_bits(ins, 3, 0));
+            if (!get_bit(ins, 20))
+                sources |= bit(get_bits(ins, 15, 12));
+            return sources;
+        }
+        if ((ins & 0x0FBF0FFF) == 0x010F0000)
+            return 0;
+        if ((ins & 0x0FB0FFF0) == 0x0120F000)
+            return bit(get_bits(ins, 3, 0));
+        sources = bit(get_bits(ins, 3, 0));
+        if (get_bit(ins, 4))
+            sources |= bit(get_bits(ins, 11, 8));
+        /* Fall through */
+    case 0b001:
+        if ((ins & 0x0FB00000) == 0x03200000)
+            return 0;
+        opcode = get_bits(ins, 24, 21);
+        if ((opcode != 0b1101) && (opcode != 0b1111))
+            sources |= bit(get_bits(ins, 19, 16));
+        return sources;
+    case 0b011:
+        sources = bit(get_bits(ins, 3, 0));
+        /* Fall through */
+    case 0b010:
+        sources |= bit(get_bits(ins, 19, 16));
+        if (!get_bit(ins, 20))
+            sources |= bit(get_bits(ins, 15, 12));
+        return sources;
+    case 0b100:
+        sources = bit(get_bits(ins, 19, 16));
+        if (!get_bit(ins, 20))
+            sources |= get_bits(ins, 15, 0);
+        return sources;
+    default:
+        return 0;
+    }
+}
+
+/* Non zero when the instruction needs the flags : conditional execution,
+ * carry input or status register read
+ */
+static int pipeline_reads_flags(uint32_t ins) {
+    uint32_t opcode;
+
+    if (get_bits(ins, 31, 28) < 0b1110)
+        return 1;
+    if ((ins & 0x0FBF0FFF) == 0x010F0000)
+        return 1;
+    if ((get_bits(ins, 27, 26) != 0b00) || ((ins & 0x0E000090) == 0x00000090))
+        return 0;
+    opcode = get_bits(ins, 24, 21);
+    if ((opcode >= 0b0101) && (opcode <= 0b0111))
+        return 1;
+    /* rrx */
+    return !get_bit(ins, 25) && ((ins & 0x00000FF0) == 0x00000060);
+}
+
+static void pipeline_stall(arm_core p, int cause, uint32_t cycles) {
+    stalls[cause]++;
+    stall_cycles[cause] += cycles;
+    p->cycle_count += cycles;
+}
+
+void pipeline_instruction(arm_core p, int executed) {
+    uint32_t ins = p->current_instruction, pc;
+    uint32_t stall = 0;
+    int cause = LOAD_USE;
+
+    if (!enabled)
+        return;
+    if (executed && (pipeline_sources(ins) & loaded_registers)) {
+        stall = load_latency;
+        cause = LOAD_USE;
+    }
+    if (flags_latency && pipeline_reads_flags(ins) && (flags_latency > stall)) {
+        stall = flags_latency;
+        cause = FLAGS;
+    }
+    if (stall)
+        pipeline_stall(p, cause, stall);
+
+    loaded_registers = 0;
+    flags_latency = 0;
+    if (executed) {
+        pc = registers_read(p->reg, 15, registers_get_mode(p->reg));
+        /* With a branch predictor, only its mispredictions are charged */
+        if ((pc != p->current_address + 4) && timing_refills_charged()) {
+            stalls[PC_WRITE]++;
+            stall_cycles[PC_WRITE] += timing_get(TIMING_PC_WRITE);
+        }
+        switch (get_bits(ins, 27, 25)) {
+        case 0b000:
+            if ((ins & 0x0F0000F0) == 0x00000090) {
+                if (get_bit(ins, 20))
+                    flags_latency = timing_get(TIMING_FLAG_LATENCY);
+            } else if ((ins & 0x0FB00FF0) == 0x01000090) {
+                loaded_registers = bit(get_bits(ins, 15, 12));
+                load_latency = timing_get(TIMING_LOAD_LATENCY);
+            } else if (get_bit(ins, 7) && get_bit(ins, 4) && get_bit(ins, 20)) {
+                loaded_registers = bit(get_bits(ins, 15, 12));
+                load_latency = timing_get(TIMING_LOAD_SUB_WORD_LATENCY);
+            }
+            break;
+        case 0b010:
+        case 0b011:
+            if (get_bit(ins, 20)) {
+                loaded_registers = bit(get_bits(ins, 15, 12));
+                load_latency = timing_get(get_bit(ins, 22) ? TIMING_LOAD_SUB_WORD_LATENCY :
+                                          TIMING_LOAD_LATENCY);
+            }
+            break;
+        case 0b100:
+            /* Only the last loaded register is late */
+            if (get_bit(ins, 20) && get_bits(ins, 15, 0)) {
+                loaded_registers = bit(31 - __builtin_clz(get_bits(ins, 15, 0)));
+                load_latency = timing_get(TIMING_LOAD_LATENCY);
+            }
+            break;
+        }
+        /* The PC is never waited for, a load into it is a refill */
+        loaded_registers &= ~bit(15);
+    }
+}
+
+void pipeline_report(FILE *f) {
+    int i;
+
+    if (!enabled)
+        return;
+    fprintf(f, "Pipeline stalls :\n");
+    for (i = 0; i < CAUSES; i++)
+        fprintf(f, "%10s : %" PRIu64 " stalls, %" PRIu64 " cycles\n", cause_names[i], stalls[i],
+                stall_cycles[i]);
+}
@@ -0,0 +1,42 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+#include <stdio.h>
+#include <stdint.h>
+#include "arm_core.h"
+
+/* ARM9 like five stage pipeline hazards, computed from the registers and
+ * flags read and written by consecutive instructions : an instruction using
+ * the result of the load just before it, or flags that are not yet available,
+ * stalls for the latency given by the timing table (see timing.h). Refills
+ * due to PC writes are charged by the timing table and only counted here,
+ * unless a branch predictor charges its mispredictions instead.
+ * Stalls are counted per cause in the counters registry.
+ */
+void pipeline_enable();
+/* To be called after each fetched instruction, executed or not */
+void pipeline_instruction(arm_core p, int executed);
+void pipeline_report(FILE * f);
+
+#endif
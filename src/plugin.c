@@ -0,0 +1,204 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <dlfcn.h>
+#include "plugin.h"
+#include "disassembler.h"
+
+#define MAX_HOOKS 16
+#define MAX_PLUGINS 16
+
+struct hook {
+    void *function;
+    void *data;
+};
+
+struct event {
+    struct hook hooks[MAX_HOOKS];
+    int number;
+};
+
+enum { EVENT_INSTRUCTION, EVENT_BASIC_BLOCK, EVENT_MEMORY, EVENT_REGISTER_WRITE, EVENT_EXCEPTION,
+    EVENT_SWI, EVENTS
+};
+
+uint32_t plugin_subscribed = 0;
+static struct event events[EVENTS];
+static void *plugins[MAX_PLUGINS];
+static int plugins_number = 0;
+/* Previous instruction, to find the start of basic blocks */
+static int block_started = 0;
+static uint32_t previous_address, previous_instruction;
+
+static int plugin_add_hook(int event, void *function, void *data) {
+    struct event *e = &events[event];
+
+    if (e->number == MAX_HOOKS)
+        return -1;
+    e->hooks[e->number].function = function;
+    e->hooks[e->number].data = data;
+    e->number++;
+    plugin_subscribed |= 1 << event;
+    return 0;
+}
+
+int plugin_add_instruction_hook(plugin_instruction_hook hook, void *data) {
+    return plugin_add_hook(EVENT_INSTRUCTION, hook, data);
+}
+
+int plugin_add_basic_block_hook(plugin_basic_block_hook hook, void *data) {
+    return plugin_add_hook(EVENT_BASIC_BLOCK, hook, data);
+}
+
+int plugin_add_memory_hook(plugin_memory_hook hook, void *data) {
+    return plugin_add_hook(EVENT_MEMORY, hook, data);
+}
+
+int plugin_add_register_hook(plugin_register_hook hook, void *data) {
+    return plugin_add_hook(EVENT_REGISTER_WRITE, hook, data);
+}
+
+int plugin_add_exception_hook(plugin_exception_hook hook, void *data) {
+    return plugin_add_hook(EVENT_EXCEPTION, hook, data);
+}
+
+int plugin_add_swi_hook(plugin_swi_hook hook, void *data) {
+    return plugin_add_hook(EVENT_SWI, hook, data);
+}
+
+void plugin_remove_hooks() {
+    int i;
+
+    for (i = 0; i < EVENTS; i++)
+        events[i].number = 0;
+    plugin_subscribed = 0;
+    block_started = 0;
+}
+
+int plugin_load(char *filename, char *arguments) {
+    int (*init)(char *);
+    void *handle;
+
+    if (plugins_number == MAX_PLUGINS) {
+        fprintf(stderr, "Too many plugins, %s not loaded\n", filename);
+        return -1;
+    }
+    handle = dlopen(filename, RTLD_NOW);
+    if (handle == NULL) {
+        fprintf(stderr, "Cannot load plugin : %s\n", dlerror());
+        return -1;
+    }
+    init = (int (*)(char *)) dlsym(handle, "plugin_init");
+    if (init == NULL) {
+        fprintf(stderr, "Plugin %s has no plugin_init\n", filename);
+        dlclose(handle);
+        return -1;
+    }
+    if (init(arguments) != 0) {
+        fprintf(stderr, "Initialization of plugin %s failed\n", filename);
+        dlclose(handle);
+        return -1;
+    }
+    plugins[plugins_number++] = handle;
+    return 0;
+}
+
+/* The hooks are removed before the plugins holding them are closed */
+void plugin_unload_all() {
+    void (*fini)();
+    int i;
+
+    for (i = 0; i < plugins_number; i++) {
+        fini = (void (*)()) dlsym(plugins[i], "plugin_fini");
+        if (fini)
+            fini();
+    }
+    plugin_remove_hooks();
+    for (i = 0; i < plugins_number; i++)
+        dlclose(plugins[i]);
+    plugins_number = 0;
+}
+
+void plugin_dispatch_instruction(arm_core p) {
+    struct event *e = &events[EVENT_INSTRUCTION];
+    int i;
+
+    for (i = 0; i < e->number; i++)
+        ((plugin_instruction_hook) e->hooks[i].function) (p, p->current_address,
+                                                          p->current_instruction,
+                                                          e->hooks[i].data);
+}
+
+/* Before the fetch : p->current_* still describe the previous instruction */
+void plugin_dispatch_basic_block(arm_core p) {
+    struct event *e = &events[EVENT_BASIC_BLOCK];
+    uint32_t address;
+    int i;
+
+    address = registers_read(p->reg, 15, registers_get_mode(p->reg));
+    if (!block_started || (address != previous_address + 4) ||
+        arm_is_control_transfer(previous_instruction)) {
+        for (i = 0; i < e->number; i++)
+            ((plugin_basic_block_hook) e->hooks[i].function) (p, address, e->hooks[i].data);
+    }
+    block_started = 1;
+    previous_address = address;
+    /* Out of memory, the next fetch aborts and no block follows */
+    if (arm_peek_word(p, address, &previous_instruction))
+        previous_instruction = 0;
+}
+
+void plugin_dispatch_memory(arm_core p, uint32_t address, uint8_t size, uint8_t type,
+                            uint32_t value) {
+    struct event *e = &events[EVENT_MEMORY];
+    int i;
+
+    for (i = 0; i < e->number; i++)
+        ((plugin_memory_hook) e->hooks[i].function) (p, address, size, type, value,
+                                                     e->hooks[i].data);
+}
+
+void plugin_dispatch_register(arm_core p, uint8_t reg, uint8_t mode, uint32_t value) {
+    struct event *e = &events[EVENT_REGISTER_WRITE];
+    int i;
+
+    for (i = 0; i < e->number; i++)
+        ((plugin_register_hook) e->hooks[i].function) (p, reg, mode, value, e->hooks[i].data);
+}
+
+void plugin_dispatch_exception(arm_core p, uint8_t exception) {
+    struct event *e = &events[EVENT_EXCEPTION];
+    int i;
+
+    for (i = 0; i < e->number; i++)
+        ((plugin_exception_hook) e->hooks[i].function) (p, exception, e->hooks[i].data);
+}
+
+void plugin_dispatch_swi(arm_core p, uint32_t number) {
+    struct event *e = &events[EVENT_SWI];
+    int i;
+
+    for (i = 0; i < e->number; i++)
+        ((plugin_swi_hook) e->hooks[i].function) (p, number, e->hooks[i].data);
+}
@@ -0,0 +1,108 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __PLUGIN_H__
+#define __PLUGIN_H__
+#include <stdint.h>
+#include "arm_core.h"
+
+/* Instrumentation hooks : analyses register callbacks, along with a pointer
+ * given back to them, on the events of the simulation. Each call site first
+ * tests the bit of its event in plugin_subscribed, so that an event without
+ * subscriber costs a test of a global variable and nothing else.
+ * Callbacks must not write registers nor memory through arm_core, this would
+ * raise the events again.
+ */
+#define PLUGIN_INSTRUCTION (1 << 0)
+#define PLUGIN_BASIC_BLOCK (1 << 1)
+#define PLUGIN_MEMORY (1 << 2)
+#define PLUGIN_REGISTER_WRITE (1 << 3)
+#define PLUGIN_EXCEPTION (1 << 4)
+#define PLUGIN_SWI (1 << 5)
+
+/* Types of memory accesses */
+#define PLUGIN_READ 0
+#define PLUGIN_WRITE 1
+
+/* Instruction executed (or skipped by its condition), after its effects */
+typedef void (*plugin_instruction_hook) (arm_core p, uint32_t address, uint32_t instruction,
+                                         void *data);
+/* Before the first instruction of a basic block, which starts at the target
+ * of any jump and after any control transfer
+ */
+typedef void (*plugin_basic_block_hook) (arm_core p, uint32_t address, void *data);
+/* Data access (not fetches), value read or written */
+typedef void (*plugin_memory_hook) (arm_core p, uint32_t address, uint8_t size, uint8_t type,
+                                    uint32_t value, void *data);
+/* Register number as in trace (16 for CPSR, 17 for SPSR) */
+typedef void (*plugin_register_hook) (arm_core p, uint8_t reg, uint8_t mode, uint32_t value,
+                                      void *data);
+/* Before the exception is handled, numbers in arm_constants.h */
+typedef void (*plugin_exception_hook) (arm_core p, uint8_t exception, void *data);
+/* Software interrupt, with the 24 bits number of the instruction */
+typedef void (*plugin_swi_hook) (arm_core p, uint32_t number, void *data);
+
+extern uint32_t plugin_subscribed;
+
+/* Return -1 when the maximum number of callbacks of the event is reached */
+int plugin_add_instruction_hook(plugin_instruction_hook hook, void *data);
+int plugin_add_basic_block_hook(plugin_basic_block_hook hook, void *data);
+int plugin_add_memory_hook(plugin_memory_hook hook, void *data);
+int plugin_add_register_hook(plugin_register_hook hook, void *data);
+int plugin_add_exception_hook(plugin_exception_hook hook, void *data);
+int plugin_add_swi_hook(plugin_swi_hook hook, void *data);
+void plugin_remove_hooks();
+
+/* Shared object plugins : the object must define
+ *     int plugin_init(char *arguments);
+ * registering its hooks and returning 0 on success, and may define
+ *     void plugin_fini();
+ * called by plugin_unload_all, at the end of the simulation.
+ * Returns -1 and prints the reason on stderr on failure.
+ */
+int plugin_load(char *filename, char *arguments);
+void plugin_unload_all();
+
+void plugin_dispatch_instruction(arm_core p);
+void plugin_dispatch_basic_block(arm_core p);
+void plugin_dispatch_memory(arm_core p, uint32_t address, uint8_t size, uint8_t type,
+                            uint32_t value);
+void plugin_dispatch_register(arm_core p, uint8_t reg, uint8_t mode, uint32_t value);
+void plugin_dispatch_exception(arm_core p, uint8_t exception);
+void plugin_dispatch_swi(arm_core p, uint32_t number);
+
+#define plugin_instruction(p) \
+    do { if (plugin_subscribed & PLUGIN_INSTRUCTION) plugin_dispatch_instruction(p); } while (0)
+#define plugin_basic_block(p) \
+    do { if (plugin_subscribed & PLUGIN_BASIC_BLOCK) plugin_dispatch_basic_block(p); } while (0)
+#define plugin_memory(p, address, size, type, value) \
+    do { if (plugin_subscribed & PLUGIN_MEMORY) \
+             plugin_dispatch_memory(p, address, size, type, value); } while (0)
+#define plugin_register(p, reg, mode, value) \
+    do { if (plugin_subscribed & PLUGIN_REGISTER_WRITE) \
+             plugin_dispatch_register(p, reg, mode, value); } while (0)
+#define plugin_exception(p, exception) \
+    do { if (plugin_subscribed & PLUGIN_EXCEPTION) plugin_dispatch_exception(p, exception); } while (0)
+#define plugin_swi(p, number) \
+    do { if (plugin_subscribed & PLUGIN_SWI) plugin_dispatch_swi(p, number); } while (0)
+
+#endif
@@ -0,0 +1,340 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "profiler.h"
+#include "elf_reader.h"
+#include "disassembler.h"
+#include "util.h"
+
+#define NO_RETURN_ADDRESS 0xFFFFFFFF
+
+struct profiler_function {
+    char *name;
+    uint64_t calls;
+    uint64_t self_instructions, self_cycles;
+    uint64_t instructions, cycles;
+    /* Number of frames of the function in the stack, for recursion */
+    int active;
+};
+
+/* Calling context tree node, one per distinct call path */
+struct profiler_node {
+    int function;
+    struct profiler_node *parent, *children, *next;
+    uint64_t calls;
+    uint64_t self_instructions, self_cycles;
+    uint64_t cycles;
+};
+
+struct profiler_frame {
+    struct profiler_node *node;
+    uint32_t return_address;
+    uint64_t instructions, cycles;
+};
+
+struct profiler_edge {
+    int caller, callee;
+    uint64_t calls, cycles;
+};
+
+static elf_reader elf = NULL;
+static struct profiler_function *functions;
+static int functions_number;
+static struct profiler_node root;
+static struct profiler_frame *frames;
+static int depth, frames_size;
+static uint64_t total_instructions, total_cycles;
+
+int profiler_start(char *elf_filename) {
+    int i;
+
+    elf = elf_reader_open(elf_filename);
+    if (elf == NULL)
+        return -1;
+    /* Last function for the code outside of any symbol */
+    functions_number = elf_reader_symbols_number(elf) + 1;
+    functions = calloc(functions_number, sizeof(struct profiler_function));
+    error_if_null(functions);
+    for (i = 0; i < functions_number - 1; i++)
+        functions[i].name = elf_reader_symbol(elf, i)->name;
+    functions[functions_number - 1].name = "[unknown]";
+    memset(&root, 0, sizeof(root));
+    root.function = -1;
+    frames_size = 64;
+    frames = malloc(frames_size * sizeof(struct profiler_frame));
+    error_if_null(frames);
+    depth = 0;
+    total_instructions = total_cycles = 0;
+    return 0;
+}
+
+static void profiler_free_node(struct profiler_node *node) {
+    struct profiler_node *child, *next;
+
+    for (child = node->children; child; child = next) {
+        next = child->next;
+        profiler_free_node(child);
+        free(child);
+    }
+}
+
+void profiler_stop() {
+    if (elf) {
+        profiler_free_node(&root);
+        free(functions);
+        free(frames);
+        elf_reader_close(elf);
+        elf = NULL;
+    }
+}
+
+static int profiler_function_of(uint32_t address) {
+    int index = elf_reader_find_symbol(elf, address);
+
+    return index == -1 ? functions_number - 1 : index;
+}
+
+static void profiler_push(int function, uint32_t return_address) {
+    struct profiler_node *parent, *node;
+
+    parent = depth ? frames[depth - 1].node : &root;
+    for (node = parent->children; node && (node->function != function); node = node->next);
+    if (node == NULL) {
+        node = calloc(1, sizeof(struct profiler_node));
+        error_if_null(node);
+        node->function = function;
+        node->parent = parent;
+        node->next = parent->children;
+        parent->children = node;
+    }
+    if (depth == frames_size) {
+        frames_size *= 2;
+        frames = realloc(frames, frames_size * sizeof(struct profiler_frame));
+        error_if_null(frames);
+    }
+    frames[depth].node = node;
+    frames[depth].return_address = return_address;
+    frames[depth].instructions = total_instructions;
+    frames[depth].cycles = total_cycles;
+    depth++;
+    node->calls++;
+    functions[function].calls++;
+    functions[function].active++;
+}
+
+static void profiler_pop() {
+    struct profiler_frame *frame = &frames[--depth];
+    struct profiler_function *function = &functions[frame->node->function];
+
+    /* Inclusive counts are only taken by the outermost frame of a function */
+    if (--function->active == 0) {
+        function->instructions += total_instructions - frame->instructions;
+        function->cycles += total_cycles - frame->cycles;
+    }
+}
+
+void profiler_instruction(arm_core p, uint32_t cycles) {
+    struct profiler_frame *top;
+    uint32_t address, ins, pc;
+    int level, function;
+
+    if (elf == NULL)
+        return;
+    address = p->current_address;
+    ins = p->current_instruction;
+    if (depth == 0)
+        profiler_push(profiler_function_of(address), NO_RETURN_ADDRESS);
+    top = &frames[depth - 1];
+    functions[top->node->function].self_instructions++;
+    functions[top->node->function].self_cycles += cycles;
+    top->node->self_instructions++;
+    top->node->self_cycles += cycles;
+    total_instructions++;
+    total_cycles += cycles;
+
+    pc = registers_read(p->reg, 15, registers_get_mode(p->reg));
+    if (pc == address + 4)
+        return;
+    if ((ins & 0x0F000000) == 0x0B000000) {
+        /* BL */
+        profiler_push(profiler_function_of(pc),
+                      registers_read(p->reg, 14, registers_get_mode(p->reg)));
+    } else if (arm_is_return(ins)) {
+        for (level = depth - 1; (level >= 0) && (frames[level].return_address != pc); level--);
+        if (level >= 0) {
+            while (depth > level)
+                profiler_pop();
+        }
+    } else if ((ins & 0x0F000000) == 0x0A000000) {
+        /* B to the entry of another function : tail call */
+        function = profiler_function_of(pc);
+        if ((function != top->node->function) && (function < functions_number - 1) &&
+            (elf_reader_symbol(elf, function)->address == pc)) {
+            uint32_t return_address = top->return_address;
+            profiler_pop();
+            profiler_push(function, return_address);
+        }
+    }
+}
+
+static uint64_t profiler_node_cycles(struct profiler_node *node) {
+    struct profiler_node *child;
+
+    node->cycles = node->self_cycles;
+    for (child = node->children; child; child = child->next)
+        node->cycles += profiler_node_cycles(child);
+    return node->cycles;
+}
+
+static void profiler_add_edges(struct profiler_node *node, struct profiler_edge **edges,
+                               int *edges_number, int *edges_size) {
+    struct profiler_node *child;
+    int i;
+
+    if ((node->function != -1) && (node->parent->function != -1)) {
+        for (i = 0; (i < *edges_number) && (((*edges)[i].caller != node->parent->function) ||
+                                           ((*edges)[i].callee != node->function)); i++);
+        if (i == *edges_number) {
+            if (*edges_number == *edges_size) {
+                *edges_size = *edges_size ? 2 * *edges_size : 64;
+                *edges = realloc(*edges, *edges_size * sizeof(struct profiler_edge));
+                error_if_null(*edges);
+            }
+            (*edges)[i].caller = node->parent->function;
+            (*edges)[i].callee = node->function;
+            (*edges)[i].calls = (*edges)[i].cycles = 0;
+            (*edges_number)++;
+        }
+        (*edges)[i].calls += node->calls;
+        (*edges)[i].cycles += node->cycles;
+    }
+    for (child = node->children; child; child = child->next)
+        profiler_add_edges(child, edges, edges_number, edges_size);
+}
+
+static uint64_t *sort_key;
+
+static int profiler_compare(const void *a, const void *b) {
+    uint64_t first = sort_key[*(const int *) a], second = sort_key[*(const int *) b];
+
+    return first < second ? 1 : first > second ? -1 : 0;
+}
+
+static double percent(uint64_t value, uint64_t total) {
+    return total ? 100.0 * value / total : 0.0;
+}
+
+void profiler_report(FILE *f) {
+    uint64_t *instructions, *cycles;
+    struct profiler_edge *edges = NULL;
+    int edges_number = 0, edges_size = 0;
+    int *order, i, j, level;
+
+    if (elf == NULL)
+        return;
+    /* Inclusive counts, including the frames still in the stack */
+    instructions = malloc(functions_number * sizeof(uint64_t));
+    cycles = malloc(functions_number * sizeof(uint64_t));
+    order = malloc(functions_number * sizeof(int));
+    error_if_null(instructions);
+    error_if_null(cycles);
+    error_if_null(order);
+    for (i = 0; i < functions_number; i++) {
+        instructions[i] = functions[i].instructions;
+        cycles[i] = functions[i].cycles;
+        order[i] = i;
+    }
+    for (level = 0; level < depth; level++) {
+        i = frames[level].node->function;
+        for (j = 0; (j < level) && (frames[j].node->function != i); j++);
+        if (j == level) {
+            instructions[i] += total_instructions - frames[level].instructions;
+            cycles[i] += total_cycles - frames[level].cycles;
+        }
+    }
+    sort_key = cycles;
+    qsort(order, functions_number, sizeof(int), profiler_compare);
+
+    fprintf(f, "Flat profile : %" PRIu64 " instructions, %" PRIu64 " cycles\n",
+            total_instructions, total_cycles);
+    fprintf(f, "%14s %6s %14s %14s %6s %14s %10s  %s\n", "self cycles", "%", "self instrs",
+            "total cycles", "%", "total instrs", "calls", "function");
+    for (i = 0; i < functions_number; i++) {
+        struct profiler_function *function = &functions[order[i]];
+        if (function->calls == 0)
+            continue;
+        fprintf(f, "%14" PRIu64 " %6.2f %14" PRIu64 " %14" PRIu64 " %6.2f %14" PRIu64
+                " %10" PRIu64 "  %s\n", function->self_cycles,
+                percent(function->self_cycles, total_cycles), function->self_instructions,
+                cycles[order[i]], percent(cycles[order[i]], total_cycles),
+                instructions[order[i]], function->calls, function->name);
+    }
+
+    profiler_node_cycles(&root);
+    profiler_add_edges(&root, &edges, &edges_number, &edges_size);
+    fprintf(f, "\nCall graph :\n%10s %14s  %s\n", "calls", "total cycles", "caller -> callee");
+    for (i = 0; i < edges_number; i++)
+        fprintf(f, "%10" PRIu64 " %14" PRIu64 "  %s -> %s\n", edges[i].calls, edges[i].cycles,
+                functions[edges[i].caller].name, functions[edges[i].callee].name);
+    free(edges);
+    free(order);
+    free(instructions);
+    free(cycles);
+}
+
+static void profiler_folded_node(FILE *f, struct profiler_node *node, char **path,
+                                 size_t *path_size, size_t length) {
+    struct profiler_node *child;
+    size_t name_length;
+
+    if (node->function != -1) {
+        name_length = strlen(functions[node->function].name);
+        if (length + name_length + 2 > *path_size) {
+            *path_size = 2 * (length + name_length + 2);
+            *path = realloc(*path, *path_size);
+            error_if_null(*path);
+        }
+        if (length)
+            (*path)[length++] = ';';
+        strcpy(*path + length, functions[node->function].name);
+        length += name_length;
+        if (node->self_cycles)
+            fprintf(f, "%s %" PRIu64 "\n", *path, node->self_cycles);
+    }
+    for (child = node->children; child; child = child->next)
+        profiler_folded_node(f, child, path, path_size, length);
+}
+
+void profiler_folded(FILE *f) {
+    size_t path_size = 256;
+    char *path;
+
+    if (elf == NULL)
+        return;
+    path = malloc(path_size);
+    error_if_null(path);
+    profiler_folded_node(f, &root, &path, &path_size, 0);
+    free(path);
+}
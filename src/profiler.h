@@ -0,0 +1,46 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __PROFILER_H__
+#define __PROFILER_H__
+#include <stdio.h>
+#include <stdint.h>
+#include "arm_core.h"
+
+/* Exact per function accounting of instructions and cycles. Functions come
+ * from the symbol table of the ELF file of the simulated program, calls are
+ * followed using a shadow call stack : BL pushes a frame and the usual
+ * return sequences (mov pc, lr / bx lr / ldm ..., pc / ldr pc, ...) pop the
+ * frames up to the one whose return address is reached.
+ */
+int profiler_start(char *elf_filename);
+void profiler_stop();
+
+/* To be called after each instruction, with the cycles it took */
+void profiler_instruction(arm_core p, uint32_t cycles);
+
+/* Flat profile and call graph */
+void profiler_report(FILE * f);
+/* Folded stacks with their exclusive cycles, as used by flamegraph tools */
+void profiler_folded(FILE * f);
+
+#endif
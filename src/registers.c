@@ -27,7 +27,7 @@ Contact: Guillaume.Huard@imag.fr
 
 registers registers_create()
 {
-  registers registers = malloc(sizeof(struct registers_data));
+  registers registers = calloc(1, sizeof(struct registers_data));
   error_if_null(registers);
   return registers;
 }
@@ -0,0 +1,190 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "replay.h"
+#include "arm_exception.h"
+#include "util.h"
+
+#define MAX_EVENT_SIZE 16
+
+/* Flushed after each event, so that the log of a run that crashed or was
+ * killed is complete up to its end
+ */
+static FILE *record_file = NULL;
+static FILE *replay_file = NULL;
+/* Next event to replay, read in advance */
+static int has_event = 0;
+static uint64_t event_count;
+static char event_type[MAX_EVENT_SIZE];
+static char *event_line = NULL;
+static size_t event_line_size = 0;
+static int event_arguments;
+
+int replay_start_recording(char *filename) {
+    record_file = fopen(filename, "w");
+    return record_file ? 0 : -1;
+}
+
+static void replay_read_event() {
+    has_event = 0;
+    if (getline(&event_line, &event_line_size, replay_file) == -1)
+        return;
+    if (sscanf(event_line, "%" SCNu64 " %15s %n", &event_count, event_type,
+               &event_arguments) < 2) {
+        fprintf(stderr, "Invalid replay event : %s", event_line);
+        exit(1);
+    }
+    has_event = 1;
+}
+
+int replay_start_replaying(char *filename) {
+    replay_file = fopen(filename, "r");
+    if (replay_file == NULL)
+        return -1;
+    replay_read_event();
+    return 0;
+}
+
+int replay_is_replaying() {
+    return replay_file != NULL;
+}
+
+void replay_finish(arm_core p) {
+    if (record_file) {
+        fprintf(record_file, "%" PRIu64 " end\n", arm_get_instruction_count(p));
+        fclose(record_file);
+        record_file = NULL;
+    }
+    if (replay_file) {
+        fclose(replay_file);
+        replay_file = NULL;
+        free(event_line);
+        event_line = NULL;
+    }
+}
+
+void replay_record_irq(arm_core p, uint8_t irq) {
+    if (record_file) {
+        fprintf(record_file, "%" PRIu64 " irq %d\n", arm_get_instruction_count(p), irq);
+        fflush(record_file);
+    }
+}
+
+void replay_record_register(arm_core p, uint8_t reg, uint8_t mode, uint32_t value) {
+    if (record_file) {
+        fprintf(record_file, "%" PRIu64 " reg %d %d %08x\n", arm_get_instruction_count(p),
+                mode, reg, value);
+        fflush(record_file);
+    }
+}
+
+void replay_record_cpsr(arm_core p, uint32_t value) {
+    if (record_file) {
+        fprintf(record_file, "%" PRIu64 " cpsr %08x\n", arm_get_instruction_count(p), value);
+        fflush(record_file);
+    }
+}
+
+void replay_record_memory(arm_core p, uint32_t address, uint8_t *data, uint32_t size) {
+    uint32_t i;
+
+    if (record_file) {
+        fprintf(record_file, "%" PRIu64 " mem %08x ", arm_get_instruction_count(p), address);
+        for (i = 0; i < size; i++)
+            fprintf(record_file, "%02x", data[i]);
+        fprintf(record_file, "\n");
+        fflush(record_file);
+    }
+}
+
+int replay_getchar(arm_core p) {
+    int value;
+
+    if (replay_file) {
+        if (!has_event || strcmp(event_type, "input") != 0) {
+            fprintf(stderr, "Replay diverged, no console input logged at instruction %"
+                    PRIu64 "\n", arm_get_instruction_count(p));
+            exit(1);
+        }
+        value = atoi(event_line + event_arguments);
+        replay_read_event();
+        return value;
+    }
+    value = getchar();
+    if (record_file) {
+        fprintf(record_file, "%" PRIu64 " input %d\n", arm_get_instruction_count(p), value);
+        fflush(record_file);
+    }
+    return value;
+}
+
+static void replay_apply_memory(arm_core p, char *data) {
+    unsigned int address, value;
+
+    data = (sscanf(data, "%x", &address) == 1) ? index(data, ' ') : NULL;
+    if (data == NULL) {
+        fprintf(stderr, "Invalid replay event : %s", event_line);
+        exit(1);
+    }
+    while (*data == ' ')
+        data++;
+    while (sscanf(data, "%2x", &value) == 1) {
+        /* A log of another memory size, or a corrupt one */
+        if (memory_write_byte(p->mem, address++, value) == -1) {
+            fprintf(stderr, "Invalid replay event, out of memory : %s", event_line);
+            exit(1);
+        }
+        data += 2;
+    }
+}
+
+int replay_inject(arm_core p) {
+    unsigned int mode, reg, value;
+    char *arguments;
+
+    while (has_event && (event_count <= arm_get_instruction_count(p))) {
+        arguments = event_line + event_arguments;
+        if (strcmp(event_type, "end") == 0) {
+            return 1;
+        } else if (strcmp(event_type, "irq") == 0) {
+            arm_exception(p, atoi(arguments));
+        } else if (strcmp(event_type, "reg") == 0) {
+            sscanf(arguments, "%u %u %x", &mode, &reg, &value);
+            registers_write(p->reg, reg, mode, value);
+        } else if (strcmp(event_type, "cpsr") == 0) {
+            sscanf(arguments, "%x", &value);
+            registers_write_cpsr(p->reg, value);
+        } else if (strcmp(event_type, "mem") == 0) {
+            replay_apply_memory(p, arguments);
+        } else {
+            /* Console input is consumed by replay_getchar when the program
+             * asks for it
+             */
+            break;
+        }
+        replay_read_event();
+    }
+    return !has_event;
+}
@@ -0,0 +1,62 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __REPLAY_H__
+#define __REPLAY_H__
+#include <stdint.h>
+#include "arm_core.h"
+
+/* Deterministic record/replay of a simulation run.
+ * When recording, every input that does not come from the simulated program
+ * itself (irqs, gdb register and memory writes, console input read by the
+ * program) is logged together with the number of instructions executed when
+ * it took effect. When replaying, these inputs are injected again at the same
+ * points, so that the run is reproduced without gdb nor irq sender.
+ * The log is a text file, one event per line :
+ *   <count> irq <exception>
+ *   <count> reg <mode> <register> <value>
+ *   <count> cpsr <value>
+ *   <count> mem <address> <bytes in hexadecimal>
+ *   <count> input <character or -1 at end of file>
+ *   <count> end
+ */
+int replay_start_recording(char *filename);
+int replay_start_replaying(char *filename);
+int replay_is_replaying();
+void replay_finish(arm_core p);
+
+void replay_record_irq(arm_core p, uint8_t irq);
+void replay_record_register(arm_core p, uint8_t reg, uint8_t mode, uint32_t value);
+void replay_record_cpsr(arm_core p, uint32_t value);
+void replay_record_memory(arm_core p, uint32_t address, uint8_t * data, uint32_t size);
+
+/* Console input of the simulated program : read from stdin (and logged) or
+ * taken from the log when replaying
+ */
+int replay_getchar(arm_core p);
+
+/* Applies the logged inputs that took effect before the next instruction.
+ * Returns 1 once the end of the recorded run has been reached, 0 otherwise.
+ */
+int replay_inject(arm_core p);
+
+#endif
@@ -0,0 +1,215 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "sampler.h"
+#include "disassembler.h"
+#include "util.h"
+
+/* Longest basic block considered, in instructions */
+#define MAX_BLOCK_LENGTH 256
+
+struct sample {
+    uint32_t address;
+    uint32_t count;
+};
+
+static uint32_t sampling_interval = 0;
+static uint32_t countdown;
+static uint64_t samples_number;
+/* Open addressing hash table of the sampled addresses, the empty slots have
+ * a zero count
+ */
+static struct sample *samples = NULL;
+static uint32_t samples_size, samples_used;
+
+void sampler_start(uint32_t interval) {
+    sampling_interval = interval;
+    countdown = interval;
+    samples_number = 0;
+    samples_size = 1024;
+    samples_used = 0;
+    samples = calloc(samples_size, sizeof(struct sample));
+    error_if_null(samples);
+}
+
+void sampler_stop() {
+    sampling_interval = 0;
+    free(samples);
+    samples = NULL;
+}
+
+static struct sample *sampler_slot(struct sample *table, uint32_t size, uint32_t address) {
+    uint32_t i = ((address >> 2) * 2654435761u) & (size - 1);
+
+    while (table[i].count && (table[i].address != address))
+        i = (i + 1) & (size - 1);
+    return &table[i];
+}
+
+static void sampler_record(uint32_t address) {
+    struct sample *slot, *old;
+    uint32_t i, old_size;
+
+    slot = sampler_slot(samples, samples_size, address);
+    if (slot->count == 0) {
+        if (2 * (samples_used + 1) > samples_size) {
+            old = samples;
+            old_size = samples_size;
+            samples_size *= 2;
+            samples = calloc(samples_size, sizeof(struct sample));
+            error_if_null(samples);
+            for (i = 0; i < old_size; i++)
+                if (old[i].count)
+                    *sampler_slot(samples, samples_size, old[i].address) = old[i];
+            free(old);
+            slot = sampler_slot(samples, samples_size, address);
+        }
+        slot->address = address;
+        samples_used++;
+    }
+    slot->count++;
+    samples_number++;
+}
+
+void sampler_instruction(arm_core p) {
+    if (sampling_interval && (--countdown == 0)) {
+        countdown = sampling_interval;
+        sampler_record(p->current_address);
+    }
+}
+
+static int sampler_by_count(const void *a, const void *b) {
+    const struct sample *first = a, *second = b;
+
+    if (first->count != second->count)
+        return first->count < second->count ? 1 : -1;
+    return first->address < second->address ? -1 : first->address > second->address;
+}
+
+static int sampler_by_address(const void *a, const void *b) {
+    const struct sample *first = a, *second = b;
+
+    return first->address < second->address ? -1 : first->address > second->address;
+}
+
+static uint32_t sampler_count_at(uint32_t address) {
+    return sampler_slot(samples, samples_size, address)->count;
+}
+
+/* Start of the basic block containing address : the instruction following a
+ * control transfer or the entry of a function
+ */
+static uint32_t sampler_block_start(arm_core p, elf_reader elf, uint32_t address) {
+    uint32_t instruction;
+    int index, i;
+
+    for (i = 0; (i < MAX_BLOCK_LENGTH) && (address >= 4); i++) {
+        if (elf) {
+            index = elf_reader_find_symbol(elf, address);
+            if ((index != -1) && (elf_reader_symbol(elf, index)->address == address))
+                break;
+        }
+        if (arm_peek_word(p, address - 4, &instruction) ||
+            arm_is_control_transfer(instruction))
+            break;
+        address -= 4;
+    }
+    return address;
+}
+
+static void sampler_print_instruction(FILE *f, arm_core p, uint32_t address) {
+    uint32_t instruction;
+    char text[64];
+
+    if (arm_peek_word(p, address, &instruction))
+        fprintf(f, "%08X  <out of memory>\n", address);
+    else
+        fprintf(f, "%08X  %08X  %s\n", address, instruction,
+                arm_disassemble(address, instruction, text, sizeof(text)));
+}
+
+void sampler_report(FILE *f, arm_core p, elf_reader elf, int count) {
+    struct sample *sorted, *blocks;
+    uint32_t i, j, blocks_number, address, instruction;
+    char name[128];
+
+    if (samples == NULL)
+        return;
+    sorted = malloc((samples_used + 1) * sizeof(struct sample));
+    blocks = malloc((samples_used + 1) * sizeof(struct sample));
+    error_if_null(sorted);
+    error_if_null(blocks);
+    for (i = 0, j = 0; i < samples_size; i++)
+        if (samples[i].count)
+            sorted[j++] = samples[i];
+    qsort(sorted, samples_used, sizeof(struct sample), sampler_by_count);
+
+    fprintf(f, "Samples : %" PRIu64 " (one every %u instructions), %u distinct addresses\n",
+            samples_number, sampling_interval, samples_used);
+    fprintf(f, "\nHottest addresses :\n%10s %6s  %-8s  %-24s  %s\n", "samples", "%", "address",
+            "symbol", "instruction");
+    for (i = 0; (i < samples_used) && (i < count); i++) {
+        fprintf(f, "%10u %6.2f  ", sorted[i].count, 100.0 * sorted[i].count / samples_number);
+        if (elf)
+            elf_reader_describe_address(elf, sorted[i].address, name, sizeof(name));
+        else
+            name[0] = '\0';
+        fprintf(f, "%-24s  ", name);
+        sampler_print_instruction(f, p, sorted[i].address);
+    }
+
+    /* Samples gathered per basic block */
+    for (i = 0; i < samples_used; i++) {
+        blocks[i].address = sampler_block_start(p, elf, sorted[i].address);
+        blocks[i].count = sorted[i].count;
+    }
+    qsort(blocks, samples_used, sizeof(struct sample), sampler_by_address);
+    for (i = 0, blocks_number = 0; i < samples_used; i++) {
+        if (blocks_number && (blocks[blocks_number - 1].address == blocks[i].address))
+            blocks[blocks_number - 1].count += blocks[i].count;
+        else
+            blocks[blocks_number++] = blocks[i];
+    }
+    qsort(blocks, blocks_number, sizeof(struct sample), sampler_by_count);
+
+    fprintf(f, "\nHottest basic blocks :\n");
+    for (i = 0; (i < blocks_number) && (i < count); i++) {
+        if (elf)
+            elf_reader_describe_address(elf, blocks[i].address, name, sizeof(name));
+        else
+            snprintf(name, sizeof(name), "%08X", blocks[i].address);
+        fprintf(f, "\n%u samples (%.2f%%) in block %s :\n", blocks[i].count,
+                100.0 * blocks[i].count / samples_number, name);
+        address = blocks[i].address;
+        for (j = 0; j < MAX_BLOCK_LENGTH; j++, address += 4) {
+            fprintf(f, "%10u  ", sampler_count_at(address));
+            sampler_print_instruction(f, p, address);
+            if (arm_peek_word(p, address, &instruction) || arm_is_control_transfer(instruction))
+                break;
+        }
+    }
+    free(sorted);
+    free(blocks);
+}
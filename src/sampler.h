@@ -0,0 +1,45 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __SAMPLER_H__
+#define __SAMPLER_H__
+#include <stdio.h>
+#include <stdint.h>
+#include "arm_core.h"
+#include "elf_reader.h"
+
+/* Statistical profiling : the address of one instruction out of every
+ * interval executed ones is counted in a histogram. Much cheaper than the
+ * exact accounting of the profiler on long runs.
+ */
+void sampler_start(uint32_t interval);
+void sampler_stop();
+
+/* To be called after each instruction */
+void sampler_instruction(arm_core p);
+
+/* Hottest addresses, then hottest basic blocks with their disassembly, at
+ * most count of each. Symbols are taken from elf when it is not NULL.
+ */
+void sampler_report(FILE * f, arm_core p, elf_reader elf, int count);
+
+#endif
@@ -0,0 +1,99 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include "self_profile.h"
+
+#ifdef SELF_PROFILE
+#include <time.h>
+#include <inttypes.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define UNIT "cycles"
+#else
+#define UNIT "ns"
+#endif
+
+static char *handler_names[SELF_PROFILE_HANDLERS] = { "outside", "dispatch",
+    "data_processing", "load_store", "load_store_multiple", "branch", "miscellaneous",
+    "coprocessor", "exception", "trace", "gdb"
+};
+
+static int current = SELF_PROFILE_OUTSIDE;
+static uint64_t last_switch = 0;
+static uint64_t times[SELF_PROFILE_HANDLERS];
+static uint64_t entries[SELF_PROFILE_HANDLERS];
+
+static inline uint64_t self_profile_now() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * 1000000000 + now.tv_nsec;
+#endif
+}
+
+static void self_profile_switch(int handler) {
+    uint64_t now = self_profile_now();
+
+    /* The first switch only starts the clock */
+    if (last_switch)
+        times[current] += now - last_switch;
+    last_switch = now;
+    current = handler;
+}
+
+int self_profile_enter(int handler) {
+    int previous = current;
+
+    entries[handler]++;
+    self_profile_switch(handler);
+    return previous;
+}
+
+void self_profile_leave(int previous) {
+    self_profile_switch(previous);
+}
+
+void self_profile_report(FILE *f, uint64_t instructions) {
+    uint64_t total = 0, simulation;
+    int i;
+
+    self_profile_switch(current);
+    for (i = 0; i < SELF_PROFILE_HANDLERS; i++)
+        total += times[i];
+    simulation = total - times[SELF_PROFILE_OUTSIDE];
+    fprintf(f, "Self profile : %" PRIu64 " " UNIT " in the simulation, %.1f per instruction\n",
+            simulation, instructions ? (double) simulation / instructions : 0.0);
+    fprintf(f, "  %-20s %16s %7s %12s %10s %12s\n", "handler", UNIT, "share", "entries",
+            "per entry", "per instr");
+    for (i = 0; i < SELF_PROFILE_HANDLERS; i++) {
+        if ((times[i] == 0) && (entries[i] == 0))
+            continue;
+        fprintf(f, "  %-20s %16" PRIu64 " %6.2f%% %12" PRIu64 " %10.1f %12.2f\n",
+                handler_names[i], times[i], total ? 100.0 * times[i] / total : 0.0,
+                entries[i], entries[i] ? (double) times[i] / entries[i] : 0.0,
+                instructions ? (double) times[i] / instructions : 0.0);
+    }
+}
+#endif
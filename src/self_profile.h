@@ -0,0 +1,71 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __SELF_PROFILE_H__
+#define __SELF_PROFILE_H__
+#include <stdio.h>
+#include <stdint.h>
+
+/* Self profiling of the simulator, only compiled with -D SELF_PROFILE (see
+ * Makefile.am) so that the default build does not pay for it : the host
+ * time, in cycles of the time stamp counter on x86 and in ns elsewhere, is
+ * charged to the handler being run. Entering a handler charges the time
+ * elapsed so far to the previous one, so that nested handlers (trace, gdb,
+ * exceptions) are not counted twice. The handlers of the guest instructions
+ * give the host time per instruction class, dispatch is the rest of the
+ * step (fetch, condition, decoding, models and hooks) and outside everything
+ * not in a step nor gdb.
+ */
+#define SELF_PROFILE_OUTSIDE 0
+#define SELF_PROFILE_DISPATCH 1
+#define SELF_PROFILE_DATA_PROCESSING 2
+#define SELF_PROFILE_LOAD_STORE 3
+#define SELF_PROFILE_LOAD_STORE_MULTIPLE 4
+#define SELF_PROFILE_BRANCH 5
+#define SELF_PROFILE_MISCELLANEOUS 6
+#define SELF_PROFILE_COPROCESSOR 7
+#define SELF_PROFILE_EXCEPTION 8
+#define SELF_PROFILE_TRACE 9
+#define SELF_PROFILE_GDB 10
+#define SELF_PROFILE_HANDLERS 11
+
+#ifdef SELF_PROFILE
+/* Returns the previous handler, to leave to it */
+int self_profile_enter(int handler);
+void self_profile_leave(int previous);
+/* Time, entries and time per entry of each handler, and their share of the
+ * time per guest instruction over the given number of instructions
+ */
+void self_profile_report(FILE * f, uint64_t instructions);
+#else
+static inline int self_profile_enter(int handler) {
+    return 0;
+}
+
+static inline void self_profile_leave(int previous) {
+}
+
+static inline void self_profile_report(FILE * f, uint64_t instructions) {
+}
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "access_patterns.h"
+
+int main() {
+    uint64_t buckets[ACCESS_PATTERNS_BUCKETS], cold;
+    int32_t stride;
+    int i, j;
+
+    printf("Test : stride classes ... ");
+    assert(access_patterns_enable(0x10000, 0x1000, 32) == 0);
+    for (i = 0; i < 100; i++) {
+        access_patterns_access(0x100, 0x1000 + 4 * i, 4, 0);    // ldr r1, [r0], #4
+        access_patterns_access(0x104, 0x8000 - 2 * i, 2, 1);    // strh r1, [r2], #-2
+        access_patterns_access(0x108, 0x3000 + 64 * i, 4, 0);   // ldr r3, [r4], #64
+        access_patterns_access(0x10C, 0x7000, 4, 1);    // str r5, [r6]
+        access_patterns_access(0x110, 0x4000 + ((i * 2654435761u) & 0xFFC), 1, 0);
+    }
+    assert(access_patterns_stride(0x100, &stride) == ACCESS_PATTERNS_SEQUENTIAL);
+    assert(stride == 4);
+    assert(access_patterns_stride(0x104, &stride) == ACCESS_PATTERNS_SEQUENTIAL);
+    assert(stride == -2);
+    assert(access_patterns_stride(0x108, &stride) == ACCESS_PATTERNS_STRIDED);
+    assert(stride == 64);
+    assert(access_patterns_stride(0x10C, &stride) == ACCESS_PATTERNS_SAME);
+    assert(stride == 0);
+    assert(access_patterns_stride(0x110, &stride) == ACCESS_PATTERNS_IRREGULAR);
+    assert(access_patterns_stride(0x200, &stride) == -1);
+    printf("OK\n");
+
+    printf("Test : mostly strided with a few outliers ... ");
+    for (i = 0; i < 100; i++)
+        access_patterns_access(0x114, 0x5000 + 8 * i + (i % 10 == 0 ? 0x100 : 0), 4, 0);
+    assert(access_patterns_stride(0x114, &stride) == ACCESS_PATTERNS_STRIDED);
+    assert(stride == 8);
+    access_patterns_disable();
+    printf("OK\n");
+
+    printf("Test : reuse distances ... ");
+    assert(access_patterns_enable(0x10000, 0x1000, 32) == 0);
+    /* Four passes over 8 lines : the lines accessed in between are the 7
+     * others, and the words of a line after the first one are at distance 0
+     */
+    for (j = 0; j < 4; j++)
+        for (i = 0; i < 64; i++)
+            access_patterns_access(0x100, 0x2000 + 4 * i, 4, 0);
+    assert(access_patterns_reuse(0x2000, buckets, &cold) == 0);
+    assert(cold == 8);
+    assert(buckets[0] == 4 * 56);
+    assert(buckets[3] == 3 * 8);        // 4 to 7
+    for (i = 0; i < ACCESS_PATTERNS_BUCKETS; i++)
+        if ((i != 0) && (i != 3))
+            assert(buckets[i] == 0);
+    assert(access_patterns_reuse(0x3000, buckets, &cold) == 0);
+    assert(cold == 0);
+    assert(access_patterns_reuse(0x10000, buckets, &cold) == -1);
+    printf("OK\n");
+
+    printf("Test : reuse distances across renumbering ... ");
+    /* Far more accesses than the times of the tree, alternating two lines */
+    for (i = 0; i < 100000; i++)
+        access_patterns_access(0x104, 0x9000 + 32 * (i % 2), 4, 0);
+    assert(access_patterns_reuse(0x9000, buckets, &cold) == 0);
+    assert(cold == 2);
+    assert(buckets[1] == 100000 - 2);
+    /* The 8 lines of the first test, after these 2 lines */
+    access_patterns_access(0x100, 0x2000, 4, 0);
+    assert(access_patterns_reuse(0x2000, buckets, &cold) == 0);
+    assert(buckets[4] == 1);    // 9 lines, 8 to 15
+    access_patterns_disable();
+    printf("OK\n");
+
+    printf("Test : invalid sizes ... ");
+    assert(access_patterns_enable(0x10000, 3000, 32) == -1);
+    assert(access_patterns_enable(0x10000, 0x1000, 0) == -1);
+    printf("OK\n");
+    return 0;
+}
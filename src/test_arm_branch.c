@@ -3,6 +3,7 @@
 #include "arm_data_processing.h"
 #include "arm_branch_other.h"
 #include "arm_core.h"
+#include "arm_instruction.h"
 #include "registers.h"
 #include "memory.h"
 #include "arm_constants.h"
@@ -147,7 +148,7 @@ void test_BL_inconditionnel(arm_core p) {
         1,      // bit L
         0xea000003,      // signed_immed
         0x1c,  // expected_PC
-        0x0c      // expected_LR
+        PC_INIT_VAL      // expected_LR
     );
     test_template_branch(
         "BL Inconditionnel (Adresse Negative) ",
@@ -156,7 +157,7 @@ void test_BL_inconditionnel(arm_core p) {
         1,      // bit L
         0xfffffc,      // signed_immed
         0x0,  // expected_PC
-        PC_INIT_VAL + 4      // expected_LR
+        PC_INIT_VAL      // expected_LR
     );
     
 }
@@ -170,7 +171,7 @@ void test_BL_conditionnel_positif(arm_core p) {
         1,      // bit L
         0x000003,      // signed_immed
         0x1c,  // expected_PC
-        0x0c      // expected_LR
+        PC_INIT_VAL      // expected_LR
     );
 
     // Cas avec une adresse positive et branchement de lien si non égal (Z clear)
@@ -181,7 +182,7 @@ void test_BL_conditionnel_positif(arm_core p) {
         1,      // bit L
         0x000003,      // signed_immed
         0x1c,  // expected_PC
-        0x0c      // expected_LR
+        PC_INIT_VAL      // expected_LR
     );
 
     // Meme resultats avec d'autre condition 
@@ -196,7 +197,7 @@ void test_BL_conditionnel_negatif(arm_core p) {
         1,      // bit L
         0xfffffc,      // signed_immed
         0x0,  // expected_PC
-        PC_INIT_VAL + 4      // expected_LR
+        PC_INIT_VAL      // expected_LR
     );
 
     // Cas avec une adresse négative et branchement de lien si non égal (Z clear)
@@ -207,7 +208,7 @@ void test_BL_conditionnel_negatif(arm_core p) {
         1,      // bit L
         0xfffffc,      // signed_immed
         0x0,  // expected_PC
-        PC_INIT_VAL + 4      // expected_LR
+        PC_INIT_VAL      // expected_LR
     );
 
     // Cas avec une adresse négative et branchement de lien si supérieur ou égal (C set ou Z set)
@@ -218,15 +219,36 @@ void test_BL_conditionnel_negatif(arm_core p) {
         1,      // bit L
         0xfffffc,      // signed_immed
         0x0,  // expected_PC
-        PC_INIT_VAL + 4      // expected_LR
+        PC_INIT_VAL      // expected_LR
     );
    
 }
 
+// LR contient l'adresse de l'instruction qui suit BL : mov pc, lr y revient
+void test_BL_retour(arm_core p) {
+    uint32_t program[] = {
+        0xEB000001,     // bl sous_programme
+        0xE3A00001,     // mov r0, #1
+        0xEF123456,     // swi 0x123456
+        0xE1A0F00E      // sous_programme : mov pc, lr
+    };
+
+    printf("Test : BL puis retour par mov pc, lr ... ");
+    for (int i = 0; i < 4; i++)
+        arm_write_word(p, 4 * i, program[i]);
+    arm_write_register(p, 0, 0);
+    arm_write_register(p, 15, 0);
+    while (arm_step(p) != END_SIMULATION);
+    assert(arm_read_register(p, 14) == 4);
+    assert(arm_read_register(p, 0) == 1);
+    printf("OK\n");
+}
+
 void test_BL (arm_core p) {
     test_BL_inconditionnel(p);
     test_BL_conditionnel_positif(p);
     test_BL_conditionnel_negatif(p);
+    test_BL_retour(p);
 }
 
 int main()
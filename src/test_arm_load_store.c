@@ -33,100 +33,110 @@ void test_template_load_store(
   assert(registers_read(p->reg, Rd, USR) == expected_Rd);
 }
 
-void test_template_load_store_multiple(
-    char *name,
-    arm_core p,
-    uint8_t cond,           // Bits 31-28
-    uint8_t code,           // Bits 27-20
-    uint8_t Rn,             // Bits 19-16
-    uint16_t register_list, // Bits 15-0
-    uint32_t Rn_value,
-    int incr,
-    uint32_t expected_value)
+void test_STM(arm_core p)
 {
-  printf("Test : %s ... ", name);
-
-  // Set Rn
-  arm_write_register(p, Rn, Rn_value);
+  uint32_t word;
 
-  // Set instruction
-  uint32_t ins = (cond << 28) | (code << 20) | (Rn << 16) | register_list;
+  printf("Test : STMIA, STMIA with writeback ... ");
+  arm_write_register(p, 0, 0x100);
+  arm_write_register(p, 1, 2);
+  arm_write_register(p, 2, 3);
+  arm_write_register(p, 3, 4);
+  assert(arm_load_store_multiple(p, 0xE8800002) == 0); // stmia r0, {r1}
+  arm_read_word(p, 0x100, &word);
+  assert(word == 2);
+  assert(arm_read_register(p, 0) == 0x100);
+  assert(arm_load_store_multiple(p, 0xE8A0000C) == 0); // stmia r0!, {r2, r3}
+  arm_read_word(p, 0x100, &word);
+  assert(word == 3);
+  arm_read_word(p, 0x104, &word);
+  assert(word == 4);
+  assert(arm_read_register(p, 0) == 0x108);
+  printf("OK\n");
 
-  // Execute
-  arm_load_store_multiple(p, ins);
+  printf("Test : STMIB, STMDA, STMDB with writeback (push) ... ");
+  arm_write_register(p, 0, 0x200);
+  assert(arm_load_store_multiple(p, 0xE9800006) == 0); // stmib r0, {r1, r2}
+  arm_read_word(p, 0x204, &word);
+  assert(word == 2);
+  arm_read_word(p, 0x208, &word);
+  assert(word == 3);
+  assert(arm_load_store_multiple(p, 0xE8000006) == 0); // stmda r0, {r1, r2}
+  arm_read_word(p, 0x1FC, &word);
+  assert(word == 2);
+  arm_read_word(p, 0x200, &word);
+  assert(word == 3);
+  arm_write_register(p, 13, 0x300);
+  arm_write_register(p, 4, 5);
+  arm_write_register(p, 14, 0x40);
+  assert(arm_load_store_multiple(p, 0xE92D4010) == 0); // stmdb sp!, {r4, lr}
+  arm_read_word(p, 0x2F8, &word);
+  assert(word == 5);
+  arm_read_word(p, 0x2FC, &word);
+  assert(word == 0x40);
+  assert(arm_read_register(p, 13) == 0x2F8);
+  printf("OK\n");
 
-  // Check result
-  uint32_t addr = registers_read(p->reg, Rn, registers_get_mode(p->reg));
-  for (int i = 0; i < 16; i++)
-  {
-    if ((register_list & (1 << i)) != 0)
-    {
-      uint32_t word;
-      arm_read_word(p, addr, &word);
-      assert(word == expected_value);
-      addr += incr;
-    }
-  }
+  printf("Test : STM of the base register, empty list ... ");
+  arm_write_register(p, 0, 0x180);
+  assert(arm_load_store_multiple(p, 0xE8A00003) == 0); // stmia r0!, {r0, r1}
+  arm_read_word(p, 0x180, &word);
+  assert(word == 0x180);
+  assert(arm_read_register(p, 0) == 0x188);
+  assert(arm_load_store_multiple(p, 0xE8A00000) == UNDEFINED_INSTRUCTION);
   printf("OK\n");
 }
 
-void test_STM(arm_core p)
+void test_LDM(arm_core p)
 {
+  printf("Test : LDMIA with writeback, LDMIB, LDMDA, LDMDB ... ");
+  arm_write_word(p, 0x400, 0x11);
+  arm_write_word(p, 0x404, 0x22);
+  arm_write_word(p, 0x408, 0x33);
+  arm_write_register(p, 0, 0x400);
+  assert(arm_load_store_multiple(p, 0xE8B00006) == 0); // ldmia r0!, {r1, r2}
+  assert((arm_read_register(p, 1) == 0x11) && (arm_read_register(p, 2) == 0x22));
+  assert(arm_read_register(p, 0) == 0x408);
+  arm_write_register(p, 0, 0x400);
+  assert(arm_load_store_multiple(p, 0xE9900006) == 0); // ldmib r0, {r1, r2}
+  assert((arm_read_register(p, 1) == 0x22) && (arm_read_register(p, 2) == 0x33));
+  arm_write_register(p, 0, 0x408);
+  assert(arm_load_store_multiple(p, 0xE8100006) == 0); // ldmda r0, {r1, r2}
+  assert((arm_read_register(p, 1) == 0x22) && (arm_read_register(p, 2) == 0x33));
+  assert(arm_load_store_multiple(p, 0xE9100006) == 0); // ldmdb r0, {r1, r2}
+  assert((arm_read_register(p, 1) == 0x11) && (arm_read_register(p, 2) == 0x22));
+  assert(arm_read_register(p, 0) == 0x408);
+  printf("OK\n");
 
-  // TEST 1
-  uint8_t Rn = 0;                              // r0;
-  uint16_t register_list = 0b0000000000000010; // r1
-  arm_write_word(p, 1, 2);                     // r1 = 2
-  uint32_t expected_value = 2;                 // r0 doit être égal à 2 (comme r1)
-
-  test_template_load_store_multiple("STM 1 element, r0 <- r1",
-                                    p,
-                                    AL,
-                                    0b10001000,
-                                    Rn,
-                                    register_list,
-                                    0,
-                                    4,
-                                    expected_value);
-
-  // TEST 2 (ce test ne passe pas)
-  // Rn = 0;                             // r0;
-  // register_list = 0b0000000000001100; // r2 r3
-  // arm_write_word(p, 2, 3);            // r2 = 3
-  // arm_write_word(p, 3, 3);            // r3 = 3
-  // expected_value = 3;                 // r0 et r1 doivent être égal à 3 (comme r2 et r3)
-
-  // test_template_load_store_multiple("STM 2 elements, r0 <- r2, r1 <- r3",
-  //                                   p,
-  //                                   AL,
-  //                                   0b10001000,
-  //                                   Rn,
-  //                                   register_list,
-  //                                   0,
-  //                                   4,
-  //                                   expected_value);
-}
-
-/*
-void test_LDM(arm_core p){
-
-    uint8_t Rn = 0; // r0;
-    uint16_t register_list = 0b0000000000000001;//r0
-
-    registers_write(p->reg, 0, USR, 2);//r0 = 2
-
-    uint32_t expected_value = 2;
+  printf("Test : LDM of the base register, LDMIA sp! with pc (pop) ... ");
+  arm_write_register(p, 0, 0x400);
+  assert(arm_load_store_multiple(p, 0xE8B00003) == 0); // ldmia r0!, {r0, r1}
+  assert((arm_read_register(p, 0) == 0x11) && (arm_read_register(p, 1) == 0x22));
+  arm_write_word(p, 0x500, 0x44);
+  arm_write_word(p, 0x504, 0x81);
+  arm_write_register(p, 13, 0x500);
+  assert(arm_load_store_multiple(p, 0xE8BD8010) == 0); // ldmia sp!, {r4, pc}
+  assert(arm_read_register(p, 4) == 0x44);
+  assert(arm_read_register(p, 13) == 0x508);
+  // PC = data AND 0xFFFFFFFE, T = data[0]
+  assert(registers_read(p->reg, 15, USR) == 0x80);
+  assert(registers_read_T(p->reg) == 1);
+  registers_write_T(p->reg, 0);
+  printf("OK\n");
 
-    test_template_load_store_multiple("LDM incremente AFTER 1 element, r0 dans r0\n",
-                                      p,
-                                      AL,
-                                      0b10001011,
-                                      Rn,
-                                      register_list,
-                                      2,
-                                      expected_value);
+  // La memoire fait 2048 octets : le second mot est hors memoire
+  printf("Test : LDM and STM data abort leave the registers unchanged ... ");
+  arm_write_word(p, 0x7FC, 0x55);
+  arm_write_register(p, 0, 0x7FC);
+  arm_write_register(p, 1, 1);
+  arm_write_register(p, 2, 2);
+  assert(arm_load_store_multiple(p, 0xE8B00006) == DATA_ABORT); // ldmia r0!, {r1, r2}
+  assert(arm_read_register(p, 0) == 0x7FC);
+  assert((arm_read_register(p, 1) == 1) && (arm_read_register(p, 2) == 2));
+  assert(arm_load_store_multiple(p, 0xE8A00006) == DATA_ABORT); // stmia r0!, {r1, r2}
+  assert(arm_read_register(p, 0) == 0x7FC);
+  printf("OK\n");
 }
-*/
 
 /*
 //Tests pour LDR / STR "normal" non testé car ça marche pas :-(
@@ -158,10 +168,108 @@ void test_LDR(arm_core p)
 }
 */
 
+void test_LDR_STR(arm_core p)
+{
+  uint32_t word;
+
+  printf("Test : STR and LDR, immediate offset ... ");
+  arm_write_register(p, 0, 0x100);
+  arm_write_register(p, 1, 0x12345678);
+  assert(arm_load_store(p, 0xE5801008) == 0); // str r1, [r0, #8]
+  arm_read_word(p, 0x108, &word);
+  assert(word == 0x12345678);
+  assert(arm_load_store(p, 0xE5902008) == 0); // ldr r2, [r0, #8]
+  assert(arm_read_register(p, 2) == 0x12345678);
+  assert(arm_read_register(p, 0) == 0x100);
+  printf("OK\n");
+
+  printf("Test : LDR pre-indexed with writeback, post-indexed ... ");
+  assert(arm_load_store(p, 0xE5B03008) == 0); // ldr r3, [r0, #8]!
+  assert(arm_read_register(p, 3) == 0x12345678);
+  assert(arm_read_register(p, 0) == 0x108);
+  assert(arm_load_store(p, 0xE4104008) == 0); // ldr r4, [r0], #-8
+  assert(arm_read_register(p, 4) == 0x12345678);
+  assert(arm_read_register(p, 0) == 0x100);
+  printf("OK\n");
+
+  printf("Test : LDR register offset ... ");
+  arm_write_register(p, 5, 2);
+  assert(arm_load_store(p, 0xE7906105) == 0); // ldr r6, [r0, r5, lsl #2]
+  assert(arm_read_register(p, 6) == 0x12345678);
+  printf("OK\n");
+
+  printf("Test : STRB, LDRB, STRH, LDRH, LDRSB ... ");
+  arm_write_register(p, 1, 0xABCD);
+  assert(arm_load_store(p, 0xE5C01010) == 0); // strb r1, [r0, #16]
+  assert(arm_load_store(p, 0xE5D02010) == 0); // ldrb r2, [r0, #16]
+  assert(arm_read_register(p, 2) == 0xCD);
+  assert(arm_load_store(p, 0xE1C011B4) == 0); // strh r1, [r0, #20]
+  assert(arm_load_store(p, 0xE1D031B4) == 0); // ldrh r3, [r0, #20]
+  assert(arm_read_register(p, 3) == 0xABCD);
+  assert(arm_load_store(p, 0xE1D041D0) == 0); // ldrsb r4, [r0, #16]
+  assert(arm_read_register(p, 4) == 0xFFFFFFCD);
+  printf("OK\n");
+}
+
+void test_peek(arm_core p)
+{
+  uint32_t word;
+
+  printf("Test : arm_peek_word at the end of memory ... ");
+  arm_write_word(p, 2044, 0x11223344);
+  assert(arm_peek_word(p, 2044, &word) == 0);
+  assert(word == 0x11223344);
+  assert(arm_peek_word(p, 2045, &word) == -1);
+  assert(arm_peek_word(p, 2048, &word) == -1);
+  assert(arm_peek_word(p, 0xFFFFFFFE, &word) == -1);
+  printf("OK\n");
+}
+
+static int watch_calls;
+static uint32_t watch_address;
+static int watch_write;
+
+static void watch_handler(void *data, uint32_t address, uint8_t size, int write)
+{
+  watch_calls++;
+  watch_address = address;
+  watch_write = write;
+}
+
+void test_watch()
+{
+  // Watches are counted per 4 KiB page, 0x100 and 0x2000 are in distinct pages
+  arm_core p = arm_create(registers_create(), memory_create(0x4000));
+
+  printf("Test : accesses to watched pages only reach the watch handler ... ");
+  arm_set_watch_handler(p, watch_handler, NULL);
+  memory_add_watch(p->mem, 0x2000, 4);
+  arm_write_register(p, 0, 0x100);
+  arm_write_register(p, 7, 0x2000);
+  watch_calls = 0;
+  assert(arm_load_store(p, 0xE5901000) == 0); // ldr r1, [r0]
+  assert(watch_calls == 0);
+  assert(arm_load_store(p, 0xE5871004) == 0); // str r1, [r7, #4]
+  assert((watch_calls == 1) && (watch_address == 0x2004) && watch_write);
+  assert(arm_load_store(p, 0xE5972000) == 0); // ldr r2, [r7]
+  assert((watch_calls == 2) && (watch_address == 0x2000) && !watch_write);
+  memory_remove_watch(p->mem, 0x2000, 4);
+  assert(arm_load_store(p, 0xE5972000) == 0); // ldr r2, [r7]
+  assert(watch_calls == 2);
+  printf("OK\n");
+  memory_destroy(p->mem);
+  registers_destroy(p->reg);
+  arm_destroy(p);
+}
+
 int main()
 {
   arm_core p = arm_create(registers_create(), memory_create(2048));
   test_STM(p);
+  test_LDM(p);
+  test_LDR_STR(p);
+  test_peek(p);
+  test_watch();
   memory_destroy(p->mem);
   registers_destroy(p->reg);
   arm_destroy(p);
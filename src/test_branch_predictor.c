@@ -0,0 +1,130 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <assert.h>
+#include "arm_core.h"
+#include "branch_predictor.h"
+#include "counters.h"
+
+#define LOOP_ADDRESS 0x10
+#define LOOP_TARGET 0x4
+#define BNE_LOOP 0x1AFFFFFB     /* bne 0x4 */
+#define RETURN_ADDRESS 0x20
+#define RETURN_TARGET 0x100
+#define MOV_PC_LR 0xE1A0F00E    /* mov pc, lr */
+#define CALL_ADDRESS 0x40
+#define BL_FUNCTION 0xEB00002E  /* bl 0x100 */
+#define FUNCTION 0x100
+#define FUNCTION_RETURN 0x104
+#define BX_LR 0xE12FFF1E        /* bx lr */
+
+static arm_core p;
+
+static void branch(uint32_t address, uint32_t instruction, int executed, uint32_t pc) {
+    p->current_address = address;
+    p->current_instruction = instruction;
+    registers_write(p->reg, 15, registers_get_mode(p->reg), pc);
+    branch_predictor_instruction(p, executed);
+}
+
+/* A loop branch taken iterations - 1 times, then falling through */
+static void loop(int iterations) {
+    int i;
+
+    for (i = 1; i < iterations; i++)
+        branch(LOOP_ADDRESS, BNE_LOOP, 1, LOOP_TARGET);
+    branch(LOOP_ADDRESS, BNE_LOOP, 0, LOOP_ADDRESS + 4);
+}
+
+static uint64_t mispredictions() {
+    return *counters_find("branch_mispredictions", NULL)->value;
+}
+
+static void check(char *model, uint64_t loop_mispredictions, uint64_t return_mispredictions) {
+    uint64_t cycles;
+
+    printf("Test : %s branch predictor ... ", model);
+    assert(branch_predictor_enable(model) == 0);
+    counters_reset();
+    cycles = arm_get_cycle_count(p);
+    loop(10);
+    assert(mispredictions() == loop_mispredictions);
+    assert(arm_get_cycle_count(p) - cycles == 3 * loop_mispredictions);
+    branch(RETURN_ADDRESS, MOV_PC_LR, 1, RETURN_TARGET);
+    branch(RETURN_ADDRESS, MOV_PC_LR, 1, RETURN_TARGET);
+    assert(mispredictions() == loop_mispredictions + return_mispredictions);
+    assert(*counters_find("branch_predictions", NULL)->value == 12);
+    branch_predictor_disable();
+    printf("OK\n");
+}
+
+/* Calls of a function returning with bx lr : the static model mispredicts
+ * every return, the others predict them with their return stack
+ */
+static void check_returns(char *model, uint64_t call_mispredictions,
+                          uint64_t nested_mispredictions) {
+    int i;
+
+    printf("Test : %s returns ... ", model);
+    assert(branch_predictor_enable(model) == 0);
+    counters_reset();
+    for (i = 0; i < 4; i++) {
+        branch(CALL_ADDRESS, BL_FUNCTION, 1, FUNCTION);
+        branch(FUNCTION_RETURN, BX_LR, 1, CALL_ADDRESS + 4);
+    }
+    assert(mispredictions() == call_mispredictions);
+    /* Nested deeper than the stack : bimodal and btb mispredict the 2
+     * outermost returns, and the calls from sites they have not seen yet
+     */
+    counters_reset();
+    for (i = 0; i < 10; i++)
+        branch(CALL_ADDRESS + 8 * i, BL_FUNCTION - 2 * i, 1, FUNCTION);
+    for (i = 9; i >= 0; i--)
+        branch(FUNCTION_RETURN, BX_LR, 1, CALL_ADDRESS + 8 * i + 4);
+    assert(mispredictions() == nested_mispredictions);
+    branch_predictor_disable();
+    printf("OK\n");
+}
+
+int main() {
+    memory mem = memory_create(0x1000);
+    registers reg = registers_create();
+
+    p = arm_create(reg, mem);
+    printf("Test : invalid configurations ... ");
+    assert(branch_predictor_enable("perfect") == -1);
+    assert(branch_predictor_enable("btb,entries=100") == -1);
+    printf("OK\n");
+    check("static,penalty=3", 1, 2);
+    check("bimodal,penalty=3", 2, 2);
+    check("btb,entries=64,penalty=3", 2, 1);
+    check_returns("static", 4, 10);
+    check_returns("bimodal", 1, 9 + 2);
+    check_returns("btb", 1, 9 + 2);
+
+    counters_clear();
+    arm_destroy(p);
+    registers_destroy(reg);
+    memory_destroy(mem);
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <assert.h>
+#include "breakpoints.h"
+
+int main() {
+    breakpoints b;
+    uint32_t address;
+
+    printf("Test : add, find and remove ... ");
+    b = breakpoints_create();
+    assert(!breakpoints_find(b, 0x100));
+    assert(breakpoints_add(b, 0x100) == 1);
+    assert(breakpoints_add(b, 0x100) == 0);
+    assert(breakpoints_find(b, 0x100));
+    assert(!breakpoints_find(b, 0x101));
+    assert(!breakpoints_find(b, 0x104));
+    assert(breakpoints_number(b) == 1);
+    assert(breakpoints_remove(b, 0x104) == 0);
+    assert(breakpoints_remove(b, 0x100) == 1);
+    assert(!breakpoints_find(b, 0x100));
+    assert(breakpoints_number(b) == 0);
+    printf("OK\n");
+
+    printf("Test : thousands of breakpoints ... ");
+    for (address = 0; address < 0x10000; address += 4)
+        assert(breakpoints_add(b, address) == 1);
+    assert(breakpoints_number(b) == 0x4000);
+    for (address = 0; address < 0x10000; address++)
+        assert(breakpoints_find(b, address) == ((address & 3) == 0));
+    for (address = 0; address < 0x10000; address += 8)
+        assert(breakpoints_remove(b, address) == 1);
+    assert(breakpoints_number(b) == 0x2000);
+    assert(!breakpoints_find(b, 0x1000) && breakpoints_find(b, 0x1004));
+    printf("OK\n");
+
+    printf("Test : addresses at the top of the address space ... ");
+    assert(breakpoints_add(b, 0xFFFFFFFC) == 1);
+    assert(breakpoints_add(b, 0xFFFFFFFF) == 1);
+    assert(breakpoints_find(b, 0xFFFFFFFC) && breakpoints_find(b, 0xFFFFFFFF));
+    assert(!breakpoints_find(b, 0xFFFFFFFD) && !breakpoints_find(b, 0x7FFFFFFC));
+    assert(breakpoints_remove(b, 0xFFFFFFFC) == 1);
+    assert(breakpoints_find(b, 0xFFFFFFFF));
+    /* The last page of a table going away frees the table */
+    assert(breakpoints_remove(b, 0xFFFFFFFF) == 1);
+    assert(!breakpoints_find(b, 0xFFFFFFFF) && breakpoints_find(b, 0x1004));
+    assert(breakpoints_add(b, 0xFFFFF000) == 1);
+    assert(breakpoints_find(b, 0xFFFFF000));
+    breakpoints_destroy(b);
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,97 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <assert.h>
+#include "cache.h"
+#include "counters.h"
+
+static uint64_t counter(char *name, char *labels) {
+    struct counter *c = counters_find(name, labels);
+
+    assert(c != NULL);
+    return *c->value;
+}
+
+int main() {
+    cache c;
+
+    printf("Test : invalid configurations ... ");
+    assert(cache_create("bad", "size=1000") == NULL);
+    assert(cache_create("bad", "line=24") == NULL);
+    assert(cache_create("bad", "replace=mru") == NULL);
+    assert(cache_create("bad", "colour=blue") == NULL);
+    printf("OK\n");
+
+    printf("Test : hits and misses ... ");
+    /* 2 sets of 2 ways of 16 bytes */
+    c = cache_create("lru", "size=64,ways=2,line=16,penalty=5");
+    assert(c != NULL);
+    assert(cache_access(c, 0, 0x100, CACHE_READ) == 5);
+    assert(cache_access(c, 0, 0x104, CACHE_READ) == 0);
+    assert(cache_access(c, 0, 0x10C, CACHE_READ) == 0);
+    assert(cache_access(c, 0, 0x110, CACHE_READ) == 5);
+    assert(counter("cache_hits", "cache=\"lru\",access=\"read\"") == 2);
+    assert(counter("cache_misses", "cache=\"lru\",access=\"read\"") == 2);
+    printf("OK\n");
+
+    printf("Test : LRU replacement ... ");
+    /* 0x100, 0x120 and 0x140 share the set 0 */
+    cache_access(c, 0, 0x120, CACHE_READ);
+    cache_access(c, 0, 0x100, CACHE_READ);
+    assert(cache_access(c, 0, 0x140, CACHE_READ) == 5);
+    assert(cache_access(c, 0, 0x100, CACHE_READ) == 0);
+    assert(cache_access(c, 0, 0x120, CACHE_READ) == 5);
+    cache_destroy(c);
+    printf("OK\n");
+
+    printf("Test : FIFO replacement ... ");
+    c = cache_create("fifo", "size=64,ways=2,line=16,penalty=5,replace=fifo");
+    cache_access(c, 0, 0x100, CACHE_READ);
+    cache_access(c, 0, 0x120, CACHE_READ);
+    cache_access(c, 0, 0x100, CACHE_READ);
+    assert(cache_access(c, 0, 0x140, CACHE_READ) == 5);
+    assert(cache_access(c, 0, 0x100, CACHE_READ) == 5);
+    cache_destroy(c);
+    printf("OK\n");
+
+    printf("Test : write back and write through ... ");
+    c = cache_create("back", "size=32,ways=1,line=16,penalty=5");
+    assert(cache_access(c, 0, 0x100, CACHE_WRITE) == 5);
+    assert(cache_access(c, 0, 0x104, CACHE_READ) == 0);
+    /* Evicts the dirty line */
+    assert(cache_access(c, 0, 0x120, CACHE_READ) == 10);
+    assert(counter("cache_writebacks", "cache=\"back\"") == 1);
+    cache_destroy(c);
+    c = cache_create("through", "size=32,ways=1,line=16,penalty=5,write=through");
+    assert(cache_access(c, 0, 0x100, CACHE_WRITE) == 0);
+    assert(cache_access(c, 0, 0x100, CACHE_READ) == 5);
+    assert(cache_access(c, 0, 0x100, CACHE_WRITE) == 0);
+    assert(cache_access(c, 0, 0x120, CACHE_READ) == 5);
+    assert(counter("cache_misses", "cache=\"through\",access=\"write\"") == 1);
+    assert(counter("cache_writebacks", "cache=\"through\"") == 0);
+    cache_destroy(c);
+    printf("OK\n");
+
+    counters_clear();
+    return 0;
+}
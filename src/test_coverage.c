@@ -0,0 +1,88 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "coverage.h"
+
+static void execute(arm_core p, uint32_t address, uint32_t instruction, int executed) {
+    p->current_address = address;
+    p->current_instruction = instruction;
+    coverage_instruction(p, executed);
+}
+
+/* Executed, passed and failed bytes holding the given address */
+static void read_bitmaps(char *filename, uint32_t address, uint8_t *bytes) {
+    char line[64];
+    uint32_t words;
+    FILE *f;
+    int i;
+
+    f = fopen(filename, "r");
+    assert(f != NULL);
+    assert(fgets(line, sizeof(line), f) != NULL);
+    assert(sscanf(line, "ARMCOV1 %u", &words) == 1);
+    for (i = 0; i < 3; i++) {
+        fseek(f, strlen(line) + i * ((words + 7) / 8) + address / 32, SEEK_SET);
+        bytes[i] = fgetc(f);
+    }
+    fclose(f);
+}
+
+int main() {
+    struct arm_core_data core;
+    uint8_t bytes[3];
+
+    memset(&core, 0, sizeof(core));
+    printf("Test : executed and condition bits ... ");
+    assert(coverage_enable(0x1000) == 0);
+    execute(&core, 0x100, 0xE2800001, 1);       // add r0, r0, #1
+    execute(&core, 0x104, 0x1AFFFFFC, 1);       // bne, taken
+    execute(&core, 0x108, 0x0A000000, 0);       // beq, not taken
+    execute(&core, 0x2000, 0xE2800001, 1);      // out of the memory, ignored
+    assert(coverage_write("/tmp/test_coverage_1") == 0);
+    assert(coverage_file_words("/tmp/test_coverage_1") == 0x400);
+    read_bitmaps("/tmp/test_coverage_1", 0x100, bytes);
+    assert(bytes[0] == 0x07);
+    assert(bytes[1] == 0x02);
+    assert(bytes[2] == 0x04);
+    coverage_disable();
+    printf("OK\n");
+
+    printf("Test : merging ... ");
+    assert(coverage_enable(0x1000) == 0);
+    execute(&core, 0x104, 0x1AFFFFFC, 0);       // bne, not taken this time
+    execute(&core, 0x10C, 0xE1A00000, 1);
+    assert(coverage_merge("/tmp/test_coverage_1") == 0);
+    assert(coverage_merge("/tmp/no_such_coverage") == -1);
+    assert(coverage_write("/tmp/test_coverage_2") == 0);
+    read_bitmaps("/tmp/test_coverage_2", 0x100, bytes);
+    assert(bytes[0] == 0x0F);
+    assert(bytes[1] == 0x02);
+    assert(bytes[2] == 0x06);
+    coverage_disable();
+    remove("/tmp/test_coverage_1");
+    remove("/tmp/test_coverage_2");
+    printf("OK\n");
+    return 0;
+}
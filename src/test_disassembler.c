@@ -0,0 +1,73 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include "disassembler.h"
+
+struct disassembler_case {
+    uint32_t address;
+    uint32_t instruction;
+    char *text;
+    int control_transfer;
+};
+
+static struct disassembler_case cases[] = {
+    { 0x0, 0xE3A00000, "mov r0, #0", 0 },
+    { 0x0, 0xE2800001, "add r0, r0, #1", 0 },
+    { 0x0, 0xE3500064, "cmp r0, #100", 0 },
+    { 0x0, 0xE0912103, "adds r2, r1, r3, lsl #2", 0 },
+    { 0x0, 0xE1A0F00E, "mov pc, lr", 1 },
+    { 0x0, 0xE12FFF1E, "bx lr", 1 },
+    { 0x0, 0xE3A004FF, "mov r0, #4278190080", 0 },
+    { 0x0, 0xE0000291, "mul r0, r1, r2", 0 },
+    { 0x0, 0xE5910004, "ldr r0, [r1, #4]", 0 },
+    { 0x0, 0xE4D10001, "ldrb r0, [r1], #1", 0 },
+    { 0x0, 0xE7A10102, "str r0, [r1, r2, lsl #2]!", 0 },
+    { 0x0, 0xE59FF000, "ldr pc, [pc]", 1 },
+    { 0x0, 0xE1D100B2, "ldrh r0, [r1, #2]", 0 },
+    { 0x0, 0xE92D4010, "stmdb sp!, {r4, lr}", 0 },
+    { 0x0, 0xE8BD8010, "ldmia sp!, {r4, pc}", 1 },
+    { 0x8, 0xEAFFFFFE, "b 0x00000008", 1 },
+    { 0x100, 0x1B000010, "blne 0x00000148", 1 },
+    { 0x0, 0xEF123456, "swi 0x123456", 1 },
+    { 0x0, 0xE10F0000, "mrs r0, cpsr", 0 },
+    { 0x0, 0xE129F000, "msr cpsr_cf, r0", 0 },
+};
+
+int main() {
+    char text[64];
+    unsigned i;
+
+    printf("Test : disassembly of some instructions ... ");
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        arm_disassemble(cases[i].address, cases[i].instruction, text, sizeof(text));
+        if (strcmp(text, cases[i].text) != 0)
+            printf("\n%08X : got \"%s\", expected \"%s\"", cases[i].instruction, text,
+                   cases[i].text);
+        assert(strcmp(text, cases[i].text) == 0);
+        assert(arm_is_control_transfer(cases[i].instruction) == cases[i].control_transfer);
+    }
+    printf("OK\n");
+    return 0;
+}
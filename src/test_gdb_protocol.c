@@ -0,0 +1,131 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "arm.h"
+#include "gdb_protocol.h"
+
+/* Payloads may hold null characters, their length is that of the literal */
+#define PAYLOAD(s) s, sizeof(s) - 1
+
+struct exchange {
+    char *request;
+    size_t request_length;
+    char *reply;
+    size_t reply_length;
+};
+
+/* Memory holds 00 7d 23 24 2a 41 ff 10 at 0x100 : a null byte, the four
+ * characters escaped by the binary packets, then plain bytes
+ */
+static struct exchange exchanges[] = {
+    { PAYLOAD("m100,8"), PAYLOAD("007d23242a41ff10") },
+    { PAYLOAD("m1ffe,4"), PAYLOAD("0000") },
+    { PAYLOAD("m2000,4"), PAYLOAD("E0E") },
+    { PAYLOAD("x101,7"), PAYLOAD("b}]}\x03}\x04}\x0a" "A\xff\x10") },
+    { PAYLOAD("x2000,4"), PAYLOAD("E0E") },
+    { PAYLOAD("P1=cd34ab12"), PAYLOAD("OK") },
+    { PAYLOAD("p1"), PAYLOAD("cd34ab12") },
+    /* Escaped bytes */
+    { PAYLOAD("X200,6:}]}\x03}\x04}\x0a" "\x00\xff"), PAYLOAD("OK") },
+    { PAYLOAD("m200,6"), PAYLOAD("7d23242a00ff") },
+    /* Size larger than the payload, nothing is written */
+    { PAYLOAD("X210,8:abc"), PAYLOAD("E02") },
+    { PAYLOAD("X210,8:abcdefg}"), PAYLOAD("E02") },
+    { PAYLOAD("m210,8"), PAYLOAD("0000000000000000") },
+    /* Payload larger than the size */
+    { PAYLOAD("X210,1:ab"), PAYLOAD("E02") },
+    /* Probe of the binary write support by gdb */
+    { PAYLOAD("X220,0:"), PAYLOAD("OK") },
+    { PAYLOAD("X220,1"), PAYLOAD("E02") },
+    { PAYLOAD("X1fff,2:ab"), PAYLOAD("E02") },
+    { PAYLOAD("X1ffe,2:ab"), PAYLOAD("OK") },
+    { PAYLOAD("m1ffe,2"), PAYLOAD("6162") },
+};
+
+static uint8_t content[] = { 0x00, 0x7d, 0x23, 0x24, 0x2a, 0x41, 0xff, 0x10 };
+
+/* Frames the payload, hands it to the protocol and returns the length of the
+ * reply payload, copied into reply
+ */
+static size_t exchange(gdb_protocol_data_t gdb, int fd, char *payload, size_t length,
+                       char *reply) {
+    char packet[256];
+    unsigned char check = 0;
+    ssize_t received;
+    size_t i, start;
+
+    packet[0] = '$';
+    for (i = 0; i < length; i++) {
+        packet[i + 1] = payload[i];
+        check += (unsigned char) payload[i];
+    }
+    sprintf(packet + length + 1, "#%02x", check);
+    gdb_packet_analysis(gdb, packet, length + 4);
+    received = read(fd, packet, sizeof(packet));
+    /* Skips the acknowledgment, sent until the no acknowledgment mode */
+    start = (received > 0) && (packet[0] == '+');
+    assert((received >= start + 4) && (packet[start] == '$') && (packet[received - 3] == '#'));
+    memcpy(reply, packet + start + 1, received - start - 4);
+    return received - start - 4;
+}
+
+int main() {
+    arm_core p = arm_create(registers_create(), memory_create(0x2000));
+    pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    gdb_protocol_data_t gdb;
+    char reply[256];
+    size_t i, length;
+    int fds[2];
+
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    gdb_init();
+    gdb = gdb_init_data(p, p->reg, p->mem, fds[0], &lock);
+    assert(memory_write_block(p->mem, 0x100, content, sizeof(content)) == 0);
+
+    printf("Test : no acknowledgment mode ... ");
+    length = exchange(gdb, fds[1], PAYLOAD("QStartNoAckMode"), reply);
+    assert((length == 2) && (strncmp(reply, "OK", 2) == 0));
+    printf("OK\n");
+
+    for (i = 0; i < sizeof(exchanges) / sizeof(struct exchange); i++) {
+        printf("Test : %.*s ... ", (int) strcspn(exchanges[i].request, ":"),
+               exchanges[i].request);
+        length = exchange(gdb, fds[1], exchanges[i].request, exchanges[i].request_length,
+                          reply);
+        assert(length == exchanges[i].reply_length);
+        assert(memcmp(reply, exchanges[i].reply, length) == 0);
+        printf("OK\n");
+    }
+
+    gdb_release_data(gdb);
+    close(fds[0]);
+    close(fds[1]);
+    memory_destroy(p->mem);
+    registers_destroy(p->reg);
+    arm_destroy(p);
+    return 0;
+}
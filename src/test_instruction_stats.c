@@ -0,0 +1,79 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <assert.h>
+#include "arm.h"
+#include "instruction_stats.h"
+#include "counters.h"
+
+static uint32_t program[] = {
+    0xE3A02C01,                 /* mov r2, #0x100 */
+    0xE3A00000,                 /* mov r0, #0 */
+    0xE3A01003,                 /* mov r1, #3 */
+    0xE0800001,                 /* loop: add r0, r0, r1 */
+    0xE2511001,                 /* subs r1, r1, #1 */
+    0x1AFFFFFC,                 /* bne loop */
+    0xE5820000,                 /* str r0, [r2] */
+    0xE5D23000,                 /* ldrb r3, [r2] */
+    0xE0040190,                 /* mul r4, r0, r1 */
+    0x0BFFFFFF,                 /* bleq next */
+    0xEF123456                  /* next: swi 0x123456 */
+};
+
+static uint64_t counter(char *name, char *labels) {
+    struct counter *c = counters_find(name, labels);
+
+    assert(c != NULL);
+    return *c->value;
+}
+
+int main() {
+    arm_core p = arm_create(registers_create(), memory_create(2048));
+    int i;
+
+    for (i = 0; i < sizeof(program) / sizeof(uint32_t); i++)
+        arm_write_word(p, 4 * i, program[i]);
+
+    printf("Test : instruction mix of a short program ... ");
+    instruction_stats_enable();
+    while (arm_step(p) != END_SIMULATION);
+    assert(counter("instructions_data_processing", "opcode=\"mov\"") == 3);
+    assert(counter("instructions_data_processing", "opcode=\"add\"") == 3);
+    assert(counter("instructions_data_processing", "opcode=\"sub\"") == 3);
+    assert(counter("instructions_data_processing", "opcode=\"and\"") == 0);
+    assert(counter("instructions_branch", "type=\"b\",outcome=\"taken\"") == 2);
+    assert(counter("instructions_branch", "type=\"b\",outcome=\"not_taken\"") == 1);
+    assert(counter("instructions_branch", "type=\"bl\",outcome=\"taken\"") == 1);
+    assert(counter("instructions_load_store", "type=\"str\"") == 1);
+    assert(counter("instructions_load_store", "type=\"ldrb\"") == 1);
+    assert(counter("instructions_load_store", "type=\"ldr\"") == 0);
+    assert(counter("instructions_multiply", NULL) == 1);
+    assert(counter("instructions_condition_failed", NULL) == 1);
+    assert(counter("instructions_swi", "number=\"0x123456\"") == 1);
+    printf("OK\n");
+
+    memory_destroy(p->mem);
+    registers_destroy(p->reg);
+    arm_destroy(p);
+    return 0;
+}
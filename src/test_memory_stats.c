@@ -0,0 +1,95 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include "memory_stats.h"
+
+static char *dump(int format) {
+    char *buffer;
+    size_t size;
+    FILE *f = open_memstream(&buffer, &size);
+
+    assert(f != NULL);
+    memory_stats_dump(f, format);
+    fclose(f);
+    return buffer;
+}
+
+int main() {
+    char *result;
+
+    printf("Test : disabled statistics ... ");
+    assert(memory_stats_enabled == 0);
+    memory_stats_access(MEMORY_STATS_READ, 0);
+    result = dump(MEMORY_STATS_CSV);
+    assert(result[0] == '\0');
+    free(result);
+    assert(memory_stats_enable(0x2000, 1000, 32) == -1);
+    assert(memory_stats_enabled == 0);
+    printf("OK\n");
+
+    printf("Test : counters per page and line ... ");
+    assert(memory_stats_enable(0x2000, 0x1000, 32) == 0);
+    memory_stats_access(MEMORY_STATS_FETCH, 0);
+    memory_stats_access(MEMORY_STATS_FETCH, 4);
+    memory_stats_access(MEMORY_STATS_READ, 0x1000);
+    memory_stats_access(MEMORY_STATS_WRITE, 0x1004);
+    memory_stats_access(MEMORY_STATS_WRITE, 0x1FFF);
+    // Out of the simulated memory, ignored
+    memory_stats_access(MEMORY_STATS_READ, 0x5000);
+    result = dump(MEMORY_STATS_CSV);
+    assert(strcmp(result,
+                  "granularity,index,start,end,fetch,read,write\n"
+                  "page,0,0x00000000,0x00000FFF,2,0,0\n"
+                  "page,1,0x00001000,0x00001FFF,0,1,2\n"
+                  "line,0,0x00000000,0x0000001F,2,0,0\n"
+                  "line,128,0x00001000,0x0000101F,0,1,1\n"
+                  "line,255,0x00001FE0,0x00001FFF,0,0,1\n") == 0);
+    free(result);
+    printf("OK\n");
+
+    printf("Test : json dump ... ");
+    result = dump(MEMORY_STATS_JSON);
+    assert(strstr(result, "\"page_size\": 4096,") != NULL);
+    assert(strstr(result, "\"line_size\": 32,") != NULL);
+    assert(strstr(result, "{ \"index\": 1, \"start\": 4096, \"fetch\": 0, \"read\": 1, "
+                  "\"write\": 2 }") != NULL);
+    assert(strstr(result, "{ \"index\": 255, \"start\": 8160, \"fetch\": 0, \"read\": 0, "
+                  "\"write\": 1 }") != NULL);
+    free(result);
+    printf("OK\n");
+
+    printf("Test : reset ... ");
+    memory_stats_reset();
+    result = dump(MEMORY_STATS_CSV);
+    assert(strcmp(result,
+                  "granularity,index,start,end,fetch,read,write\n"
+                  "page,0,0x00000000,0x00000FFF,0,0,0\n"
+                  "page,1,0x00001000,0x00001FFF,0,0,0\n") == 0);
+    free(result);
+    printf("OK\n");
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "arm.h"
+#include "counters.h"
+#include "metrics.h"
+
+#define METRICS_FILE "test_metrics.prom"
+#define METRICS_SOCKET "test_metrics.socket"
+
+static int connect_unix(char *path) {
+    struct sockaddr_un address;
+    int fd;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    strcpy(address.sun_path, path);
+    fd = socket(PF_UNIX, SOCK_STREAM, 0);
+    assert(fd != -1);
+    assert(connect(fd, (struct sockaddr *) &address, sizeof(address)) == 0);
+    return fd;
+}
+
+int main() {
+    arm_core p = arm_create(registers_create(), memory_create(0x3000));
+    uint64_t hits = 3, misses = 4, level = 7;
+    char output[4096], *first, *second, request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+    int stalled, client, used = 0;
+    ssize_t length;
+    FILE *f;
+
+    printf("Test : Prometheus format ... ");
+    counters_add("cache_events", "result=\"hit\"", "Cache events", COUNTER, &hits);
+    counters_add("queue_level", NULL, "Queue level", GAUGE, &level);
+    counters_add("cache_events", "result=\"miss\"", "Cache events", COUNTER, &misses);
+    f = fmemopen(output, sizeof(output), "w");
+    counters_write_prometheus(f);
+    fclose(f);
+    /* Samples of a name are grouped after a single HELP and TYPE */
+    first = strstr(output, "# HELP cache_events Cache events\n# TYPE cache_events counter\n"
+                   "cache_events{result=\"hit\"} 3\ncache_events{result=\"miss\"} 4\n");
+    assert(first == output);
+    assert(strstr(first + 1, "# HELP cache_events") == NULL);
+    assert(strstr(output, "# TYPE queue_level gauge\nqueue_level 7\n") != NULL);
+    printf("OK\n");
+
+    printf("Test : unix endpoint with a stalled client ... ");
+    assert(metrics_start("unix:" METRICS_SOCKET, p, 0) == 0);
+    /* Connected first and silent, it must not hold the answer to the next */
+    stalled = connect_unix(METRICS_SOCKET);
+    client = connect_unix(METRICS_SOCKET);
+    assert(write(client, request, strlen(request)) == strlen(request));
+    alarm(10);
+    while ((length = read(client, output + used, sizeof(output) - 1 - used)) > 0)
+        used += length;
+    alarm(0);
+    output[used] = '\0';
+    assert(strncmp(output, "HTTP/1.0 200 OK\r\n", 17) == 0);
+    assert(strstr(output, "\nsimulator_instructions_total 0\n") != NULL);
+    close(client);
+    close(stalled);
+    printf("OK\n");
+
+    printf("Test : file endpoint ... ");
+    assert(metrics_start("nowhere:", p, 1) == -1);
+    assert(metrics_start("file:" METRICS_FILE, p, 0) == -1);
+    assert(metrics_start("file:" METRICS_FILE, p, 3600) == 0);
+    f = fopen(METRICS_FILE, "r");
+    assert(f != NULL);
+    output[fread(output, 1, sizeof(output) - 1, f)] = '\0';
+    fclose(f);
+    assert(strstr(output, "\nsimulator_instructions_total 0\n") != NULL);
+    assert(strstr(output, "\nmemory_pages 3\n") != NULL);
+    /* A step later, with the counters reset in between */
+    arm_step(p);
+    counters_reset();
+    metrics_stop();
+    f = fopen(METRICS_FILE, "r");
+    output[fread(output, 1, sizeof(output) - 1, f)] = '\0';
+    fclose(f);
+    second = strstr(output, "\nsimulator_instructions_total ");
+    assert((second != NULL) && (strncmp(second, "\nsimulator_instructions_total 1\n", 32) == 0));
+    assert(strstr(output, "cache_events{result=\"hit\"} 0\n") != NULL);
+    remove(METRICS_FILE);
+    /* Both endpoints are closed, nothing is exported after */
+    assert(access(METRICS_SOCKET, F_OK) == -1);
+    f = fmemopen(output, sizeof(output), "w");
+    assert(metrics_write(f) == -1);
+    fclose(f);
+    printf("OK\n");
+
+    counters_clear();
+    memory_destroy(p->mem);
+    registers_destroy(p->reg);
+    arm_destroy(p);
+    return 0;
+}
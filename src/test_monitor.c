@@ -0,0 +1,183 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <elf.h>
+#include "arm.h"
+#include "monitor.h"
+#include "counters.h"
+#include "memory_stats.h"
+#include "timing.h"
+
+#define PROGRAM "test_monitor.elf"
+
+/* mov r0, #0x100 then swi 0x123456, in the byte order of the simulator */
+static uint8_t code[] = { 0xE3, 0xA0, 0x0C, 0x01, 0xEF, 0x12, 0x34, 0x56 };
+
+/* Smallest ELF file with one loadable segment at address, 8 bytes larger in
+ * memory than in the file
+ */
+static void write_program(uint32_t address) {
+    Elf32_Ehdr header;
+    Elf32_Phdr segment;
+    FILE *f;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.e_ident, ELFMAG, SELFMAG);
+    header.e_ident[EI_CLASS] = ELFCLASS32;
+    header.e_ident[EI_DATA] = ELFDATA2LSB;
+    header.e_ident[EI_VERSION] = EV_CURRENT;
+    header.e_type = ET_EXEC;
+    header.e_machine = EM_ARM;
+    header.e_version = EV_CURRENT;
+    header.e_entry = address;
+    header.e_phoff = sizeof(header);
+    header.e_ehsize = sizeof(header);
+    header.e_phentsize = sizeof(segment);
+    header.e_phnum = 1;
+    memset(&segment, 0, sizeof(segment));
+    segment.p_type = PT_LOAD;
+    segment.p_offset = sizeof(header) + sizeof(segment);
+    segment.p_vaddr = segment.p_paddr = address;
+    segment.p_filesz = sizeof(code);
+    segment.p_memsz = sizeof(code) + 8;
+    f = fopen(PROGRAM, "w");
+    assert(f != NULL);
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(&segment, sizeof(segment), 1, f);
+    fwrite(code, sizeof(code), 1, f);
+    fclose(f);
+}
+
+/* Runs a command, its output is left in output */
+static int command(arm_core p, char *text, char *output, int size) {
+    char copy[256];
+    FILE *f;
+    int result;
+
+    strcpy(copy, text);
+    f = fmemopen(output, size, "w");
+    assert(f != NULL);
+    result = monitor_command(p, copy, f);
+    fclose(f);
+    return result;
+}
+
+int main() {
+    arm_core p = arm_create(registers_create(), memory_create(0x1000));
+    uint64_t value = 5;
+    char output[1024];
+    uint8_t byte;
+
+    printf("Test : counters dump and reset ... ");
+    counters_add("test_events", "kind=\"a\"", "Events", COUNTER, &value);
+    assert(command(p, "counters", output, sizeof(output)) == 0);
+    assert(strstr(output, "test_events{kind=\"a\"} 5") != NULL);
+    assert(command(p, "counters reset", output, sizeof(output)) == 0);
+    assert(value == 0);
+    assert(command(p, "counters clear", output, sizeof(output)) == -1);
+    printf("OK\n");
+
+    printf("Test : memory statistics dump and reset ... ");
+    assert(command(p, "memory_stats", output, sizeof(output)) == 0);
+    assert(strstr(output, "not enabled") != NULL);
+    assert(memory_stats_enable(0x1000, 0x1000, 0) == 0);
+    memory_stats_access(MEMORY_STATS_READ, 0x10);
+    assert(command(p, "memory_stats", output, sizeof(output)) == 0);
+    assert(strstr(output, "page,0,0x00000000,0x00000FFF,0,1,0\n") != NULL);
+    assert(command(p, "memory_stats reset", output, sizeof(output)) == 0);
+    assert(command(p, "memory_stats", output, sizeof(output)) == 0);
+    assert(strstr(output, "page,0,0x00000000,0x00000FFF,0,0,0\n") != NULL);
+    assert(command(p, "memory_stats clear", output, sizeof(output)) == -1);
+    printf("OK\n");
+
+    printf("Test : timing and trace switches ... ");
+    assert(command(p, "timing flat", output, sizeof(output)) == 0);
+    assert(timing_get(TIMING_PC_WRITE) == 0);
+    assert(command(p, "timing arm9e", output, sizeof(output)) == 0);
+    assert(timing_get(TIMING_PC_WRITE) == 2);
+    assert(command(p, "timing flat", output, sizeof(output)) == 0);
+    assert(command(p, "timing ./no_such_table", output, sizeof(output)) == 0);
+    assert(strstr(output, "arm9e selected") != NULL);
+    assert(timing_get(TIMING_PC_WRITE) == 2);
+    assert(command(p, "trace off", output, sizeof(output)) == 0);
+    assert(command(p, "trace memory on", output, sizeof(output)) == 0);
+    assert(command(p, "trace memory off", output, sizeof(output)) == 0);
+    assert(command(p, "trace state SVC off", output, sizeof(output)) == 0);
+    assert(command(p, "trace state nomode on", output, sizeof(output)) == -1);
+    assert(command(p, "trace sideways on", output, sizeof(output)) == -1);
+    assert(command(p, "trace", output, sizeof(output)) == -1);
+    printf("OK\n");
+
+    printf("Test : reload ... ");
+    assert(command(p, "reload", output, sizeof(output)) == -1);
+    write_program(0x200);
+    memory_write_byte(p->mem, 0x20C, 0xAA);
+    assert(command(p, "reload " PROGRAM, output, sizeof(output)) == 0);
+    memory_read_byte(p->mem, 0x200, &byte);
+    assert(byte == 0xE3);
+    memory_read_byte(p->mem, 0x20C, &byte);
+    assert(byte == 0);
+    assert(registers_read(p->reg, 15, registers_get_mode(p->reg)) == 0x200);
+    assert(arm_step(p) == 0);
+    assert(arm_read_register(p, 0) == 0x100);
+    /* Same program again, after its registers have been changed */
+    arm_write_register(p, 0, 0);
+    arm_write_register(p, 1, 5);
+    arm_write_register(p, 13, 0x800);
+    assert(command(p, "reload", output, sizeof(output)) == 0);
+    assert(arm_read_register(p, 1) == 0);
+    assert(arm_read_register(p, 13) == 0x1000);
+    assert(arm_step(p) == 0);
+    assert(arm_read_register(p, 0) == 0x100);
+    /* A segment past the end of memory leaves it untouched */
+    write_program(0xFF8);
+    memory_write_byte(p->mem, 0xFF8, 0xAA);
+    assert(command(p, "reload", output, sizeof(output)) == -1);
+    assert(strstr(output, "does not fit") != NULL);
+    memory_read_byte(p->mem, 0xFF8, &byte);
+    assert(byte == 0xAA);
+    assert(registers_read(p->reg, 15, registers_get_mode(p->reg)) == 0x204);
+    remove(PROGRAM);
+    printf("OK\n");
+
+    printf("Test : help and unknown commands ... ");
+    assert(command(p, "help", output, sizeof(output)) == 0);
+    assert(strstr(output, "reload [elf_file]") != NULL);
+    assert(command(p, "", output, sizeof(output)) == 0);
+    assert(command(p, "frobnicate", output, sizeof(output)) == -1);
+    assert(strstr(output, "Unknown monitor command frobnicate") != NULL);
+    /* Arguments past those parsed are not dropped silently */
+    assert(command(p, "help a b c d e f g", output, sizeof(output)) == 0);
+    assert(command(p, "help a b c d e f g h", output, sizeof(output)) == -1);
+    assert(strstr(output, "Usage : help") != NULL);
+    printf("OK\n");
+
+    counters_clear();
+    memory_destroy(p->mem);
+    registers_destroy(p->reg);
+    arm_destroy(p);
+    return 0;
+}
@@ -0,0 +1,103 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <assert.h>
+#include "arm_core.h"
+#include "pipeline.h"
+#include "counters.h"
+#include "timing.h"
+
+static uint64_t counter(char *name, char *labels) {
+    struct counter *c = counters_find(name, labels);
+
+    assert(c != NULL);
+    return *c->value;
+}
+
+/* Runs the instructions through the hazard model only, as if sequential */
+static void run(arm_core p, uint32_t *instructions, int number) {
+    int i;
+
+    for (i = 0; i < number; i++) {
+        p->current_address = 4 * i;
+        p->current_instruction = instructions[i];
+        registers_write(p->reg, 15, registers_get_mode(p->reg), 4 * i + 4);
+        pipeline_instruction(p, 1);
+    }
+}
+
+int main() {
+    memory mem = memory_create(0x1000);
+    registers reg = registers_create();
+    arm_core p = arm_create(reg, mem);
+    uint64_t cycles;
+    uint32_t load_use[] = {
+        0xE5910000,             /* ldr r0, [r1] */
+        0xE2802001,             /* add r2, r0, #1 */
+        0xE5910000,             /* ldr r0, [r1] */
+        0xE2813001,             /* add r3, r1, #1 */
+        0xE8BD0003,             /* ldmia sp!, {r0, r1} */
+        0xE0811000,             /* add r1, r1, r0 */
+    };
+    uint32_t flags[] = {
+        0xE0100291,             /* muls r0, r1, r2 */
+        0x00813002,             /* addeq r3, r1, r2 */
+        0xE3500000,             /* cmp r0, #0 */
+        0x00813002,             /* addeq r3, r1, r2 */
+    };
+
+    pipeline_enable();
+    printf("Test : load-use interlocks ... ");
+    cycles = arm_get_cycle_count(p);
+    run(p, load_use, 6);
+    assert(counter("pipeline_stalls", "cause=\"load_use\"") == 2);
+    assert(arm_get_cycle_count(p) - cycles == 2);
+    printf("OK\n");
+
+    printf("Test : flag dependencies ... ");
+    run(p, flags, 4);
+    assert(counter("pipeline_stalls", "cause=\"flags\"") == 1);
+    assert(counter("pipeline_stalls", "cause=\"load_use\"") == 2);
+    printf("OK\n");
+
+    printf("Test : PC writes, counted only when refills are charged ... ");
+    p->current_address = 0;
+    p->current_instruction = 0xEA000002;        /* b 0x10 */
+    registers_write(reg, 15, registers_get_mode(reg), 0x10);
+    pipeline_instruction(p, 1);
+    assert(counter("pipeline_stalls", "cause=\"pc_write\"") == 1);
+    assert(counter("pipeline_stall_cycles", "cause=\"pc_write\"") ==
+           timing_get(TIMING_PC_WRITE));
+    /* As with a branch predictor */
+    timing_charge_refills(0);
+    pipeline_instruction(p, 1);
+    assert(counter("pipeline_stalls", "cause=\"pc_write\"") == 1);
+    timing_charge_refills(1);
+    printf("OK\n");
+
+    counters_clear();
+    arm_destroy(p);
+    registers_destroy(reg);
+    memory_destroy(mem);
+    return 0;
+}
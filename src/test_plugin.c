@@ -0,0 +1,122 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <assert.h>
+#include "arm.h"
+#include "plugin.h"
+
+static uint32_t program[] = {
+    0xE3A00C01,                 /* mov r0, #0x100 */
+    0xE3A01003,                 /* mov r1, #3 */
+    0xE4801004,                 /* loop: str r1, [r0], #4 */
+    0xE2511001,                 /* subs r1, r1, #1 */
+    0x1AFFFFFC,                 /* bne loop */
+    0xEF123456                  /* swi 0x123456 */
+};
+
+static int instructions, blocks, reads, writes, r1_writes, cpsr_writes, exceptions;
+static uint32_t block_addresses[8], last_written, swi_number;
+
+static void on_instruction(arm_core p, uint32_t address, uint32_t instruction, void *data) {
+    assert(instruction == program[address / 4]);
+    (*(int *) data)++;
+}
+
+static void on_basic_block(arm_core p, uint32_t address, void *data) {
+    block_addresses[blocks++] = address;
+}
+
+static void on_memory(arm_core p, uint32_t address, uint8_t size, uint8_t type, uint32_t value,
+                      void *data) {
+    assert(size == 4);
+    if (type == PLUGIN_WRITE) {
+        writes++;
+        last_written = value;
+    } else {
+        reads++;
+    }
+}
+
+static void on_register(arm_core p, uint8_t reg, uint8_t mode, uint32_t value, void *data) {
+    if (reg == 1)
+        r1_writes++;
+    if (reg == 16)
+        cpsr_writes++;
+}
+
+static void on_exception(arm_core p, uint8_t exception, void *data) {
+    assert(exception == SOFTWARE_INTERRUPT);
+    exceptions++;
+}
+
+static void on_swi(arm_core p, uint32_t number, void *data) {
+    swi_number = number;
+}
+
+int main() {
+    arm_core p = arm_create(registers_create(), memory_create(2048));
+    int i;
+
+    for (i = 0; i < sizeof(program) / sizeof(uint32_t); i++)
+        arm_write_word(p, 4 * i, program[i]);
+
+    printf("Test : no subscriber ... ");
+    assert(plugin_subscribed == 0);
+    assert(plugin_load("./no_such_plugin.so", "") == -1);
+    printf("OK\n");
+
+    printf("Test : hooks of a run ... ");
+    assert(plugin_add_instruction_hook(on_instruction, &instructions) == 0);
+    assert(plugin_add_basic_block_hook(on_basic_block, NULL) == 0);
+    assert(plugin_add_memory_hook(on_memory, NULL) == 0);
+    assert(plugin_add_register_hook(on_register, NULL) == 0);
+    assert(plugin_add_exception_hook(on_exception, NULL) == 0);
+    assert(plugin_add_swi_hook(on_swi, NULL) == 0);
+    while (arm_step(p) != END_SIMULATION);
+    assert(instructions == 12);
+    assert(blocks == 4);
+    assert((block_addresses[0] == 0) && (block_addresses[1] == 8) &&
+           (block_addresses[2] == 8) && (block_addresses[3] == 0x14));
+    assert((writes == 3) && (last_written == 1));
+    // The software interrupt handler reads the instruction to get its number
+    assert(reads == 1);
+    assert(r1_writes == 4);
+    // Flags set by subs, when they change : carry on the first, zero on the last
+    assert(cpsr_writes == 2);
+    assert(exceptions == 1);
+    assert(swi_number == 0x123456);
+    printf("OK\n");
+
+    printf("Test : hooks removal ... ");
+    plugin_remove_hooks();
+    assert(plugin_subscribed == 0);
+    arm_write_register(p, 15, 0);
+    while (arm_step(p) != END_SIMULATION);
+    assert((instructions == 12) && (blocks == 4));
+    printf("OK\n");
+
+    memory_destroy(p->mem);
+    registers_destroy(p->reg);
+    arm_destroy(p);
+    return 0;
+}
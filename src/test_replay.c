@@ -0,0 +1,180 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "arm.h"
+#include "arm_exception.h"
+#include "replay.h"
+
+#define LOG_FILE "test_replay.events"
+#define INPUT_FILE "test_replay.input"
+#define MEMORY_SIZE 0x400
+
+/* Counts its runs in memory, stores a character read from the console and
+ * adds a word of memory that the program itself never writes
+ */
+static uint32_t program[] = {
+    0xE3A04C02,                 /* mov r4, #0x200 */
+    0xE5941000,                 /* ldr r1, [r4] */
+    0xE2811001,                 /* add r1, r1, #1 */
+    0xE5841000,                 /* str r1, [r4] */
+    0xEF000002,                 /* swi 2 (getchar) */
+    0xE5840004,                 /* str r0, [r4, #4] */
+    0xE3A02010,                 /* mov r2, #16 */
+    0xE0833002,                 /* loop: add r3, r3, r2 */
+    0xE2522001,                 /* subs r2, r2, #1 */
+    0x1AFFFFFC,                 /* bne loop */
+    0xE5945008,                 /* ldr r5, [r4, #8] */
+    0xE0833005,                 /* add r3, r3, r5 */
+    0xEF123456                  /* swi 0x123456 */
+};
+
+static uint8_t injected[] = { 0x00, 0x00, 0x10, 0x00 };
+
+static arm_core create() {
+    arm_core p = arm_create(registers_create(), memory_create(MEMORY_SIZE));
+    int i;
+
+    for (i = 0; i < sizeof(program) / sizeof(uint32_t); i++)
+        arm_write_word(p, 4 * i, program[i]);
+    return p;
+}
+
+static void destroy(arm_core p) {
+    memory_destroy(p->mem);
+    registers_destroy(p->reg);
+    arm_destroy(p);
+}
+
+/* Whether the log holds line, before the end of the recording */
+static int logged(char *line) {
+    char content[4096];
+    FILE *f = fopen(LOG_FILE, "r");
+
+    assert(f != NULL);
+    content[fread(content, 1, sizeof(content) - 1, f)] = '\0';
+    fclose(f);
+    return strstr(content, line) != NULL;
+}
+
+/* Inputs of the outside world, recorded as arm_simulator does for the irq
+ * sender and gdb : a reset, a register write and a memory write
+ */
+static void record_run(arm_core p) {
+    int exception = 0;
+
+    while (exception != END_SIMULATION) {
+        switch (arm_get_instruction_count(p)) {
+        case 20:
+            replay_record_irq(p, RESET);
+            arm_exception(p, RESET);
+            break;
+        case 30:
+            replay_record_register(p, 3, registers_get_mode(p->reg), 0x1000);
+            registers_write(p->reg, 3, registers_get_mode(p->reg), 0x1000);
+            break;
+        case 35:
+            replay_record_memory(p, 0x208, injected, sizeof(injected));
+            memory_write_block(p->mem, 0x208, injected, sizeof(injected));
+            /* Already on disk, should the simulator be killed now */
+            assert(logged("35 mem 00000208 00001000\n"));
+            break;
+        }
+        exception = arm_step(p);
+    }
+    replay_finish(p);
+}
+
+/* Same loop as the replay of arm_simulator */
+static void replay_run(arm_core p) {
+    int exception = 0;
+
+    while (!replay_inject(p) && (exception != END_SIMULATION))
+        exception = arm_step(p);
+    replay_finish(p);
+}
+
+int main() {
+    arm_core recorded = create(), replayed = create();
+    uint8_t recorded_memory[MEMORY_SIZE], replayed_memory[MEMORY_SIZE];
+    uint32_t word;
+    FILE *f;
+    int i;
+
+    f = fopen(INPUT_FILE, "w");
+    fputs("AB", f);
+    fclose(f);
+    assert(freopen(INPUT_FILE, "r", stdin) != NULL);
+
+    printf("Test : recorded run ... ");
+    assert(replay_start_recording(LOG_FILE) == 0);
+    record_run(recorded);
+    /* The reset restarted the program, which read a second character */
+    memory_read_word(recorded->mem, 0x200, &word, 1);
+    assert(word == 2);
+    memory_read_word(recorded->mem, 0x204, &word, 1);
+    assert(word == 'B');
+    assert(arm_read_register(recorded, 5) == 0x1000);
+    printf("OK\n");
+
+    printf("Test : replayed run ... ");
+    /* The console input now comes from the log only */
+    assert(freopen("/dev/null", "r", stdin) != NULL);
+    assert(replay_start_replaying(LOG_FILE) == 0);
+    assert(replay_is_replaying());
+    replay_run(replayed);
+    assert(!replay_is_replaying());
+    assert(arm_get_instruction_count(replayed) == arm_get_instruction_count(recorded));
+    for (i = 0; i < 16; i++)
+        assert(arm_read_register(replayed, i) == arm_read_register(recorded, i));
+    assert(arm_read_cpsr(replayed) == arm_read_cpsr(recorded));
+    memory_read_block(recorded->mem, 0, recorded_memory, MEMORY_SIZE);
+    memory_read_block(replayed->mem, 0, replayed_memory, MEMORY_SIZE);
+    assert(memcmp(recorded_memory, replayed_memory, MEMORY_SIZE) == 0);
+    printf("OK\n");
+
+    printf("Test : memory write out of memory in the log ... ");
+    f = fopen(LOG_FILE, "w");
+    fprintf(f, "0 mem 000003fe 01020304\n0 end\n");
+    fclose(f);
+    fflush(stdout);
+    if (fork() == 0) {
+        freopen("/dev/null", "w", stderr);
+        assert(replay_start_replaying(LOG_FILE) == 0);
+        replay_run(replayed);
+        exit(0);
+    }
+    wait(&i);
+    assert(WIFEXITED(i) && (WEXITSTATUS(i) == 1));
+    printf("OK\n");
+
+    remove(LOG_FILE);
+    remove(INPUT_FILE);
+    destroy(recorded);
+    destroy(replayed);
+    return 0;
+}
@@ -0,0 +1,137 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <assert.h>
+#include "arm_core.h"
+#include "timing.h"
+
+static arm_core p;
+
+/* Cycles of ins at address 0x100, pc being the PC after its execution (0 for
+ * the next instruction)
+ */
+static uint32_t cycles(uint32_t ins, int executed, uint32_t pc) {
+    p->current_address = 0x100;
+    p->current_instruction = ins;
+    registers_write(p->reg, 15, registers_get_mode(p->reg), pc ? pc : 0x104);
+    return timing_cycles(p, executed);
+}
+
+/* mul r0, r1, r2 with the multiplier operand r2 */
+static uint32_t multiply(uint32_t ins, uint32_t multiplier) {
+    registers_write(p->reg, 2, registers_get_mode(p->reg), multiplier);
+    return cycles(ins, 1, 0);
+}
+
+int main() {
+    char name[] = "/tmp/test_timing_XXXXXX";
+    FILE *f;
+    int fd;
+
+    p = arm_create(registers_create(), memory_create(0x1000));
+
+    printf("Test : flat table ... ");
+    assert(timing_select("flat") == 0);
+    assert(cycles(0xE0810002, 1, 0) == 1);      /* add r0, r1, r2 */
+    assert(cycles(0xE5910000, 1, 0) == 1);      /* ldr r0, [r1] */
+    assert(cycles(0xE8BD000F, 1, 0) == 1);      /* ldmia sp!, {r0-r3} */
+    assert(cycles(0xEA000010, 1, 0x148) == 1);  /* b */
+    assert(multiply(0xE0000291, 0x12345678) == 1);
+    /* Nothing to charge beyond the fetch */
+    assert(timing_charged == 0);
+    printf("OK\n");
+
+    printf("Test : arm9e table ... ");
+    assert(timing_select("arm9e") == 0);
+    assert(timing_charged);
+    assert(cycles(0xE0810002, 1, 0) == 1);      /* add r0, r1, r2 */
+    assert(cycles(0xE0810312, 1, 0) == 2);      /* add r0, r1, r2, lsl r3 */
+    assert(cycles(0x00810002, 0, 0) == 1);      /* addeq, condition failed */
+    assert(cycles(0xE1A0F000, 1, 0x200) == 3);  /* mov pc, r0 */
+    assert(cycles(0xE5910000, 1, 0) == 2);      /* ldr r0, [r1] */
+    assert(cycles(0xE5D10000, 1, 0) == 3);      /* ldrb r0, [r1] */
+    assert(cycles(0xE5810000, 1, 0) == 1);      /* str r0, [r1] */
+    assert(cycles(0xE8BD000F, 1, 0) == 6);      /* ldmia sp!, {r0-r3} */
+    assert(cycles(0xE92D0007, 1, 0) == 4);      /* stmdb sp!, {r0-r2} */
+    assert(cycles(0xEA000010, 1, 0x148) == 3);  /* b */
+    assert(cycles(0xEF000000, 1, 0x8) == 3);    /* swi */
+    printf("OK\n");
+
+    printf("Test : multiplier early termination ... ");
+    assert(multiply(0xE0000291, 0x12) == 1);    /* mul r0, r1, r2 */
+    assert(multiply(0xE0000291, 0x1234) == 2);
+    assert(multiply(0xE0000291, 0x123456) == 3);
+    assert(multiply(0xE0000291, 0x12345678) == 4);
+    /* Negative operands terminate on their sign bytes */
+    assert(multiply(0xE0000291, 0xFFFFFF80) == 1);
+    assert(multiply(0xE0000291, 0xFFFF8000) == 2);
+    assert(multiply(0xE0203291, 0x12) == 2);    /* mla r0, r1, r2, r3 */
+    assert(multiply(0xE0810291, 0x12) == 2);    /* umull r0, r1, r1, r2 */
+    printf("OK\n");
+
+    printf("Test : latencies and refills charged elsewhere ... ");
+    timing_charge_latencies(0);
+    timing_charge_refills(0);
+    assert(cycles(0xE5910000, 1, 0) == 1);      /* ldr r0, [r1] */
+    assert(cycles(0xEA000010, 1, 0x148) == 1);  /* b */
+    timing_charge_latencies(1);
+    timing_charge_refills(1);
+    printf("OK\n");
+
+    printf("Test : table file overriding arm9e ... ");
+    fd = mkstemp(name);
+    assert(fd != -1);
+    f = fdopen(fd, "w");
+    fprintf(f, "# Slower multiplier\nmultiply_step 3\nload 5\n");
+    fclose(f);
+    assert(timing_select(name) == 0);
+    assert(timing_get(TIMING_MULTIPLY_STEP) == 3);
+    assert(multiply(0xE0000291, 0x12345678) == 10);
+    assert(cycles(0xE5910000, 1, 0) == 6);      /* ldr r0, [r1] */
+    assert(cycles(0xE0810002, 1, 0) == 1);      /* add r0, r1, r2 */
+    f = fopen(name, "w");
+    fprintf(f, "load 5\nunknown 2\n");
+    fclose(f);
+    assert(timing_select(name) == -1);
+    /* Nothing of the invalid table is kept */
+    assert(timing_get(TIMING_LOAD) == 1);
+    f = fopen(name, "w");
+    fprintf(f, "register_shift 0\ndata_processing 0\n");
+    fclose(f);
+    assert(timing_select(name) == -1);
+    assert(timing_get(TIMING_DATA_PROCESSING) == 1);
+    /* The fetch cycle is already counted */
+    p->cycle_count = 0;
+    cycles(0xE0810002, 1, 0);                   /* add r0, r1, r2 */
+    timing_charge_instruction(p, 1);
+    assert(p->cycle_count == 0);
+    unlink(name);
+    printf("OK\n");
+
+    memory_destroy(p->mem);
+    registers_destroy(p->reg);
+    arm_destroy(p);
+    return 0;
+}
@@ -0,0 +1,125 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sys/wait.h>
+
+/* Runs the trace_diff built along with the tests on generated traces */
+
+static char first[] = "/tmp/test_trace_diff_1_XXXXXX";
+static char second[] = "/tmp/test_trace_diff_2_XXXXXX";
+static char output[4096];
+
+/* lines records, the record diverging (-1 for none) gets another value */
+static void write_trace(char *name, long lines, long diverging) {
+    FILE *f;
+    long i;
+
+    f = fopen(name, "w");
+    assert(f != NULL);
+    for (i = 0; i < lines; i++)
+        fprintf(f, "Cycle %ld, Register write, R00_SVC, val: %08lX\n", i + 1,
+                (i == diverging) ? 0xDEAD : i);
+    fclose(f);
+}
+
+/* Exit status of trace_diff, its output is stored in output */
+static int trace_diff(int context) {
+    char command[128];
+    size_t size;
+    FILE *f;
+    int status;
+
+    snprintf(command, sizeof(command), "./trace_diff --context %d %s %s", context, first, second);
+    f = popen(command, "r");
+    assert(f != NULL);
+    size = fread(output, 1, sizeof(output) - 1, f);
+    output[size] = '\0';
+    status = pclose(f);
+    assert(WIFEXITED(status));
+    return WEXITSTATUS(status);
+}
+
+static void test_identical() {
+    printf("Test : identical traces ... ");
+    write_trace(first, 1000, -1);
+    write_trace(second, 1000, -1);
+    assert(trace_diff(3) == 0);
+    assert(output[0] == '\0');
+    printf("OK\n");
+}
+
+static void test_divergence(long lines, long diverging) {
+    char expected[128];
+
+    printf("Test : divergence at record %ld of %ld ... ", diverging + 1, lines);
+    write_trace(first, lines, -1);
+    write_trace(second, lines, diverging);
+    assert(trace_diff(2) == 1);
+    snprintf(expected, sizeof(expected), "First difference at line %ld ", diverging + 1);
+    assert(strstr(output, expected) != NULL);
+    /* Context before, then the divergent records of both traces */
+    snprintf(expected, sizeof(expected), "  %ld: Cycle %ld,", diverging - 1, diverging - 1);
+    assert(strstr(output, expected) != NULL);
+    snprintf(expected, sizeof(expected), "- %ld: Cycle %ld, Register write, R00_SVC, val: %08lX\n",
+             diverging + 1, diverging + 1, diverging);
+    assert(strstr(output, expected) != NULL);
+    snprintf(expected, sizeof(expected),
+             "+ %ld: Cycle %ld, Register write, R00_SVC, val: 0000DEAD\n", diverging + 1,
+             diverging + 1);
+    assert(strstr(output, expected) != NULL);
+    printf("OK\n");
+}
+
+static void test_prefix() {
+    printf("Test : trace prefix of the other ... ");
+    write_trace(first, 500, -1);
+    write_trace(second, 600, -1);
+    assert(trace_diff(1) == 1);
+    assert(strstr(output, "First difference at line 501 ") != NULL);
+    assert(strstr(output, "- (end of") != NULL);
+    assert(strstr(output, "+ 501: Cycle 501,") != NULL);
+    printf("OK\n");
+}
+
+int main() {
+    int fd;
+
+    fd = mkstemp(first);
+    assert(fd != -1);
+    close(fd);
+    fd = mkstemp(second);
+    assert(fd != -1);
+    close(fd);
+    test_identical();
+    test_divergence(1000, 10);
+    /* Records of about 50 bytes, beyond the first blocks of a megabyte */
+    test_divergence(60000, 45000);
+    test_prefix();
+    unlink(first);
+    unlink(second);
+    return 0;
+}
@@ -0,0 +1,231 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <inttypes.h>
+#include "trace.h"
+#include "trace_reader.h"
+#include "registers.h"
+#include "arm_constants.h"
+
+#define CYCLES 1000
+#define KEYFRAME_INTERVAL 64
+
+/* Cycles of the traces start after base */
+static uint64_t base;
+
+static void write_trace(char *name, int keyframes) {
+    registers r;
+    FILE *f;
+    uint64_t cycle;
+
+    f = fopen(name, "w");
+    assert(f != NULL);
+    r = registers_create();
+    registers_write_cpsr(r, SVC);
+    set_trace_file(f);
+    trace_set_keyframe_interval(keyframes ? KEYFRAME_INTERVAL : 0);
+    for (cycle = base + 1; cycle <= base + CYCLES; cycle++) {
+        registers_write(r, 0, SVC, cycle);
+        trace_register(cycle, WRITE, 0, SVC, cycle);
+        trace_register(cycle, READ, 0, SVC, cycle);
+        trace_keyframe(cycle, r);
+    }
+    trace_finish();
+    fclose(f);
+    registers_destroy(r);
+}
+
+static void check_seek(trace_reader t, uint64_t cycle) {
+    uint64_t read_cycle;
+    char expected[64];
+    char *line;
+
+    cycle += base;
+    assert(trace_reader_seek(t, cycle) == 0);
+    snprintf(expected, sizeof(expected),
+             "Cycle %" PRIu64 ", Register write, R00_SVC, val: %08X\n", cycle, (uint32_t) cycle);
+    line = trace_reader_next(t, &read_cycle);
+    assert(line != NULL);
+    assert(read_cycle == cycle);
+    assert(strcmp(line, expected) == 0);
+    line = trace_reader_next(t, &read_cycle);
+    assert((line != NULL) && (read_cycle == cycle));
+}
+
+void test_seek(char *name, int keyframes) {
+    trace_reader t;
+    uint64_t cycle;
+    char *line;
+
+    printf("Test : seek in a trace %s keyframes from cycle %" PRIu64 " ... ",
+           keyframes ? "with" : "without", base);
+    write_trace(name, keyframes);
+    t = trace_reader_open(name);
+    assert(t != NULL);
+    assert(trace_reader_is_indexed(t) == keyframes);
+    check_seek(t, 1);
+    check_seek(t, KEYFRAME_INTERVAL);
+    check_seek(t, KEYFRAME_INTERVAL + 1);
+    check_seek(t, 517);
+    check_seek(t, 3);
+    check_seek(t, CYCLES);
+    assert(trace_reader_seek(t, base + CYCLES + 1) == -1);
+    /* The index is not part of the records */
+    assert(trace_reader_seek(t, base + CYCLES) == 0);
+    while ((line = trace_reader_next(t, &cycle)) != NULL)
+        assert(strncmp(line, TRACE_INDEX_TAG, strlen(TRACE_INDEX_TAG)) != 0);
+    trace_reader_close(t);
+    printf("OK\n");
+}
+
+/* Replaces the footer of the trace, which must then be read unindexed */
+void test_damaged_footer(char *name, char *footer) {
+    trace_reader t;
+    FILE *f;
+
+    printf("Test : damaged footer %.*s ... ", (int) strlen(footer) - 1, footer);
+    write_trace(name, 1);
+    f = fopen(name, "r+");
+    assert(f != NULL);
+    assert(strlen(footer) == TRACE_FOOTER_SIZE);
+    fseek(f, -TRACE_FOOTER_SIZE, SEEK_END);
+    fputs(footer, f);
+    fclose(f);
+    t = trace_reader_open(name);
+    assert(t != NULL);
+    assert(!trace_reader_is_indexed(t));
+    check_seek(t, 517);
+    trace_reader_close(t);
+    printf("OK\n");
+}
+
+#define DELTA_CYCLES 200
+#define DELTA_INTERVAL 8
+
+/* Registers of SVC after each cycle, rebuilt from the full and delta state
+ * records read back through the reader
+ */
+static void apply_state(char *line, uint32_t *state) {
+    char register_name[8];
+    unsigned int value;
+    int length, reg;
+
+    if (strncmp(line, "SVC:", 4) == 0)
+        line += 4;
+    else if (strncmp(line, "SVC~:", 5) == 0)
+        line += 5;
+    while (sscanf(line, " %7[^=]=%x%n", register_name, &value, &length) == 2) {
+        for (reg = 0; (reg < 18) && strcmp(register_name, arm_get_register_name(reg)); reg++);
+        assert(reg < 18);
+        state[reg] = value;
+        line += length;
+    }
+}
+
+void test_delta_state(char *name) {
+    uint32_t expected[DELTA_CYCLES + 1][18], state[18];
+    uint64_t cycle, read_cycle, last_cycle;
+    int full = 0, delta = 0, reg;
+    trace_reader t;
+    registers r;
+    char *line;
+    FILE *f;
+
+    printf("Test : delta state records read back ... ");
+    f = fopen(name, "w");
+    assert(f != NULL);
+    r = registers_create();
+    registers_write_cpsr(r, SVC);
+    set_trace_file(f);
+    trace_set_keyframe_interval(0);
+    trace_set_state_delta_interval(DELTA_INTERVAL);
+    trace_add(SVC);
+    for (cycle = 1; cycle <= DELTA_CYCLES; cycle++) {
+        registers_write(r, 0, SVC, cycle);
+        if (cycle % 3 == 0)
+            registers_write(r, 5, SVC, cycle * 7);
+        if (cycle % 7 == 0)
+            registers_write_cpsr(r, SVC | (cycle << 28));
+        trace_register(cycle, WRITE, 0, SVC, cycle);
+        trace_arm_state(r);
+        for (reg = 0; reg < 16; reg++)
+            expected[cycle][reg] = registers_read(r, reg, SVC);
+        expected[cycle][CPSR] = registers_read_cpsr(r);
+        expected[cycle][SPSR] = registers_read_spsr(r, SVC);
+    }
+    trace_finish();
+    fclose(f);
+    registers_destroy(r);
+    trace_remove(SVC);
+    trace_set_state_delta_interval(0);
+
+    t = trace_reader_open(name);
+    assert(t != NULL);
+    memset(state, 0, sizeof(state));
+    last_cycle = 0;
+    while ((line = trace_reader_next(t, &read_cycle)) != NULL) {
+        /* A new cycle starts, the state of the previous one is complete */
+        if (read_cycle != last_cycle) {
+            if (last_cycle > 0)
+                assert(memcmp(state, expected[last_cycle], sizeof(state)) == 0);
+            last_cycle = read_cycle;
+        }
+        full += strncmp(line, "SVC:", 4) == 0;
+        delta += strncmp(line, "SVC~:", 5) == 0;
+        apply_state(line, state);
+    }
+    assert(last_cycle == DELTA_CYCLES);
+    assert(memcmp(state, expected[DELTA_CYCLES], sizeof(state)) == 0);
+    assert(full == DELTA_CYCLES / DELTA_INTERVAL);
+    assert(full + delta == DELTA_CYCLES);
+    trace_reader_close(t);
+    printf("OK\n");
+}
+
+int main() {
+    char name[] = "/tmp/test_trace_reader_XXXXXX";
+    int fd;
+
+    fd = mkstemp(name);
+    assert(fd != -1);
+    close(fd);
+    trace_add(REGISTERS);
+    test_seek(name, 1);
+    test_seek(name, 0);
+    /* Across the 32 bits boundary */
+    base = 0xFFFFFF00;
+    test_seek(name, 1);
+    test_seek(name, 0);
+    base = 0;
+    test_damaged_footer(name, "Trace index: FFFFFFFFFFFFFFFF 0000000000000010\n");
+    test_damaged_footer(name, "Trace index: 0000000000000010 FFFFFFFFFFFFFFFF\n");
+    test_damaged_footer(name, "Trace index: 0000000000000000 0000000001000000\n");
+    test_damaged_footer(name, "Trace index: 00000000FFFFFFFF 0000000000000010\n");
+    test_delta_state(name);
+    unlink(name);
+    return 0;
+}
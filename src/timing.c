@@ -0,0 +1,199 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <string.h>
+#include "timing.h"
+#include "util.h"
+
+static char *cost_names[TIMING_COSTS] = {
+    "data_processing", "register_shift", "pc_write", "branch", "load", "load_latency",
+    "load_sub_word_latency", "store", "load_multiple", "load_multiple_register",
+    "store_multiple", "store_multiple_register", "multiply", "multiply_step",
+    "multiply_long", "multiply_accumulate", "swap", "status_register", "swi",
+    "coprocessor", "condition_failed", "flag_latency"
+};
+
+static uint32_t flat[TIMING_COSTS] = {
+    1, 0, 0, 1, 1, 0, 0, 1, 1, 0, 1, 0, 1, 0, 0, 0, 1, 1, 1, 1, 1, 0
+};
+
+/* Pipeline refill of 2 cycles on PC writes, 1 cycle of load result latency (2
+ * for bytes and halfwords), one cycle per transferred register for multiple
+ * transfers and an early terminating multiplier taking one more cycle per
+ * significant byte of the multiplier operand. Flags set by a multiply are
+ * available one cycle late.
+ */
+#define ARM9E_COSTS { 1, 1, 2, 1, 1, 1, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 2, 1, 3, 1, 1, 1 }
+
+static uint32_t arm9e[TIMING_COSTS] = ARM9E_COSTS;
+static uint32_t costs[TIMING_COSTS] = ARM9E_COSTS;
+static int latencies = 1;
+int timing_charged = 1;
+static int refills = 1;
+
+static int timing_load_file(char *filename) {
+    char line[128], name[64];
+    unsigned value;
+    int i, number = 0;
+    FILE *f;
+
+    f = fopen(filename, "r");
+    if (f == NULL)
+        return -1;
+    while (fgets(line, sizeof(line), f)) {
+        number++;
+        if ((sscanf(line, " %63s", name) != 1) || (name[0] == '#'))
+            continue;
+        for (i = 0; (i < TIMING_COSTS) && strcmp(name, cost_names[i]); i++);
+        /* Base costs, those of the flat table, take at least one cycle */
+        if ((i == TIMING_COSTS) || (sscanf(line, " %*s %u", &value) != 1) ||
+            (value < flat[i])) {
+            fprintf(stderr, "%s:%d: invalid timing cost %s", filename, number, line);
+            fclose(f);
+            return -1;
+        }
+        costs[i] = value;
+    }
+    fclose(f);
+    return 0;
+}
+
+int timing_select(char *name) {
+    int result = 0;
+
+    if (strcmp(name, "flat") == 0) {
+        memcpy(costs, flat, sizeof(costs));
+    } else {
+        memcpy(costs, arm9e, sizeof(costs));
+        /* A table that cannot be read or has an invalid line is dropped as a
+         * whole, the arm9e costs stay in place
+         */
+        if ((strcmp(name, "arm9e") != 0) && ((result = timing_load_file(name)) == -1))
+            memcpy(costs, arm9e, sizeof(costs));
+    }
+    timing_charged = memcmp(costs, flat, sizeof(costs)) != 0;
+    return result;
+}
+
+uint32_t timing_get(int cost) {
+    return costs[cost];
+}
+
+void timing_charge_latencies(int charge) {
+    latencies = charge;
+}
+
+void timing_charge_refills(int charge) {
+    refills = charge;
+}
+
+int timing_refills_charged() {
+    return refills;
+}
+
+static uint32_t timing_latency(int cost) {
+    return latencies ? costs[cost] : 0;
+}
+
+/* Number of significant bytes of the multiplier, for early termination */
+static uint32_t timing_multiplier_bytes(uint32_t value) {
+    uint32_t bytes = 1;
+
+    if (get_bit(value, 31))
+        value = ~value;
+    while ((bytes < 4) && (value >> (8 * bytes)))
+        bytes++;
+    return bytes;
+}
+
+uint32_t timing_cycles(arm_core p, int executed) {
+    uint32_t ins = p->current_instruction, cycles;
+    uint32_t refill = refills ? costs[TIMING_PC_WRITE] : 0;
+    int pc_written;
+
+    if (!executed)
+        return costs[TIMING_CONDITION_FAILED];
+    pc_written = registers_read(p->reg, 15, registers_get_mode(p->reg)) != p->current_address + 4;
+    if (get_bits(ins, 31, 28) == 0xF)
+        return costs[TIMING_BRANCH] + refill;
+    switch (get_bits(ins, 27, 25)) {
+    case 0b000:
+        if ((ins & 0x0FFFFFD0) == 0x012FFF10)
+            return costs[TIMING_BRANCH] + refill;
+        if ((ins & 0x0F0000F0) == 0x00000090) {
+            cycles = costs[TIMING_MULTIPLY] + costs[TIMING_MULTIPLY_STEP] *
+                (timing_multiplier_bytes(registers_read(p->reg, get_bits(ins, 11, 8),
+                                                        registers_get_mode(p->reg))) - 1);
+            if (get_bit(ins, 23))
+                cycles += costs[TIMING_MULTIPLY_LONG];
+            if (get_bit(ins, 21))
+                cycles += costs[TIMING_MULTIPLY_ACCUMULATE];
+            return cycles;
+        }
+        if ((ins & 0x0FB00FF0) == 0x01000090)
+            return costs[TIMING_SWAP];
+        if (get_bit(ins, 7) && get_bit(ins, 4)) {
+            if (!get_bit(ins, 20))
+                return costs[TIMING_STORE];
+            return costs[TIMING_LOAD] + timing_latency(TIMING_LOAD_SUB_WORD_LATENCY) +
+                (pc_written ? refill : 0);
+        }
+        if ((ins & 0x0F9000F0) == 0x01000000)
+            return costs[TIMING_STATUS_REGISTER];
+        /* Fall through */
+    case 0b001:
+        if ((ins & 0x0FB00000) == 0x03200000)
+            return costs[TIMING_STATUS_REGISTER];
+        cycles = costs[TIMING_DATA_PROCESSING];
+        if (!get_bit(ins, 25) && get_bit(ins, 4))
+            cycles += costs[TIMING_REGISTER_SHIFT];
+        if (pc_written)
+            cycles += refill;
+        return cycles;
+    case 0b010:
+    case 0b011:
+        if (!get_bit(ins, 20))
+            return costs[TIMING_STORE];
+        return costs[TIMING_LOAD] + (pc_written ? refill : 0) +
+            timing_latency(get_bit(ins, 22) ? TIMING_LOAD_SUB_WORD_LATENCY : TIMING_LOAD_LATENCY);
+    case 0b100:
+        if (!get_bit(ins, 20))
+            return costs[TIMING_STORE_MULTIPLE] +
+                costs[TIMING_STORE_MULTIPLE_REGISTER] * __builtin_popcount(get_bits(ins, 15, 0));
+        return costs[TIMING_LOAD_MULTIPLE] + timing_latency(TIMING_LOAD_LATENCY) +
+            costs[TIMING_LOAD_MULTIPLE_REGISTER] * __builtin_popcount(get_bits(ins, 15, 0)) +
+            (pc_written ? refill : 0);
+    case 0b101:
+        return costs[TIMING_BRANCH] + refill;
+    default:
+        if (get_bits(ins, 27, 24) == 0xF)
+            return costs[TIMING_SWI];
+        return costs[TIMING_COPROCESSOR];
+    }
+}
+
+void timing_charge_instruction(arm_core p, int executed) {
+    uint32_t cycles = timing_cycles(p, executed);
+
+    p->cycle_count += cycles ? cycles - 1 : 0;
+}
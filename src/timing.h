@@ -0,0 +1,87 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __TIMING_H__
+#define __TIMING_H__
+#include <stdint.h>
+#include "arm_core.h"
+
+/* Timing model of the cycle count : the cost of each executed instruction
+ * depends on its class, according to a table of costs. Builtin tables are
+ * "flat" (one cycle per instruction) and "arm9e" (the default, close to an
+ * ARM9E core), any other name is a file of "name cycles" lines (and '#'
+ * comments) overriding the arm9e costs. When such a file cannot be read or
+ * holds an invalid line (including a zero base cost, which would make an
+ * instruction take no cycle at all), timing_select returns -1 and the arm9e
+ * costs are selected.
+ */
+#define TIMING_DATA_PROCESSING 0
+#define TIMING_REGISTER_SHIFT 1
+#define TIMING_PC_WRITE 2
+#define TIMING_BRANCH 3
+#define TIMING_LOAD 4
+#define TIMING_LOAD_LATENCY 5
+#define TIMING_LOAD_SUB_WORD_LATENCY 6
+#define TIMING_STORE 7
+#define TIMING_LOAD_MULTIPLE 8
+#define TIMING_LOAD_MULTIPLE_REGISTER 9
+#define TIMING_STORE_MULTIPLE 10
+#define TIMING_STORE_MULTIPLE_REGISTER 11
+#define TIMING_MULTIPLY 12
+#define TIMING_MULTIPLY_STEP 13
+#define TIMING_MULTIPLY_LONG 14
+#define TIMING_MULTIPLY_ACCUMULATE 15
+#define TIMING_SWAP 16
+#define TIMING_STATUS_REGISTER 17
+#define TIMING_SWI 18
+#define TIMING_COPROCESSOR 19
+#define TIMING_CONDITION_FAILED 20
+#define TIMING_FLAG_LATENCY 21
+#define TIMING_COSTS 22
+
+int timing_select(char *name);
+uint32_t timing_get(int cost);
+/* Load latencies are part of the cost of loads unless an interlock model
+ * (see pipeline.h) charges them only when the loaded value is used too early
+ */
+void timing_charge_latencies(int charge);
+/* Likewise, refills after PC writes are charged unless a branch predictor
+ * model (see branch_predictor.h) only charges mispredictions
+ */
+void timing_charge_refills(int charge);
+int timing_refills_charged();
+
+/* Cycles taken by the last fetched instruction, executed or skipped because
+ * its condition failed
+ */
+uint32_t timing_cycles(arm_core p, int executed);
+/* Charges these cycles to the cycle count, the fetch having counted one.
+ * timing_charged is zero when the costs are those of the flat table, every
+ * instruction then takes the fetch cycle only and the test inline is all
+ * that timing_instruction costs.
+ */
+extern int timing_charged;
+void timing_charge_instruction(arm_core p, int executed);
+#define timing_instruction(p, executed) \
+    do { if (timing_charged) timing_charge_instruction(p, executed); } while (0)
+
+#endif
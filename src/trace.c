@@ -21,10 +21,18 @@ Contact: Guillaume.Huard@imag.fr
 	 38401 Saint Martin d'Hres
 */
 #include <string.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <inttypes.h>
 #include "trace.h"
+#include "counters.h"
 #include "arm_constants.h"
+#include "host_stats.h"
+#include "self_profile.h"
 
 static FILE *output;
+/* Bytes of the records written, and of those lost on write errors */
+static uint64_t bytes_written = 0, bytes_dropped = 0;
 /* "Randomly" chosen last address, if the first memory access is 4 bytes after
  * this address, the access will be misinterpreted as sequential. But as the
  * first instruction at reset fetches from 0x0, no problem.
@@ -39,6 +47,22 @@ static uint8_t states[32] =
     { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
     0
 };
+/* Delta state tracing : when state_delta_interval is not 0, only one state
+ * record out of state_delta_interval is a full snapshot, the others only
+ * contain the registers that changed since the previous record
+ */
+static uint32_t state_delta_interval = 0;
+static uint32_t state_records = 0;
+static uint32_t last_state[32][18];
+/* Keyframes : every keyframe_interval cycles, the full register state is
+ * dumped into the trace and its offset is recorded, so that the index written
+ * by trace_finish lets a reader jump close to any cycle (see trace_reader.h)
+ */
+static uint32_t keyframe_interval = 0;
+static uint64_t next_keyframe = 0;
+static struct trace_index_entry *keyframes = NULL;
+static long keyframes_number = 0;
+static long keyframes_size = 0;
 
 #ifdef ARM_TRACE_FORMAT
 static char *trace_memory_seq[] = { "N", "S" };
@@ -56,6 +80,31 @@ void set_trace_file(FILE *f) {
     output = f;
 }
 
+void trace_add_counters() {
+    counters_add("trace_bytes", "state=\"written\"", "Bytes of trace records", COUNTER,
+                 &bytes_written);
+    counters_add("trace_bytes", "state=\"dropped\"", "Bytes of trace records", COUNTER,
+                 &bytes_dropped);
+}
+
+static void trace_printf(const char *format, ...) {
+    va_list arguments, copy;
+    int length;
+
+    va_start(arguments, format);
+    va_copy(copy, arguments);
+    length = vfprintf(output, format, arguments);
+    if (length >= 0) {
+        bytes_written += length;
+    } else {
+        length = vsnprintf(NULL, 0, format, copy);
+        if (length > 0)
+            bytes_dropped += length;
+    }
+    va_end(copy);
+    va_end(arguments);
+}
+
 void trace_start_location(char *file, int line) {
     if (enabled) {
         location_stack_top++;
@@ -75,74 +124,199 @@ uint8_t trace_end_location() {
 static void trace_print_location() {
     if (enabled && (trace_flags & POSITION)) {
         if (location_stack_top >= 0) {
-            fprintf(output, "%s, %d: ", location_file_stack[location_stack_top],
-                    location_line_stack[location_stack_top]);
+            trace_printf("%s, %d: ", location_file_stack[location_stack_top],
+                         location_line_stack[location_stack_top]);
         }
     }
 }
 #endif
 
-void trace_memory(uint32_t cycle, uint8_t type, uint8_t size,
+void trace_memory(uint64_t cycle, uint8_t type, uint8_t size,
                   uint8_t cause, uint32_t address, uint32_t value) {
     if (enabled && (trace_flags & MEMORY)) {
         uint8_t seq;
+        int activity = host_stats_switch(HOST_STATS_TRACING);
+        int profiled = self_profile_enter(SELF_PROFILE_TRACE);
 
         seq = (address == last_address + 4) ? 1 : 0;
         last_address = address;
 #ifdef ARM_TRACE_FORMAT
-        fprintf(output, "M%s%s%d%s__ %08X %08X\n", trace_memory_seq[seq],
-                trace_memory_type[type], size, trace_memory_cause[cause], address, value);
+        trace_printf("M%s%s%d%s__ %08X %08X\n", trace_memory_seq[seq],
+                     trace_memory_type[type], size, trace_memory_cause[cause], address, value);
 #else
         trace_print_location();
-        fprintf(output,
-                "Cycle %d, Mem %s%s (%d bytes%s) addr: %08X, val: %08X\n",
-                cycle, trace_memory_seq[seq], trace_memory_type[type], size,
-                trace_memory_cause[cause], address, value);
+        trace_printf("Cycle %" PRIu64 ", Mem %s%s (%d bytes%s) addr: %08X, val: %08X\n",
+                     cycle, trace_memory_seq[seq], trace_memory_type[type], size,
+                     trace_memory_cause[cause], address, value);
 #endif
+        self_profile_leave(profiled);
+        host_stats_switch(activity);
     }
 }
 
-void trace_register(uint32_t cycle, uint8_t type, uint8_t reg, uint8_t mode, uint32_t value) {
+void trace_register(uint64_t cycle, uint8_t type, uint8_t reg, uint8_t mode, uint32_t value) {
     if (enabled && (trace_flags & REGISTERS)) {
         char mode_name[5] = "";
+        int activity = host_stats_switch(HOST_STATS_TRACING);
+        int profiled = self_profile_enter(SELF_PROFILE_TRACE);
+
         if (arm_get_mode_name(mode)) {
             strcpy(mode_name, "_");
             strcat(mode_name, arm_get_mode_name(mode));
         }
 #ifdef ARM_TRACE_FORMAT
-        fprintf(output, "R%s %s%s %08X\n",
-                trace_register_type[type], arm_get_register_name(reg), mode_name, value);
+        trace_printf("R%s %s%s %08X\n",
+                     trace_register_type[type], arm_get_register_name(reg), mode_name, value);
 #else
         trace_print_location();
-        fprintf(output, "Cycle %d, Register %s, %s%s, val: %08X\n",
-                cycle, trace_register_type[type], arm_get_register_name(reg), mode_name, value);
+        trace_printf("Cycle %" PRIu64 ", Register %s, %s%s, val: %08X\n", cycle,
+                     trace_register_type[type], arm_get_register_name(reg), mode_name, value);
 #endif
+        self_profile_leave(profiled);
+        host_stats_switch(activity);
+    }
+}
+
+/* USR and SYS have no SPSR, it is traced as 0 to keep records alike */
+static void trace_read_mode_state(registers r, int mode, uint32_t *values) {
+    int reg;
+
+    for (reg = 0; reg < 16; reg++)
+        values[reg] = registers_read(r, reg, mode);
+    values[CPSR] = registers_read_cpsr(r);
+    if ((mode != USR) && (mode != SYS))
+        values[SPSR] = registers_read_spsr(r, mode);
+    else
+        values[SPSR] = 0;
+}
+
+static void trace_mode_state(registers r, int mode) {
+    uint32_t values[18];
+    int reg, count;
+
+    trace_read_mode_state(r, mode, values);
+    trace_printf("%s:", arm_get_mode_name(mode));
+    count = 0;
+    for (reg = 0; reg < 16; reg++) {
+        if ((count > 0) && (count % 5 == 0))
+            trace_printf("\n    ");
+        count++;
+        trace_printf("   %3s=%08X", arm_get_register_name(reg), values[reg]);
+    }
+    trace_printf("   CPSR=%08X", values[CPSR]);
+    trace_printf("   SPSR=%08X", values[SPSR]);
+    trace_printf("\n");
+    memcpy(last_state[mode], values, sizeof(values));
+}
+
+/* Only the registers that changed since the previous record of the mode, on
+ * a line starting with the mode name followed by '~' and omitted when nothing
+ * changed
+ */
+static void trace_mode_state_delta(registers r, int mode) {
+    uint32_t values[18];
+    int reg, count;
+
+    trace_read_mode_state(r, mode, values);
+    count = 0;
+    for (reg = 0; reg < 18; reg++) {
+        if (values[reg] != last_state[mode][reg]) {
+            if (count == 0)
+                trace_printf("%s~:", arm_get_mode_name(mode));
+            else if (count % 5 == 0)
+                trace_printf("\n    ");
+            count++;
+            trace_printf("   %3s=%08X", arm_get_register_name(reg), values[reg]);
+        }
     }
+    if (count > 0)
+        trace_printf("\n");
+    memcpy(last_state[mode], values, sizeof(values));
 }
 
 void trace_arm_state(registers r) {
-    int mode, reg, count;
+    int mode, full, activity, profiled;
 
     if (enabled && (trace_flags & STATE)) {
+        activity = host_stats_switch(HOST_STATS_TRACING);
+        profiled = self_profile_enter(SELF_PROFILE_TRACE);
+        full = (state_delta_interval == 0) || (state_records % state_delta_interval == 0);
+        state_records++;
         for (mode = 0; mode < 32; mode++) {
             if (arm_get_mode_name(mode) && states[mode]) {
-                fprintf(output, "%s:", arm_get_mode_name(mode));
-                count = 0;
-                for (reg = 0; reg < 16; reg++) {
-                    if ((count > 0) && (count % 5 == 0))
-                        fprintf(output, "\n    ");
-                    count++;
-                    fprintf(output, "   %3s=%08X", arm_get_register_name(reg),
-                            registers_read(r, reg, mode));
-                }
-                fprintf(output, "   CPSR=%08X", registers_read_cpsr(r));
-                fprintf(output, "   SPSR=%08X", registers_read_spsr(r, mode));
-                fprintf(output, "\n");
+                if (full)
+                    trace_mode_state(r, mode);
+                else
+                    trace_mode_state_delta(r, mode);
             }
         }
+        self_profile_leave(profiled);
+        host_stats_switch(activity);
     }
 }
 
+void trace_set_state_delta_interval(uint32_t interval) {
+    state_delta_interval = interval;
+}
+
+void trace_set_keyframe_interval(uint32_t interval) {
+    keyframe_interval = interval;
+    next_keyframe = interval;
+}
+
+void trace_keyframe(uint64_t cycle, registers r) {
+    long offset;
+    int mode, activity, profiled;
+
+    if (!enabled || (keyframe_interval == 0) || (cycle < next_keyframe))
+        return;
+    activity = host_stats_switch(HOST_STATS_TRACING);
+    profiled = self_profile_enter(SELF_PROFILE_TRACE);
+    next_keyframe = cycle + keyframe_interval;
+    offset = ftell(output);
+    /* Not a regular file (pipe, terminal), there is no way to index it */
+    if (offset == -1) {
+        self_profile_leave(profiled);
+        host_stats_switch(activity);
+        return;
+    }
+    if (keyframes_number == keyframes_size) {
+        keyframes_size = keyframes_size ? 2 * keyframes_size : 1024;
+        keyframes = realloc(keyframes, keyframes_size * sizeof(struct trace_index_entry));
+        if (keyframes == NULL) {
+            fprintf(stderr, "Cannot allocate the trace index\n");
+            exit(1);
+        }
+    }
+    keyframes[keyframes_number].cycle = cycle;
+    keyframes[keyframes_number].offset = offset;
+    keyframes_number++;
+    trace_printf("%s%" PRIu64 "\n", TRACE_KEYFRAME_TAG, cycle);
+    /* SYS shares all its registers with USR */
+    for (mode = 0; mode < 32; mode++) {
+        if (arm_get_mode_name(mode) && (mode != SYS))
+            trace_mode_state(r, mode);
+    }
+    self_profile_leave(profiled);
+    host_stats_switch(activity);
+}
+
+void trace_finish() {
+    long offset, i;
+
+    if (keyframes_number > 0) {
+        offset = ftell(output);
+        for (i = 0; i < keyframes_number; i++)
+            trace_printf("%s%" PRIu64 " %ld\n", TRACE_INDEX_TAG, keyframes[i].cycle,
+                         keyframes[i].offset);
+        trace_printf(TRACE_FOOTER_FORMAT, offset, keyframes_number);
+        free(keyframes);
+        keyframes = NULL;
+        keyframes_number = keyframes_size = 0;
+    }
+    fflush(output);
+}
+
 void trace_disable() {
     enabled = 0;
 }
@@ -151,6 +325,21 @@ void trace_enable() {
     enabled = 1;
 }
 
+void trace_remove(int flags) {
+    int mode;
+
+    if (flags < 32) {
+        if (flags >= 0) {
+            states[flags] = 0;
+            for (mode = 0; (mode < 32) && !states[mode]; mode++);
+            if (mode == 32)
+                trace_flags &= ~STATE;
+        }
+    } else {
+        trace_flags &= ~flags;
+    }
+}
+
 void trace_add(int flags) {
     if (flags < 32) {
         if (flags >= 0) {
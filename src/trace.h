@@ -40,15 +40,38 @@ Contact: Guillaume.Huard@imag.fr
 #define STATE     128
 #define POSITION  256
 
+/* Keyframes and index of seekable traces : a keyframe line is followed by the
+ * full register state, the index is a list of (cycle, offset) lines written at
+ * the end of the trace and the fixed size footer gives the offset of the index
+ * and its number of entries.
+ */
+#define TRACE_KEYFRAME_TAG "Keyframe cycle "
+#define TRACE_INDEX_TAG "Index "
+#define TRACE_FOOTER_FORMAT "Trace index: %016lX %016lX\n"
+#define TRACE_FOOTER_SIZE 47
+
+struct trace_index_entry {
+    uint64_t cycle;
+    long offset;
+};
+
 void set_trace_file(FILE * f);
+/* Registers the counters of the bytes written to the trace, or dropped */
+void trace_add_counters();
 void trace_start_location(char *file, int line);
 uint8_t trace_end_location();
-void trace_memory(uint32_t cycle, uint8_t type, uint8_t size,
+void trace_memory(uint64_t cycle, uint8_t type, uint8_t size,
 									uint8_t cause, uint32_t address, uint32_t value);
-void trace_register(uint32_t cycle, uint8_t type, uint8_t reg, uint8_t mode, uint32_t value);
+void trace_register(uint64_t cycle, uint8_t type, uint8_t reg, uint8_t mode, uint32_t value);
 void trace_arm_state(registers r);
+void trace_set_state_delta_interval(uint32_t interval);
+void trace_set_keyframe_interval(uint32_t interval);
+void trace_keyframe(uint64_t cycle, registers r);
+void trace_finish();
 void trace_disable();
 void trace_enable();
 void trace_add(int flags);
+/* Opposite of trace_add, the state is no more traced once no mode is left */
+void trace_remove(int flags);
 
 #endif
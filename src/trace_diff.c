@@ -0,0 +1,189 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+/* Compares two traces and reports their first divergent record (line) along
+ * with its context. Traces are compared by large blocks using memcmp, which is
+ * vectorized by the C library, so that matching parts are skipped quickly ;
+ * lines are only counted in matching blocks, using memchr.
+ */
+#define BLOCK_SIZE (1 << 20)
+#define CHUNK_SIZE 64
+
+struct trace_file {
+    char *name;
+    FILE *file;
+    char *block;
+    size_t size;
+};
+
+static long line_number = 0;
+static long *line_starts;
+static int ring_size;
+
+void usage(char *name) {
+    fprintf(stderr, "Usage:\n"
+            "%s [ --help ] [ --context lines ] trace1 trace2\n\n"
+            "Compares two traces and prints their first divergent record with "
+            "the given number of lines of context (3 by default). Exits with 0 "
+            "when the traces are identical, 1 when they differ and 2 on error.\n",
+            name);
+}
+
+static void count_lines(char *block, size_t size, long base) {
+    char *position = block, *end = block + size;
+
+    while ((position = memchr(position, '\n', end - position)) != NULL) {
+        position++;
+        line_number++;
+        line_starts[line_number % ring_size] = base + (position - block);
+    }
+}
+
+static size_t first_difference(char *a, char *b, size_t size) {
+    size_t position = 0, chunk;
+
+    while (position < size) {
+        chunk = size - position < CHUNK_SIZE ? size - position : CHUNK_SIZE;
+        if (memcmp(a + position, b + position, chunk) != 0)
+            break;
+        position += chunk;
+    }
+    while ((position < size) && (a[position] == b[position]))
+        position++;
+    return position;
+}
+
+static void print_lines(struct trace_file *t, long offset, long first, long count,
+                        char *prefix) {
+    char *line = NULL;
+    size_t line_size = 0;
+
+    fseek(t->file, offset, SEEK_SET);
+    while (count-- && (getline(&line, &line_size, t->file) != -1)) {
+        printf("%s%ld: %s", prefix, first++, line);
+        if (line[strlen(line) - 1] != '\n')
+            printf("\n");
+    }
+    if (count >= 0)
+        printf("%s(end of %s)\n", prefix, t->name);
+    free(line);
+}
+
+static void report(struct trace_file *t1, struct trace_file *t2, long offset, int context) {
+    long first = line_number - context;
+    long start;
+
+    if (first < 0)
+        first = 0;
+    start = line_starts[first % ring_size];
+    printf("--- %s\n+++ %s\n", t1->name, t2->name);
+    printf("First difference at line %ld (byte %ld)\n", line_number + 1, offset);
+    print_lines(t1, start, first + 1, line_number - first, "  ");
+    start = line_starts[line_number % ring_size];
+    print_lines(t1, start, line_number + 1, context + 1, "- ");
+    print_lines(t2, start, line_number + 1, context + 1, "+ ");
+}
+
+static int compare(struct trace_file *t, int context) {
+    size_t common, position;
+    long offset = 0;
+    int i;
+
+    while (1) {
+        for (i = 0; i < 2; i++) {
+            t[i].size = fread(t[i].block, 1, BLOCK_SIZE, t[i].file);
+            if (ferror(t[i].file)) {
+                perror(t[i].name);
+                return 2;
+            }
+        }
+        common = t[0].size < t[1].size ? t[0].size : t[1].size;
+        if ((t[0].size == t[1].size) && (memcmp(t[0].block, t[1].block, common) == 0)) {
+            if (common == 0)
+                return 0;
+            count_lines(t[0].block, common, offset);
+            offset += common;
+        } else {
+            position = first_difference(t[0].block, t[1].block, common);
+            count_lines(t[0].block, position, offset);
+            report(&t[0], &t[1], offset + position, context);
+            return 1;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    struct option longopts[] = {
+        { "context", required_argument, NULL, 'c' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    struct trace_file t[2];
+    int context = 3, opt, i, result;
+
+    while ((opt = getopt_long(argc, argv, "c:h", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'c':
+            context = atoi(optarg);
+            if (context < 0)
+                context = 0;
+            break;
+        case 'h':
+            usage(argv[0]);
+            exit(0);
+        default:
+            usage(argv[0]);
+            exit(2);
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        exit(2);
+    }
+    for (i = 0; i < 2; i++) {
+        t[i].name = argv[optind + i];
+        t[i].file = fopen(t[i].name, "r");
+        t[i].block = malloc(BLOCK_SIZE);
+        if ((t[i].file == NULL) || (t[i].block == NULL)) {
+            perror(t[i].name);
+            exit(2);
+        }
+    }
+    ring_size = context + 1;
+    line_starts = calloc(ring_size, sizeof(long));
+    if (line_starts == NULL) {
+        perror("Line offsets");
+        exit(2);
+    }
+    result = compare(t, context);
+    for (i = 0; i < 2; i++) {
+        fclose(t[i].file);
+        free(t[i].block);
+    }
+    free(line_starts);
+    return result;
+}
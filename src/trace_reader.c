@@ -0,0 +1,169 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <string.h>
+#include <inttypes.h>
+#include "trace_reader.h"
+
+struct trace_reader_data {
+    FILE *file;
+    struct trace_index_entry *index;
+    long index_size;
+    long end;
+    char *line;
+    size_t line_size;
+    uint64_t cycle;
+    int pending;
+};
+
+static void trace_reader_load_index(trace_reader t) {
+    char footer[TRACE_FOOTER_SIZE + 1];
+    long offset, size, i;
+
+    if ((t->end < TRACE_FOOTER_SIZE) ||
+        (fseek(t->file, t->end - TRACE_FOOTER_SIZE, SEEK_SET) == -1) ||
+        (fread(footer, 1, TRACE_FOOTER_SIZE, t->file) != TRACE_FOOTER_SIZE))
+        return;
+    footer[TRACE_FOOTER_SIZE] = '\0';
+    if (sscanf(footer, "Trace index: %lX %lX", &offset, &size) != 2)
+        return;
+    /* A damaged footer must not lead to a huge allocation : the index lines,
+     * of at least "Index 0 0\n", are between offset and the footer
+     */
+    if ((size < 0) || (offset < 0) || (offset >= t->end - TRACE_FOOTER_SIZE) ||
+        (size > (t->end - TRACE_FOOTER_SIZE - offset) / (long) (strlen(TRACE_INDEX_TAG) + 4)))
+        return;
+    t->index = malloc(size * sizeof(struct trace_index_entry));
+    if ((t->index == NULL) || (fseek(t->file, offset, SEEK_SET) == -1)) {
+        free(t->index);
+        t->index = NULL;
+        return;
+    }
+    for (i = 0; i < size; i++) {
+        if ((getline(&t->line, &t->line_size, t->file) == -1) ||
+            (sscanf(t->line, TRACE_INDEX_TAG "%" SCNu64 " %ld", &t->index[i].cycle,
+                    &t->index[i].offset) != 2)) {
+            free(t->index);
+            t->index = NULL;
+            return;
+        }
+    }
+    t->index_size = size;
+    t->end = offset;
+}
+
+trace_reader trace_reader_open(char *filename) {
+    trace_reader t;
+
+    t = malloc(sizeof(struct trace_reader_data));
+    if (t == NULL)
+        return NULL;
+    t->file = fopen(filename, "r");
+    if (t->file == NULL) {
+        free(t);
+        return NULL;
+    }
+    t->index = NULL;
+    t->index_size = 0;
+    t->line = NULL;
+    t->line_size = 0;
+    t->cycle = 0;
+    t->pending = 0;
+    fseek(t->file, 0, SEEK_END);
+    t->end = ftell(t->file);
+    trace_reader_load_index(t);
+    rewind(t->file);
+    return t;
+}
+
+void trace_reader_close(trace_reader t) {
+    fclose(t->file);
+    free(t->index);
+    free(t->line);
+    free(t);
+}
+
+int trace_reader_is_indexed(trace_reader t) {
+    return t->index != NULL;
+}
+
+static int trace_reader_line_cycle(char *line, uint64_t *cycle) {
+    char *position;
+
+    if (strncmp(line, TRACE_KEYFRAME_TAG, strlen(TRACE_KEYFRAME_TAG)) == 0)
+        return sscanf(line + strlen(TRACE_KEYFRAME_TAG), "%" SCNu64, cycle) == 1;
+    position = strstr(line, "Cycle ");
+    if (position)
+        return sscanf(position + strlen("Cycle "), "%" SCNu64, cycle) == 1;
+    return 0;
+}
+
+static char *trace_reader_read_line(trace_reader t) {
+    if ((ftell(t->file) >= t->end) || (getline(&t->line, &t->line_size, t->file) == -1))
+        return NULL;
+    trace_reader_line_cycle(t->line, &t->cycle);
+    return t->line;
+}
+
+int trace_reader_seek(trace_reader t, uint64_t cycle) {
+    long begin = 0, end = t->index_size, middle;
+    long offset = 0;
+
+    /* Last keyframe strictly before the requested cycle : the records of a
+     * cycle are written before the keyframe taken at the end of this cycle
+     */
+    while (begin < end) {
+        middle = (begin + end) >> 1;
+        if (t->index[middle].cycle < cycle)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    if (begin > 0)
+        offset = t->index[begin - 1].offset;
+    if (fseek(t->file, offset, SEEK_SET) == -1)
+        return -1;
+    t->cycle = 0;
+    t->pending = 0;
+    while (trace_reader_read_line(t) != NULL) {
+        if (t->cycle >= cycle) {
+            t->pending = 1;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+char *trace_reader_next(trace_reader t, uint64_t *cycle) {
+    char *line;
+
+    if (t->pending) {
+        t->pending = 0;
+        line = t->line;
+    } else {
+        line = trace_reader_read_line(t);
+    }
+    if (line && cycle)
+        *cycle = t->cycle;
+    return line;
+}
@@ -0,0 +1,51 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#ifndef __TRACE_READER_H__
+#define __TRACE_READER_H__
+#include <stdint.h>
+#include "trace.h"
+
+/* Reader for the traces produced by the trace module. When the trace has been
+ * written with keyframes, its footer index is used to jump directly to the
+ * last keyframe preceding the requested cycle, otherwise the trace is scanned
+ * from its beginning.
+ * Lines without cycle number (state dumps, ARM_TRACE_FORMAT records) are
+ * attributed to the last cycle seen.
+ */
+typedef struct trace_reader_data *trace_reader;
+
+trace_reader trace_reader_open(char *filename);
+void trace_reader_close(trace_reader t);
+int trace_reader_is_indexed(trace_reader t);
+
+/* Positions the reader on the first record of a cycle greater or equal to
+ * the given one. Returns 0 on success and -1 if there is no such record.
+ */
+int trace_reader_seek(trace_reader t, uint64_t cycle);
+
+/* Returns the next record (including its newline) and stores its cycle, NULL
+ * at the end of the trace. The returned line is owned by the reader.
+ */
+char *trace_reader_next(trace_reader t, uint64_t * cycle);
+
+#endif
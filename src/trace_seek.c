@@ -0,0 +1,81 @@
+/*
+Armator - simulateur de jeu d'instruction ARMv5T � but p�dagogique
+Copyright (C) 2011 Guillaume Huard
+Ce programme est libre, vous pouvez le redistribuer et/ou le modifier selon les
+termes de la Licence Publique G�n�rale GNU publi�e par la Free Software
+Foundation (version 2 ou bien toute autre version ult�rieure choisie par vous).
+
+Ce programme est distribu� car potentiellement utile, mais SANS AUCUNE
+GARANTIE, ni explicite ni implicite, y compris les garanties de
+commercialisation ou d'adaptation dans un but sp�cifique. Reportez-vous � la
+Licence Publique G�n�rale GNU pour plus de d�tails.
+
+Vous devez avoir re�u une copie de la Licence Publique G�n�rale GNU en m�me
+temps que ce programme ; si ce n'est pas le cas, �crivez � la Free Software
+Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307,
+�tats-Unis.
+
+Contact: Guillaume.Huard@imag.fr
+	 B�timent IMAG
+	 700 avenue centrale, domaine universitaire
+	 38401 Saint Martin d'H�res
+*/
+#include <stdlib.h>
+#include <getopt.h>
+#include "trace_reader.h"
+
+void usage(char *name) {
+    fprintf(stderr, "Usage:\n"
+            "%s [ --help ] [ --count records ] trace_file cycle\n\n"
+            "Prints the records of a trace produced by arm_simulator starting at "
+            "the given cycle (20 records by default). Traces written with "
+            "--trace-keyframes are accessed through their index, other traces "
+            "are scanned sequentially.\n", name);
+}
+
+int main(int argc, char *argv[]) {
+    struct option longopts[] = {
+        { "count", required_argument, NULL, 'n' },
+        { "help", no_argument, NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    trace_reader t;
+    long count = 20;
+    uint64_t cycle;
+    char *line;
+    int opt;
+
+    while ((opt = getopt_long(argc, argv, "n:h", longopts, NULL)) != -1) {
+        switch (opt) {
+        case 'n':
+            count = atol(optarg);
+            break;
+        case 'h':
+            usage(argv[0]);
+            exit(0);
+        default:
+            usage(argv[0]);
+            exit(1);
+        }
+    }
+    if (argc - optind != 2) {
+        usage(argv[0]);
+        exit(1);
+    }
+    t = trace_reader_open(argv[optind]);
+    if (t == NULL) {
+        perror("Trace file");
+        exit(1);
+    }
+    if (!trace_reader_is_indexed(t))
+        fprintf(stderr, "Trace not indexed, scanning it from its beginning\n");
+    if (trace_reader_seek(t, strtoull(argv[optind + 1], NULL, 0)) == -1) {
+        fprintf(stderr, "No record at or after cycle %s\n", argv[optind + 1]);
+        trace_reader_close(t);
+        exit(1);
+    }
+    while (count-- && ((line = trace_reader_next(t, &cycle)) != NULL))
+        fputs(line, stdout);
+    trace_reader_close(t);
+    return 0;
+}